@@ -27,6 +27,8 @@
 #include "Application.h"
 #include "CustomAction.h"
 #include "FileManager.h"
+#include "IOService.h"
+#include "MetadataCache.h"
 #include "StringUtilities.h"
 #include "SystemProperties.h"
 #include "NotificationStore.h"
@@ -59,7 +61,12 @@ ServiceStatus Application::Start(intptr_t handle)
     return status;
 }
 
-void Application::Stop() {}
+void Application::Stop()
+{
+    // The workers must have been joined before the plugin is unloaded.
+    IOService::Instance().Stop();
+    MetadataCache::Instance().Save();
+}
 
 bool Application::OnCustomAction(const int32_t id)
 {
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "AtomicFileWriter.h"
+#include "DirectoryCache.h"
+
+namespace ultraschall { namespace reaper {
+
+#ifdef _WIN32
+static const UnicodeStringView LINE_BREAK = "\r\n";
+#else
+static const UnicodeStringView LINE_BREAK = "\n";
+#endif // #ifdef _WIN32
+
+AtomicFileWriter::AtomicFileWriter(const UnicodeString& targetName, const FILE_SYNC_POLICY syncPolicy) :
+    targetName_(targetName), tempName_(targetName + ".ultraschall-write"), syncPolicy_(syncPolicy)
+{
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+AtomicFileWriter::~AtomicFileWriter()
+{
+    if(file_.is_open() == true)
+    {
+        file_.close();
+        std::remove(U2H(tempName_).c_str());
+    }
+}
+
+void AtomicFileWriter::Write(const UnicodeStringView& str)
+{
+    if((buffer_.size() + str.size()) > BUFFER_SIZE)
+    {
+        Flush();
+    }
+
+    if(str.size() > BUFFER_SIZE)
+    {
+        WriteFile(str);
+    }
+    else
+    {
+        buffer_.append(str.data(), str.size());
+    }
+}
+
+void AtomicFileWriter::Write(const UnicodeChar c)
+{
+    if(buffer_.size() >= BUFFER_SIZE)
+    {
+        Flush();
+    }
+
+    buffer_.push_back(c);
+}
+
+void AtomicFileWriter::WriteLine(const UnicodeStringView& str)
+{
+    Write(str);
+    Write(LINE_BREAK);
+}
+
+void AtomicFileWriter::Flush()
+{
+    WriteFile(buffer_);
+    buffer_.clear();
+}
+
+void AtomicFileWriter::WriteFile(const UnicodeStringView& str)
+{
+    PRECONDITION(targetName_.empty() == false);
+    PRECONDITION(false == committed_);
+
+    if((false == failed_) && (file_.is_open() == false))
+    {
+        file_.open(U2H(tempName_), std::ios::out | std::ios::trunc | std::ios::binary);
+        failed_ = (file_.is_open() == false);
+    }
+
+    if(false == failed_)
+    {
+        file_.write(str.data(), str.size());
+        failed_ = file_.fail();
+    }
+}
+
+bool AtomicFileWriter::Commit()
+{
+    PRECONDITION_RETURN(targetName_.empty() == false, false);
+    PRECONDITION_RETURN(false == committed_, false);
+
+    bool success = false;
+
+    Flush();
+    committed_ = true;
+
+    if(file_.is_open() == true)
+    {
+        file_.close();
+        success = (false == failed_) && (file_.fail() == false) && PlatformGateway::SyncFile(tempName_, syncPolicy_)
+                  && PlatformGateway::RenameFile(tempName_, targetName_);
+        if(false == success)
+        {
+            std::remove(U2H(tempName_).c_str());
+        }
+    }
+
+    DirectoryCache::Instance().Invalidate(targetName_);
+
+    return success;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_ATOMIC_FILE_WRITER_H_INCL__
+#define __ULTRASCHALL_REAPER_ATOMIC_FILE_WRITER_H_INCL__
+
+#include "Common.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+// Collects the contents of a file in memory and writes them to a sibling of the target. The target is only replaced
+// by Commit(), a crash before leaves the original file untouched. Contents that haven't been committed are discarded
+// when the writer is destroyed. Large contents are written to the sibling in chunks of BUFFER_SIZE, blocks larger than
+// BUFFER_SIZE are written without copying them.
+class AtomicFileWriter
+{
+public:
+    AtomicFileWriter(const UnicodeString& targetName, const FILE_SYNC_POLICY syncPolicy = FILE_SYNC_POLICY::DATA);
+    ~AtomicFileWriter();
+
+    void Write(const UnicodeStringView& str);
+    void Write(const UnicodeChar c);
+
+    // Terminates the line with the line break of the platform.
+    void WriteLine(const UnicodeStringView& str);
+
+    bool Commit();
+
+private:
+    AtomicFileWriter(const AtomicFileWriter&) = delete;
+    AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+    static const size_t BUFFER_SIZE = 1024 * 1024;
+
+    void Flush();
+    void WriteFile(const UnicodeStringView& str);
+
+    const UnicodeString    targetName_;
+    const UnicodeString    tempName_;
+    const FILE_SYNC_POLICY syncPolicy_;
+
+    UnicodeString buffer_;
+    std::ofstream file_;
+    bool          failed_    = false;
+    bool          committed_ = false;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_ATOMIC_FILE_WRITER_H_INCL__
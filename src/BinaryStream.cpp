@@ -50,7 +50,7 @@ const uint8_t* BinaryStream::Data() const
 bool BinaryStream::Write(const size_t offset, const uint8_t* buffer, const size_t bufferSize)
 {
     PRECONDITION_RETURN(data_ != nullptr, false);
-    PRECONDITION_RETURN((offset + bufferSize) <= dataSize_, false);
+    PRECONDITION_RETURN((offset <= dataSize_) && (bufferSize <= (dataSize_ - offset)), false);
     PRECONDITION_RETURN(buffer != nullptr, false);
 
     const size_t itemSize = sizeof(uint8_t);
@@ -60,12 +60,12 @@ bool BinaryStream::Write(const size_t offset, const uint8_t* buffer, const size_
 
 bool BinaryStream::Read(const size_t offset, uint8_t* buffer, const size_t bufferSize)
 {
-    PRECONDITION_RETURN(data_ != nullptr, false);
-    PRECONDITION_RETURN((offset + bufferSize) < dataSize_, false);
+    PRECONDITION_RETURN(Data() != nullptr, false);
+    PRECONDITION_RETURN((offset <= DataSize()) && (bufferSize <= (DataSize() - offset)), false);
     PRECONDITION_RETURN(buffer != nullptr, false);
 
     const size_t itemSize = sizeof(uint8_t);
-    memmove(buffer, &data_[offset * itemSize], bufferSize * itemSize);
+    memmove(buffer, &Data()[offset * itemSize], bufferSize * itemSize);
     return true;
 }
 
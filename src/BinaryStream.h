@@ -39,15 +39,17 @@ class BinaryStream : public SharedObject
 
     BinaryStream(const size_t dataSize);
 
-    size_t DataSize() const;
+    virtual size_t DataSize() const;
 
-    const uint8_t* Data() const;
+    virtual const uint8_t* Data() const;
 
-    bool Write(const size_t offset, const uint8_t* buffer, const size_t bufferSize);
+    virtual bool Write(const size_t offset, const uint8_t* buffer, const size_t bufferSize);
 
     bool Read(const size_t offset, uint8_t* buffer, const size_t bufferSize);
 
 protected:
+    BinaryStream() = default;
+
     virtual ~BinaryStream();
 
 private:
@@ -0,0 +1,519 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <charconv>
+
+#include "ChapterExporter.h"
+#include "AtomicFileWriter.h"
+#include "FileManager.h"
+#include "StringUtilities.h"
+
+namespace ultraschall { namespace reaper {
+
+#ifdef _WIN32
+static const UnicodeStringView LINE_BREAK = "\r\n";
+#else
+static const UnicodeStringView LINE_BREAK = "\n";
+#endif // #ifdef _WIN32
+
+static const UnicodeStringView FILE_EXTENSIONS[] = {".chapters.txt", ".psc", ".chapters.json", ".chapters.vtt", ".cue"};
+
+static size_t FormatIndex(const ChapterExporter::FORMAT format)
+{
+    size_t index = 0;
+    while((index < (sizeof(FILE_EXTENSIONS) / sizeof(FILE_EXTENSIONS[0]))) && ((format & (1u << index)) == 0))
+    {
+        index++;
+    }
+
+    return index;
+}
+
+static void AppendNumber(UnicodeString& buffer, const uint64_t value, const size_t width = 0)
+{
+    char                       digits[24] = {0};
+    const std::to_chars_result result     = std::to_chars(digits, digits + sizeof(digits), value);
+    const size_t               digitCount = result.ptr - digits;
+    if(digitCount < width)
+    {
+        buffer.append(width - digitCount, '0');
+    }
+
+    buffer.append(digits, digitCount);
+}
+
+static uint64_t SecondsToMilliseconds(const double seconds)
+{
+    return (seconds > 0) ? (uint64_t)(seconds * (double)1000) : 0;
+}
+
+static void AppendXMLText(UnicodeString& buffer, const UnicodeStringView& str)
+{
+    for(const char c : str)
+    {
+        switch(c)
+        {
+            case '&':
+                buffer += "&amp;";
+                break;
+            case '<':
+                buffer += "&lt;";
+                break;
+            case '>':
+                buffer += "&gt;";
+                break;
+            case '"':
+                buffer += "&quot;";
+                break;
+            case '\'':
+                buffer += "&apos;";
+                break;
+            default:
+                buffer += c;
+                break;
+        }
+    }
+}
+
+static void AppendJSONString(UnicodeString& buffer, const UnicodeStringView& str)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    buffer += '"';
+    for(const char c : str)
+    {
+        if((c == '"') || (c == '\\'))
+        {
+            buffer += '\\';
+            buffer += c;
+        }
+        else if((unsigned char)c < 0x20)
+        {
+            buffer += "\\u00";
+            buffer += HEX_DIGITS[(c >> 4) & 0x0f];
+            buffer += HEX_DIGITS[c & 0x0f];
+        }
+        else
+        {
+            buffer += c;
+        }
+    }
+
+    buffer += '"';
+}
+
+// Cue payloads must not contain '-->' and use the same character references as HTML.
+static void AppendWebVTTText(UnicodeString& buffer, const UnicodeStringView& str)
+{
+    for(const char c : str)
+    {
+        switch(c)
+        {
+            case '&':
+                buffer += "&amp;";
+                break;
+            case '<':
+                buffer += "&lt;";
+                break;
+            case '>':
+                buffer += "&gt;";
+                break;
+            case '\r':
+            case '\n':
+                buffer += ' ';
+                break;
+            default:
+                buffer += c;
+                break;
+        }
+    }
+}
+
+// mp4chaps titles run to the end of the line.
+static void AppendLineText(UnicodeString& buffer, const UnicodeStringView& str)
+{
+    for(const char c : str)
+    {
+        buffer += ((c == '\r') || (c == '\n')) ? ' ' : c;
+    }
+}
+
+// CUE sheets have no escape sequences, quoted strings end at the next '"' and at the end of the line.
+static void AppendCUEText(UnicodeString& buffer, const UnicodeStringView& str)
+{
+    for(const char c : str)
+    {
+        switch(c)
+        {
+            case '"':
+                buffer += '\'';
+                break;
+            case '\r':
+            case '\n':
+                buffer += ' ';
+                break;
+            default:
+                buffer += c;
+                break;
+        }
+    }
+}
+
+struct MP4ChapsSerializer
+{
+    static const size_t HEADER_SIZE  = 0;
+    static const size_t CHAPTER_SIZE = 16;
+
+    static void WriteHeader(UnicodeString&, const UnicodeString&) {}
+
+    static void WriteChapter(
+        UnicodeString& buffer, const ChapterTag& chapter, const size_t, const TimestampText& start,
+        const TimestampText&)
+    {
+        buffer += start.View();
+        buffer += ' ';
+        AppendLineText(buffer, chapter.Title());
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteFooter(UnicodeString&) {}
+};
+
+struct PSCSerializer
+{
+    static const size_t HEADER_SIZE  = 160;
+    static const size_t CHAPTER_SIZE = 80;
+
+    static void WriteHeader(UnicodeString& buffer, const UnicodeString&)
+    {
+        buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+        buffer += LINE_BREAK;
+        buffer += "<psc:chapters version=\"1.2\" xmlns:psc=\"http://podlove.org/simple-chapters\">";
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteChapter(
+        UnicodeString& buffer, const ChapterTag& chapter, const size_t, const TimestampText& start,
+        const TimestampText&)
+    {
+        buffer += "  <psc:chapter start=\"";
+        buffer += start.View();
+        buffer += "\" title=\"";
+        AppendXMLText(buffer, chapter.Title());
+        buffer += '"';
+        if(chapter.Url().empty() == false)
+        {
+            buffer += " href=\"";
+            AppendXMLText(buffer, chapter.Url());
+            buffer += '"';
+        }
+
+        if(chapter.Image().empty() == false)
+        {
+            buffer += " image=\"";
+            AppendXMLText(buffer, chapter.Image());
+            buffer += '"';
+        }
+
+        buffer += "/>";
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteFooter(UnicodeString& buffer)
+    {
+        buffer += "</psc:chapters>";
+        buffer += LINE_BREAK;
+    }
+};
+
+struct JSONSerializer
+{
+    static const size_t HEADER_SIZE  = 64;
+    static const size_t CHAPTER_SIZE = 64;
+
+    static void WriteHeader(UnicodeString& buffer, const UnicodeString&)
+    {
+        buffer += "{";
+        buffer += LINE_BREAK;
+        buffer += "  \"version\": \"1.2.0\",";
+        buffer += LINE_BREAK;
+        buffer += "  \"chapters\": [";
+    }
+
+    static void WriteChapter(
+        UnicodeString& buffer, const ChapterTag& chapter, const size_t index, const TimestampText&,
+        const TimestampText&)
+    {
+        if(index > 0)
+        {
+            buffer += ',';
+        }
+
+        buffer += LINE_BREAK;
+
+        const uint64_t milliseconds = SecondsToMilliseconds(chapter.Position());
+        buffer += "    {\"startTime\": ";
+        AppendNumber(buffer, milliseconds / 1000);
+        buffer += '.';
+        AppendNumber(buffer, milliseconds % 1000, 3);
+        buffer += ", \"title\": ";
+        AppendJSONString(buffer, chapter.Title());
+        if(chapter.Image().empty() == false)
+        {
+            buffer += ", \"img\": ";
+            AppendJSONString(buffer, chapter.Image());
+        }
+
+        if(chapter.Url().empty() == false)
+        {
+            buffer += ", \"url\": ";
+            AppendJSONString(buffer, chapter.Url());
+        }
+
+        buffer += '}';
+    }
+
+    static void WriteFooter(UnicodeString& buffer)
+    {
+        buffer += LINE_BREAK;
+        buffer += "  ]";
+        buffer += LINE_BREAK;
+        buffer += "}";
+        buffer += LINE_BREAK;
+    }
+};
+
+struct WebVTTSerializer
+{
+    static const size_t HEADER_SIZE  = 16;
+    static const size_t CHAPTER_SIZE = 48;
+
+    static void WriteHeader(UnicodeString& buffer, const UnicodeString&)
+    {
+        buffer += "WEBVTT";
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteChapter(
+        UnicodeString& buffer, const ChapterTag& chapter, const size_t index, const TimestampText& start,
+        const TimestampText& end)
+    {
+        buffer += LINE_BREAK;
+        AppendNumber(buffer, index + 1);
+        buffer += LINE_BREAK;
+        buffer += start.View();
+        buffer += " --> ";
+        buffer += end.View();
+        buffer += LINE_BREAK;
+        AppendWebVTTText(buffer, chapter.Title());
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteFooter(UnicodeString&) {}
+};
+
+struct CUESerializer
+{
+    static const size_t HEADER_SIZE  = 64;
+    static const size_t CHAPTER_SIZE = 64;
+
+    // The sheet refers to the MP3 file with the same base name.
+    static void WriteHeader(UnicodeString& buffer, const UnicodeString& targetName)
+    {
+        const UnicodeString     fileName = FileManager::StripPath(targetName);
+        const UnicodeStringView baseName = UnicodeStringView(fileName).substr(0, fileName.rfind('.'));
+        buffer += "FILE \"";
+        AppendCUEText(buffer, baseName);
+        buffer += ".mp3\" MP3";
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteChapter(
+        UnicodeString& buffer, const ChapterTag& chapter, const size_t index, const TimestampText&,
+        const TimestampText&)
+    {
+        static const uint64_t FRAMES_PER_SECOND = 75;
+
+        const uint64_t milliseconds = SecondsToMilliseconds(chapter.Position());
+        buffer += "  TRACK ";
+        AppendNumber(buffer, index + 1, 2);
+        buffer += " AUDIO";
+        buffer += LINE_BREAK;
+        buffer += "    TITLE \"";
+        AppendCUEText(buffer, chapter.Title());
+        buffer += '"';
+        buffer += LINE_BREAK;
+        buffer += "    INDEX 01 ";
+        AppendNumber(buffer, milliseconds / (1000 * 60), 2);
+        buffer += ':';
+        AppendNumber(buffer, (milliseconds / 1000) % 60, 2);
+        buffer += ':';
+        AppendNumber(buffer, ((milliseconds % 1000) * FRAMES_PER_SECOND) / 1000, 2);
+        buffer += LINE_BREAK;
+    }
+
+    static void WriteFooter(UnicodeString&) {}
+};
+
+template<class SerializerPolicy> class ChapterSerializer
+{
+public:
+    ChapterSerializer(const UnicodeString& targetName, const size_t chapterCount, const size_t textSize) :
+        targetName_(targetName)
+    {
+        if(IsEnabled() == true)
+        {
+            buffer_.reserve(SerializerPolicy::HEADER_SIZE + (chapterCount * SerializerPolicy::CHAPTER_SIZE) + textSize);
+            SerializerPolicy::WriteHeader(buffer_, targetName_);
+        }
+    }
+
+    inline bool IsEnabled() const
+    {
+        return targetName_.empty() == false;
+    }
+
+    inline void
+    Write(const ChapterTag& chapter, const size_t index, const TimestampText& start, const TimestampText& end)
+    {
+        if(IsEnabled() == true)
+        {
+            SerializerPolicy::WriteChapter(buffer_, chapter, index, start, end);
+        }
+    }
+
+    bool Commit()
+    {
+        PRECONDITION_RETURN(IsEnabled() == true, true);
+
+        SerializerPolicy::WriteFooter(buffer_);
+
+        AtomicFileWriter writer(targetName_);
+        writer.Write(buffer_);
+        return writer.Commit();
+    }
+
+private:
+    const UnicodeString& targetName_;
+    UnicodeString        buffer_;
+};
+
+UnicodeString ChapterExporter::FileName(const UnicodeString& baseName, const FORMAT format)
+{
+    PRECONDITION_RETURN(baseName.empty() == false, UnicodeString());
+
+    const size_t formatIndex = FormatIndex(format);
+    PRECONDITION_RETURN(formatIndex < MAX_FORMATS, UnicodeString());
+
+    return baseName + UnicodeString(FILE_EXTENSIONS[formatIndex]);
+}
+
+bool ChapterExporter::Export(
+    const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString& baseName,
+    const uint32_t formats)
+{
+    PRECONDITION_RETURN(baseName.empty() == false, false);
+    PRECONDITION_RETURN((formats & ALL_FORMATS) != 0, false);
+
+    UnicodeString targetNames[MAX_FORMATS];
+    for(size_t i = 0; i < MAX_FORMATS; i++)
+    {
+        if((formats & (1u << i)) != 0)
+        {
+            targetNames[i] = FileName(baseName, static_cast<FORMAT>(1u << i));
+        }
+    }
+
+    return Export(chapterMarkers, endPosition, targetNames);
+}
+
+bool ChapterExporter::ExportFile(
+    const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString& targetName,
+    const FORMAT format)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN((format & (format - 1)) == 0, false);
+
+    const size_t formatIndex = FormatIndex(format);
+    PRECONDITION_RETURN(formatIndex < MAX_FORMATS, false);
+
+    UnicodeString targetNames[MAX_FORMATS];
+    targetNames[formatIndex] = targetName;
+
+    return Export(chapterMarkers, endPosition, targetNames);
+}
+
+bool ChapterExporter::Export(
+    const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString* targetNames)
+{
+    PRECONDITION_RETURN(targetNames != nullptr, false);
+
+    const size_t chapterCount = chapterMarkers.size();
+
+    std::vector<double> positions(chapterCount + 1);
+    size_t              textSize = 0;
+    for(size_t i = 0; i < chapterCount; i++)
+    {
+        const ChapterTag& chapter = chapterMarkers[i];
+        positions[i]              = chapter.Position();
+        textSize += chapter.Title().size() + chapter.Image().size() + chapter.Url().size();
+    }
+
+    positions[chapterCount] = (chapterCount > 0) ? std::max(endPosition, positions[chapterCount - 1]) : endPosition;
+
+    // Every timestamp is formatted once for all formats, a chapter ends where the next one starts.
+    std::vector<TimestampText> timestamps(positions.size());
+    SecondsToTimestamps(positions.data(), positions.size(), timestamps.data());
+
+    ChapterSerializer<MP4ChapsSerializer> mp4chaps(targetNames[FormatIndex(MP4CHAPS)], chapterCount, textSize);
+    ChapterSerializer<PSCSerializer>      psc(targetNames[FormatIndex(PSC)], chapterCount, textSize);
+    ChapterSerializer<JSONSerializer>     json(targetNames[FormatIndex(JSON)], chapterCount, textSize);
+    ChapterSerializer<WebVTTSerializer>   webvtt(targetNames[FormatIndex(WEBVTT)], chapterCount, textSize);
+    ChapterSerializer<CUESerializer>      cue(targetNames[FormatIndex(CUE)], chapterCount, textSize);
+
+    for(size_t i = 0; i < chapterCount; i++)
+    {
+        const ChapterTag&    chapter = chapterMarkers[i];
+        const TimestampText& start   = timestamps[i];
+        const TimestampText& end     = timestamps[i + 1];
+
+        mp4chaps.Write(chapter, i, start, end);
+        psc.Write(chapter, i, start, end);
+        json.Write(chapter, i, start, end);
+        webvtt.Write(chapter, i, start, end);
+        cue.Write(chapter, i, start, end);
+    }
+
+    bool success = mp4chaps.Commit();
+    success      = (psc.Commit() == true) && (success == true);
+    success      = (json.Commit() == true) && (success == true);
+    success      = (webvtt.Commit() == true) && (success == true);
+    success      = (cue.Commit() == true) && (success == true);
+
+    return success;
+}
+
+}} // namespace ultraschall::reaper
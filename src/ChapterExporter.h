@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_CHAPTER_EXPORTER_H_INCL__
+#define __ULTRASCHALL_REAPER_CHAPTER_EXPORTER_H_INCL__
+
+#include "Common.h"
+#include "ChapterTag.h"
+
+namespace ultraschall { namespace reaper {
+
+// Writes chapter markers in several formats at once. The chapters are visited once and every chapter is appended to
+// the buffers of all selected formats. The buffers are reserved up front and committed through AtomicFileWriter.
+class ChapterExporter
+{
+public:
+    enum FORMAT : uint32_t
+    {
+        MP4CHAPS    = 0x01,
+        PSC         = 0x02,
+        JSON        = 0x04,
+        WEBVTT      = 0x08,
+        CUE         = 0x10,
+        ALL_FORMATS = MP4CHAPS | PSC | JSON | WEBVTT | CUE
+    };
+
+    // Appends the file extension of the format to baseName, e.g. 'Episode.chapters.txt' for mp4chaps.
+    static UnicodeString FileName(const UnicodeString& baseName, const FORMAT format);
+
+    // Writes every format in formats to the file derived from baseName. The end position closes the last chapter in
+    // formats that need an end time.
+    static bool Export(
+        const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString& baseName,
+        const uint32_t formats);
+
+    // Writes a single format to targetName.
+    static bool ExportFile(
+        const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString& targetName,
+        const FORMAT format);
+
+private:
+    static const size_t MAX_FORMATS = 5;
+
+    static bool Export(
+        const ChapterTagArray& chapterMarkers, const double endPosition, const UnicodeString* targetNames);
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_CHAPTER_EXPORTER_H_INCL__
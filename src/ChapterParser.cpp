@@ -0,0 +1,1196 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <charconv>
+
+#include "ChapterParser.h"
+#include "FileManager.h"
+#include "StringUtilities.h"
+
+namespace ultraschall { namespace reaper {
+
+static bool IsBlank(const char c)
+{
+    return (c == ' ') || (c == '\t');
+}
+
+static bool IsWhitespace(const char c)
+{
+    return (IsBlank(c) == true) || (c == '\r') || (c == '\n');
+}
+
+static bool IsDigit(const char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+static UnicodeStringView TrimBlanks(const UnicodeStringView& str)
+{
+    size_t start = 0;
+    while((start < str.size()) && (IsBlank(str[start]) == true))
+    {
+        start++;
+    }
+
+    size_t end = str.size();
+    while((end > start) && (IsBlank(str[end - 1]) == true))
+    {
+        end--;
+    }
+
+    return str.substr(start, end - start);
+}
+
+static bool StartsWith(const UnicodeStringView& str, const UnicodeStringView& prefix)
+{
+    return (str.size() >= prefix.size()) && (str.compare(0, prefix.size(), prefix) == 0);
+}
+
+static void AppendUTF8(UnicodeString& str, const uint32_t codePoint)
+{
+    if(codePoint < 0x80)
+    {
+        str += (char)codePoint;
+    }
+    else if(codePoint < 0x800)
+    {
+        str += (char)(0xc0 | (codePoint >> 6));
+        str += (char)(0x80 | (codePoint & 0x3f));
+    }
+    else if(codePoint < 0x10000)
+    {
+        str += (char)(0xe0 | (codePoint >> 12));
+        str += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+        str += (char)(0x80 | (codePoint & 0x3f));
+    }
+    else if(codePoint < 0x110000)
+    {
+        str += (char)(0xf0 | (codePoint >> 18));
+        str += (char)(0x80 | ((codePoint >> 12) & 0x3f));
+        str += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+        str += (char)(0x80 | (codePoint & 0x3f));
+    }
+}
+
+// Parses 'MM:SS:FF' with 75 frames per second. The minutes aren't limited.
+static bool ParseCueTimestamp(const UnicodeStringView& str, double& seconds)
+{
+    static const uint32_t FRAMES_PER_SECOND = 75;
+
+    const char* current = str.data();
+    const char* end     = str.data() + str.size();
+
+    uint32_t fields[3] = {0};
+    for(size_t i = 0; i < 3; i++)
+    {
+        if((i > 0) && ((current == end) || (*current++ != ':')))
+        {
+            return false;
+        }
+
+        const std::from_chars_result result = std::from_chars(current, end, fields[i]);
+        if(result.ec != std::errc())
+        {
+            return false;
+        }
+
+        current = result.ptr;
+    }
+
+    if((current != end) || (fields[1] >= 60) || (fields[2] >= FRAMES_PER_SECOND))
+    {
+        return false;
+    }
+
+    seconds = (double)((fields[0] * 60) + fields[1]) + ((double)fields[2] / (double)FRAMES_PER_SECOND);
+    return true;
+}
+
+// Parses a JSON number. Returns the end of the number or nullptr if there is none.
+static const char* ParseDecimal(const char* current, const char* end, double& value)
+{
+    bool negative = false;
+    if((current != end) && (*current == '-'))
+    {
+        negative = true;
+        current++;
+    }
+
+    uint64_t                integerPart = 0;
+    std::from_chars_result result      = std::from_chars(current, end, integerPart);
+    if(result.ec != std::errc())
+    {
+        return nullptr;
+    }
+
+    current = result.ptr;
+    value   = (double)integerPart;
+
+    if((current != end) && (*current == '.'))
+    {
+        const char* fractionStart = ++current;
+        double      scale         = 0.1;
+        while((current != end) && (IsDigit(*current) == true))
+        {
+            value += (*current - '0') * scale;
+            scale /= 10;
+            current++;
+        }
+
+        if(current == fractionStart)
+        {
+            return nullptr;
+        }
+    }
+
+    if((current != end) && ((*current == 'e') || (*current == 'E')))
+    {
+        current++;
+        if((current != end) && (*current == '+'))
+        {
+            current++;
+        }
+
+        int exponent = 0;
+        result       = std::from_chars(current, end, exponent);
+        if(result.ec != std::errc())
+        {
+            return nullptr;
+        }
+
+        current = result.ptr;
+        value *= std::pow(10.0, exponent);
+    }
+
+    if(negative == true)
+    {
+        value = -value;
+    }
+
+    return current;
+}
+
+// Parses the start of a PSC chapter, either in normal play time or in seconds.
+static bool ParseNormalPlayTime(const UnicodeStringView& str, double& seconds)
+{
+    if(str.find(':') != UnicodeStringView::npos)
+    {
+        return TimestampToSeconds(str, seconds);
+    }
+
+    const char* end = str.data() + str.size();
+    return (str.empty() == false) && (ParseDecimal(str.data(), end, seconds) == end) && (seconds >= 0);
+}
+
+static void LocateLine(const UnicodeStringView& text, const char* position, size_t& lineNumber, UnicodeStringView& line)
+{
+    const size_t offset = std::min((size_t)(position - text.data()), text.size());
+
+    lineNumber = std::count(text.begin(), text.begin() + offset, '\n') + 1;
+
+    const size_t lineStart = (offset > 0) ? text.rfind('\n', offset - 1) + 1 : 0;
+    size_t       lineEnd   = std::min(text.find('\n', offset), text.size());
+    if((lineEnd > lineStart) && (text[lineEnd - 1] == '\r'))
+    {
+        lineEnd--;
+    }
+
+    line = text.substr(lineStart, lineEnd - lineStart);
+}
+
+class JsonScanner
+{
+public:
+    JsonScanner(const UnicodeStringView& text) : current_(text.data()), end_(text.data() + text.size()) {}
+
+    // The start of the next token.
+    const char* Position()
+    {
+        SkipWhitespace();
+        return current_;
+    }
+
+    bool Consume(const char c)
+    {
+        SkipWhitespace();
+        if((current_ != end_) && (*current_ == c))
+        {
+            current_++;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Decodes a string into value. Passing nullptr skips the string.
+    bool ParseString(UnicodeString* pValue)
+    {
+        PRECONDITION_RETURN(Consume('"') == true, false);
+
+        const char* runStart = current_;
+        while(current_ != end_)
+        {
+            const char c = *current_;
+            if((c == '"') || (c == '\\'))
+            {
+                if(pValue != nullptr)
+                {
+                    pValue->append(runStart, current_ - runStart);
+                }
+
+                current_++;
+                if(c == '"')
+                {
+                    return true;
+                }
+
+                if(ParseEscapeSequence(pValue) == false)
+                {
+                    return false;
+                }
+
+                runStart = current_;
+            }
+            else if((unsigned char)c < 0x20)
+            {
+                return false;
+            }
+            else
+            {
+                current_++;
+            }
+        }
+
+        return false;
+    }
+
+    bool ParseNumber(double& value)
+    {
+        SkipWhitespace();
+
+        const char* numberEnd = ParseDecimal(current_, end_, value);
+        if(numberEnd != nullptr)
+        {
+            current_ = numberEnd;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ParseBoolean(bool& value)
+    {
+        SkipWhitespace();
+
+        if(ConsumeLiteral("true") == true)
+        {
+            value = true;
+            return true;
+        }
+
+        if(ConsumeLiteral("false") == true)
+        {
+            value = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool SkipValue(const size_t depth = 0)
+    {
+        static const size_t MAX_DEPTH = 64;
+        PRECONDITION_RETURN(depth < MAX_DEPTH, false);
+
+        SkipWhitespace();
+        PRECONDITION_RETURN(current_ != end_, false);
+
+        bool valid = true;
+        if(*current_ == '"')
+        {
+            valid = ParseString(nullptr);
+        }
+        else if(Consume('{') == true)
+        {
+            if(Consume('}') == false)
+            {
+                do
+                {
+                    valid = (ParseString(nullptr) == true) && (Consume(':') == true) && (SkipValue(depth + 1) == true);
+                } while((valid == true) && (Consume(',') == true));
+
+                valid = (valid == true) && (Consume('}') == true);
+            }
+        }
+        else if(Consume('[') == true)
+        {
+            if(Consume(']') == false)
+            {
+                do
+                {
+                    valid = SkipValue(depth + 1);
+                } while((valid == true) && (Consume(',') == true));
+
+                valid = (valid == true) && (Consume(']') == true);
+            }
+        }
+        else if((ConsumeLiteral("true") == false) && (ConsumeLiteral("false") == false)
+                && (ConsumeLiteral("null") == false))
+        {
+            double value = 0;
+            valid        = ParseNumber(value);
+        }
+
+        return valid;
+    }
+
+private:
+    const char* current_;
+    const char* end_;
+
+    void SkipWhitespace()
+    {
+        while((current_ != end_) && (IsWhitespace(*current_) == true))
+        {
+            current_++;
+        }
+    }
+
+    bool ConsumeLiteral(const UnicodeStringView& literal)
+    {
+        if(StartsWith(UnicodeStringView(current_, end_ - current_), literal) == true)
+        {
+            current_ += literal.size();
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ParseHexQuad(uint32_t& value)
+    {
+        static const size_t QUAD_SIZE = 4;
+        PRECONDITION_RETURN((size_t)(end_ - current_) >= QUAD_SIZE, false);
+
+        const std::from_chars_result result = std::from_chars(current_, current_ + QUAD_SIZE, value, 16);
+        if((result.ec != std::errc()) || (result.ptr != (current_ + QUAD_SIZE)))
+        {
+            return false;
+        }
+
+        current_ += QUAD_SIZE;
+        return true;
+    }
+
+    bool ParseEscapeSequence(UnicodeString* pValue)
+    {
+        PRECONDITION_RETURN(current_ != end_, false);
+
+        char     c         = 0;
+        uint32_t codePoint = 0;
+        switch(*current_++)
+        {
+            case '"':
+                c = '"';
+                break;
+            case '\\':
+                c = '\\';
+                break;
+            case '/':
+                c = '/';
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u':
+                if(ParseHexQuad(codePoint) == false)
+                {
+                    return false;
+                }
+
+                if((codePoint >= 0xd800) && (codePoint <= 0xdbff))
+                {
+                    uint32_t lowSurrogate = 0;
+                    if((ConsumeLiteral("\\u") == false) || (ParseHexQuad(lowSurrogate) == false)
+                       || (lowSurrogate < 0xdc00) || (lowSurrogate > 0xdfff))
+                    {
+                        return false;
+                    }
+
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (lowSurrogate - 0xdc00);
+                }
+
+                if(pValue != nullptr)
+                {
+                    AppendUTF8(*pValue, codePoint);
+                }
+
+                return true;
+            default:
+                return false;
+        }
+
+        if(pValue != nullptr)
+        {
+            *pValue += c;
+        }
+
+        return true;
+    }
+};
+
+// Decodes the predefined and numeric character references of XML attribute values and WebVTT cue payloads. References
+// that can't be decoded are kept as they are.
+static UnicodeString DecodeXMLText(const UnicodeStringView& str)
+{
+    UnicodeString result;
+    result.reserve(str.size());
+
+    size_t offset = 0;
+    while(offset < str.size())
+    {
+        const size_t referenceStart = str.find('&', offset);
+        if(referenceStart == UnicodeStringView::npos)
+        {
+            result.append(str.data() + offset, str.size() - offset);
+            break;
+        }
+
+        result.append(str.data() + offset, referenceStart - offset);
+
+        // A reference ends at the next ';', a stray '&' is copied and must not swallow the following reference.
+        const size_t referenceEnd = str.find_first_of("&; \t\r\n", referenceStart + 1);
+        if((referenceEnd == UnicodeStringView::npos) || (str[referenceEnd] != ';'))
+        {
+            result += '&';
+            offset = referenceStart + 1;
+            continue;
+        }
+
+        const UnicodeStringView reference = str.substr(referenceStart + 1, referenceEnd - referenceStart - 1);
+        if(reference == "amp")
+        {
+            result += '&';
+        }
+        else if(reference == "lt")
+        {
+            result += '<';
+        }
+        else if(reference == "gt")
+        {
+            result += '>';
+        }
+        else if(reference == "quot")
+        {
+            result += '"';
+        }
+        else if(reference == "apos")
+        {
+            result += '\'';
+        }
+        else if(StartsWith(reference, "#") == true)
+        {
+            const bool                   isHex      = StartsWith(reference, "#x") == true;
+            const char*                  digits     = reference.data() + (isHex ? 2 : 1);
+            const char*                  end        = reference.data() + reference.size();
+            uint32_t                     codePoint  = 0;
+            const std::from_chars_result conversion = std::from_chars(digits, end, codePoint, isHex ? 16 : 10);
+            if((conversion.ec == std::errc()) && (conversion.ptr == end) && (digits < end) && (codePoint > 0)
+               && (codePoint < 0x110000) && ((codePoint < 0xd800) || (codePoint > 0xdfff)))
+            {
+                AppendUTF8(result, codePoint);
+            }
+            else
+            {
+                result.append(str.data() + referenceStart, referenceEnd - referenceStart + 1);
+            }
+        }
+        else
+        {
+            result.append(str.data() + referenceStart, referenceEnd - referenceStart + 1);
+        }
+
+        offset = referenceEnd + 1;
+    }
+
+    return result;
+}
+
+enum class XML_ATTRIBUTE_STATUS
+{
+    ATTRIBUTE,
+    TAG_END,
+    SYNTAX_ERROR
+};
+
+// Reads the next attribute of a start tag. At the end of the tag, offset points behind the closing bracket.
+static XML_ATTRIBUTE_STATUS NextXMLAttribute(
+    const UnicodeStringView& text, size_t& offset, UnicodeStringView& name, UnicodeStringView& value)
+{
+    while((offset < text.size()) && (IsWhitespace(text[offset]) == true))
+    {
+        offset++;
+    }
+
+    if(StartsWith(text.substr(offset), "/>") == true)
+    {
+        offset += 2;
+        return XML_ATTRIBUTE_STATUS::TAG_END;
+    }
+
+    if(StartsWith(text.substr(offset), ">") == true)
+    {
+        offset += 1;
+        return XML_ATTRIBUTE_STATUS::TAG_END;
+    }
+
+    const size_t nameStart = offset;
+    while((offset < text.size()) && (text[offset] != '=') && (text[offset] != '>')
+          && (IsWhitespace(text[offset]) == false))
+    {
+        offset++;
+    }
+
+    name = text.substr(nameStart, offset - nameStart);
+
+    while((offset < text.size()) && (IsWhitespace(text[offset]) == true))
+    {
+        offset++;
+    }
+
+    if((name.empty() == true) || (offset >= text.size()) || (text[offset] != '='))
+    {
+        return XML_ATTRIBUTE_STATUS::SYNTAX_ERROR;
+    }
+
+    offset++;
+    while((offset < text.size()) && (IsWhitespace(text[offset]) == true))
+    {
+        offset++;
+    }
+
+    if((offset >= text.size()) || ((text[offset] != '"') && (text[offset] != '\'')))
+    {
+        return XML_ATTRIBUTE_STATUS::SYNTAX_ERROR;
+    }
+
+    const size_t valueEnd = text.find(text[offset], offset + 1);
+    if(valueEnd == UnicodeStringView::npos)
+    {
+        return XML_ATTRIBUTE_STATUS::SYNTAX_ERROR;
+    }
+
+    value  = text.substr(offset + 1, valueEnd - offset - 1);
+    offset = valueEnd + 1;
+
+    return XML_ATTRIBUTE_STATUS::ATTRIBUTE;
+}
+
+ChapterParser::ChapterParser(const UnicodeString& filename) :
+    reader_(filename), directory_(FileManager::QueryFileDirectory(filename))
+{
+    errors_.reserve(MAX_ERRORS);
+}
+
+void ChapterParser::AddError(
+    const ChapterParserError::TYPE type, const size_t lineNumber, const UnicodeStringView& line)
+{
+    if(errors_.size() < MAX_ERRORS)
+    {
+        errors_.push_back({type, lineNumber, line});
+    }
+
+    errorCount_++;
+}
+
+void ChapterParser::AddError(const ChapterParserError::TYPE type, const char* position)
+{
+    if(errors_.size() < MAX_ERRORS)
+    {
+        size_t            lineNumber = 0;
+        UnicodeStringView line;
+        LocateLine(reader_.Text(), position, lineNumber, line);
+        errors_.push_back({type, lineNumber, line});
+    }
+
+    errorCount_++;
+}
+
+// Decodes the %XX escapes of a URL path. Malformed escapes are kept literally.
+static UnicodeString DecodeURLPath(const UnicodeStringView& text)
+{
+    UnicodeString path;
+    path.reserve(text.size());
+
+    size_t offset = 0;
+    while(offset < text.size())
+    {
+        uint32_t value = 0;
+        if((text[offset] == '%') && ((offset + 2) < text.size()))
+        {
+            const char*                  digits = text.data() + offset + 1;
+            const std::from_chars_result result = std::from_chars(digits, digits + 2, value, 16);
+            if((result.ec == std::errc()) && (result.ptr == (digits + 2)))
+            {
+                path += static_cast<char>(value);
+                offset += 3;
+                continue;
+            }
+        }
+
+        path += text[offset++];
+    }
+
+    return path;
+}
+
+// PSC and JSON chapters reference images by URL. Relative references and file URLs are resolved against the
+// directory of the chapter file. Remote images are not downloaded, so they do not become chapter images.
+UnicodeString ChapterParser::ResolveImageReference(const UnicodeString& reference) const
+{
+    static const UnicodeStringView FILE_SCHEME = "file://";
+
+    UnicodeString path;
+
+    const size_t schemeEnd = reference.find(':');
+    const bool   hasScheme = (schemeEnd != UnicodeString::npos) && (schemeEnd > 1) // not a drive letter
+                           && (reference.find_first_of("/\\?#") > schemeEnd);
+    if(StartsWith(reference, FILE_SCHEME) == true)
+    {
+        path = DecodeURLPath(UnicodeStringView(reference).substr(FILE_SCHEME.size()));
+        if((path.size() > 2) && (path[0] == '/') && (path[2] == ':')) // file:///C:/...
+        {
+            path.erase(0, 1);
+        }
+    }
+    else if(hasScheme == false)
+    {
+        path = DecodeURLPath(reference);
+        if(StartsWith(path, "./") == true)
+        {
+            path.erase(0, 2);
+        }
+
+        const bool isAbsolute = (path.empty() == false)
+                                && ((path[0] == '/') || (path[0] == '\\') || ((path.size() > 1) && (path[1] == ':')));
+        if((path.empty() == false) && (isAbsolute == false))
+        {
+            path = FileManager::AppendPath(directory_, path);
+        }
+    }
+
+    return path;
+}
+
+ChapterParser::FORMAT ChapterParser::QueryFormat() const
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, FORMAT::UNKNOWN_FORMAT);
+
+    const UnicodeStringView text  = reader_.Text();
+    const size_t            start = std::min(text.find_first_not_of(" \t\r\n"), text.size());
+    const UnicodeStringView head  = text.substr(start);
+    PRECONDITION_RETURN(head.empty() == false, FORMAT::UNKNOWN_FORMAT);
+
+    FORMAT format = FORMAT::UNKNOWN_FORMAT;
+    if(StartsWith(head, "WEBVTT") == true)
+    {
+        format = FORMAT::WEBVTT;
+    }
+    else if(head[0] == '{')
+    {
+        format = FORMAT::JSON;
+    }
+    else if(head[0] == '<')
+    {
+        format = FORMAT::PSC;
+    }
+    else if(IsDigit(head[0]) == true)
+    {
+        format = FORMAT::MP4CHAPS;
+    }
+    else
+    {
+        static const UnicodeStringView CUE_COMMANDS[] = {
+            "REM", "CATALOG", "CDTEXTFILE", "FILE", "PERFORMER", "SONGWRITER", "TITLE", "TRACK"};
+
+        const UnicodeStringView command = head.substr(0, std::min(head.find_first_of(" \t\r\n"), head.size()));
+        for(size_t i = 0; (i < sizeof(CUE_COMMANDS) / sizeof(CUE_COMMANDS[0])) && (format != FORMAT::CUE); i++)
+        {
+            if(command == CUE_COMMANDS[i])
+            {
+                format = FORMAT::CUE;
+            }
+        }
+    }
+
+    return format;
+}
+
+bool ChapterParser::Parse(ChapterTagArray& chapterMarkers)
+{
+    bool result = false;
+
+    switch(QueryFormat())
+    {
+        case FORMAT::PSC:
+            result = ParsePSC(chapterMarkers);
+            break;
+        case FORMAT::JSON:
+            result = ParseJSON(chapterMarkers);
+            break;
+        case FORMAT::WEBVTT:
+            result = ParseWebVTT(chapterMarkers);
+            break;
+        case FORMAT::CUE:
+            result = ParseCUE(chapterMarkers);
+            break;
+        default:
+            result = ParseMP4Chaps(chapterMarkers);
+            break;
+    }
+
+    return result;
+}
+
+bool ChapterParser::ParseMP4Chaps(ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, false);
+
+    UnicodeStringView line;
+    while(reader_.NextLine(line) == true)
+    {
+        const UnicodeStringView text = TrimBlanks(line);
+        if(text.empty() == true)
+        {
+            continue;
+        }
+
+        if(text.size() < Globals::MIN_CHAPTER_MARKER_LINE_LENGTH)
+        {
+            AddError(ChapterParserError::TYPE::INVALID_FORMAT, reader_.LineNumber(), line);
+            continue;
+        }
+
+        const size_t timestampEnd = std::min(text.find_first_of(" \t"), text.size());
+        double       position     = 0;
+        if(TimestampToSeconds(text.substr(0, timestampEnd), position) == false)
+        {
+            AddError(ChapterParserError::TYPE::INVALID_TIMESTAMP, reader_.LineNumber(), line);
+            continue;
+        }
+
+        chapterMarkers.emplace_back(position, UnicodeString(TrimBlanks(text.substr(timestampEnd))));
+    }
+
+    return true;
+}
+
+bool ChapterParser::ParsePSC(ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, false);
+
+    const UnicodeStringView text   = reader_.Text();
+    size_t                  offset = text.find('<');
+    while(offset != UnicodeStringView::npos)
+    {
+        const UnicodeStringView markup = text.substr(offset + 1);
+        size_t                  tagEnd = UnicodeStringView::npos;
+        if(StartsWith(markup, "!--") == true)
+        {
+            tagEnd = text.find("-->", offset);
+        }
+        else if(StartsWith(markup, "![CDATA[") == true)
+        {
+            tagEnd = text.find("]]>", offset);
+        }
+        else if((StartsWith(markup, "?") == true) || (StartsWith(markup, "!") == true)
+                || (StartsWith(markup, "/") == true))
+        {
+            tagEnd = text.find('>', offset);
+        }
+        else
+        {
+            const size_t            nameSize  = std::min(markup.find_first_of(" \t\r\n/>"), markup.size());
+            const UnicodeStringView name      = markup.substr(0, nameSize);
+            const size_t            prefixEnd = name.rfind(':');
+            const bool              isChapter = name.substr(prefixEnd + 1) == "chapter";
+
+            double            position = Globals::INVALID_MARKER_POSITION;
+            bool              hasStart = false;
+            UnicodeString     title;
+            UnicodeString     image;
+            UnicodeString     url;
+            UnicodeStringView attributeName;
+            UnicodeStringView attributeValue;
+
+            size_t               attributeOffset = offset + 1 + nameSize;
+            XML_ATTRIBUTE_STATUS status = NextXMLAttribute(text, attributeOffset, attributeName, attributeValue);
+            while(status == XML_ATTRIBUTE_STATUS::ATTRIBUTE)
+            {
+                if(isChapter == true)
+                {
+                    if(attributeName == "start")
+                    {
+                        hasStart = ParseNormalPlayTime(attributeValue, position);
+                    }
+                    else if(attributeName == "title")
+                    {
+                        title = DecodeXMLText(attributeValue);
+                    }
+                    else if(attributeName == "image")
+                    {
+                        image = DecodeXMLText(attributeValue);
+                    }
+                    else if(attributeName == "href")
+                    {
+                        url = DecodeXMLText(attributeValue);
+                    }
+                }
+
+                status = NextXMLAttribute(text, attributeOffset, attributeName, attributeValue);
+            }
+
+            if(status == XML_ATTRIBUTE_STATUS::SYNTAX_ERROR)
+            {
+                AddError(ChapterParserError::TYPE::INVALID_FORMAT, text.data() + offset);
+                break;
+            }
+
+            if(isChapter == true)
+            {
+                if(hasStart == true)
+                {
+                    chapterMarkers.emplace_back(position, title, ResolveImageReference(image), url);
+                }
+                else
+                {
+                    AddError(ChapterParserError::TYPE::INVALID_TIMESTAMP, text.data() + offset);
+                }
+            }
+
+            tagEnd = attributeOffset - 1;
+        }
+
+        offset = (tagEnd != UnicodeStringView::npos) ? text.find('<', tagEnd + 1) : UnicodeStringView::npos;
+    }
+
+    return true;
+}
+
+// Reads the members of a chapter object. Unknown members are skipped.
+static bool ParseJSONChapter(JsonScanner& scanner, ChapterTag& chapter, bool& hasStartTime, bool& isListed)
+{
+    double        position = Globals::INVALID_MARKER_POSITION;
+    UnicodeString title;
+    UnicodeString image;
+    UnicodeString url;
+
+    bool valid = scanner.Consume('{');
+    if((valid == true) && (scanner.Consume('}') == false))
+    {
+        do
+        {
+            UnicodeString key;
+            valid = (scanner.ParseString(&key) == true) && (scanner.Consume(':') == true);
+            if(valid == true)
+            {
+                if(key == "startTime")
+                {
+                    valid        = scanner.ParseNumber(position);
+                    hasStartTime = (valid == true) && (position >= 0);
+                }
+                else if(key == "title")
+                {
+                    valid = scanner.ParseString(&title);
+                }
+                else if(key == "img")
+                {
+                    valid = scanner.ParseString(&image);
+                }
+                else if(key == "url")
+                {
+                    valid = scanner.ParseString(&url);
+                }
+                else if(key == "toc")
+                {
+                    valid = (scanner.ParseBoolean(isListed) == true) || (scanner.SkipValue() == true);
+                }
+                else
+                {
+                    valid = scanner.SkipValue();
+                }
+            }
+        } while((valid == true) && (scanner.Consume(',') == true));
+
+        valid = (valid == true) && (scanner.Consume('}') == true);
+    }
+
+    chapter = ChapterTag(position, title, image, url);
+    return valid;
+}
+
+bool ChapterParser::ParseJSON(ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, false);
+
+    JsonScanner scanner(reader_.Text());
+
+    bool valid = scanner.Consume('{');
+    if((valid == true) && (scanner.Consume('}') == false))
+    {
+        do
+        {
+            UnicodeString key;
+            valid = (scanner.ParseString(&key) == true) && (scanner.Consume(':') == true);
+            if((valid == true) && (key == "chapters"))
+            {
+                valid = scanner.Consume('[');
+                if((valid == true) && (scanner.Consume(']') == false))
+                {
+                    do
+                    {
+                        const char* chapterStart = scanner.Position();
+                        ChapterTag  chapter;
+                        bool        hasStartTime = false;
+                        bool        isListed     = true;
+                        valid = ParseJSONChapter(scanner, chapter, hasStartTime, isListed);
+                        // Chapters hidden from the table of contents ("toc": false) are not imported as markers.
+                        if((valid == true) && (isListed == true) && (hasStartTime == true))
+                        {
+                            chapterMarkers.emplace_back(chapter.Position(), chapter.Title(),
+                                ResolveImageReference(chapter.Image()), chapter.Url());
+                        }
+                        else if((valid == true) && (isListed == true))
+                        {
+                            AddError(ChapterParserError::TYPE::INVALID_TIMESTAMP, chapterStart);
+                        }
+                    } while((valid == true) && (scanner.Consume(',') == true));
+
+                    valid = (valid == true) && (scanner.Consume(']') == true);
+                }
+            }
+            else if(valid == true)
+            {
+                valid = scanner.SkipValue();
+            }
+        } while((valid == true) && (scanner.Consume(',') == true));
+
+        valid = (valid == true) && (scanner.Consume('}') == true);
+    }
+
+    if(valid == false)
+    {
+        AddError(ChapterParserError::TYPE::INVALID_FORMAT, scanner.Position());
+    }
+
+    return true;
+}
+
+// Removes the voice, class, styling and timestamp tags of a WebVTT cue payload line, e.g. '<v Speaker>' or '<c.x>'.
+static UnicodeString StripWebVTTTags(const UnicodeStringView& text)
+{
+    UnicodeString result;
+    result.reserve(text.size());
+
+    size_t offset = 0;
+    while(offset < text.size())
+    {
+        const size_t tagStart = text.find('<', offset);
+        const size_t tagEnd   = text.find('>', tagStart);
+        if((tagStart == UnicodeStringView::npos) || (tagEnd == UnicodeStringView::npos))
+        {
+            result.append(text.data() + offset, text.size() - offset);
+            break;
+        }
+
+        result.append(text.data() + offset, tagStart - offset);
+        offset = tagEnd + 1;
+    }
+
+    return result;
+}
+
+bool ChapterParser::ParseWebVTT(ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, false);
+
+    bool          isHeader  = true;
+    bool          isPayload = false;
+    bool          isSkipped = false;
+    double        position  = 0;
+    UnicodeString title;
+
+    UnicodeStringView line;
+    while(reader_.NextLine(line) == true)
+    {
+        const UnicodeStringView text = TrimBlanks(line);
+        if(text.empty() == true)
+        {
+            if(isPayload == true)
+            {
+                chapterMarkers.emplace_back(position, title);
+            }
+
+            isHeader  = false;
+            isPayload = false;
+            isSkipped = false;
+        }
+        else if(isPayload == true)
+        {
+            if(title.empty() == false)
+            {
+                title += ' ';
+            }
+
+            title += DecodeXMLText(StripWebVTTTags(text));
+        }
+        else if((isHeader == false) && (isSkipped == false))
+        {
+            const size_t arrow = text.find("-->");
+            if(arrow != UnicodeStringView::npos)
+            {
+                if(TimestampToSeconds(TrimBlanks(text.substr(0, arrow)), position) == true)
+                {
+                    title.clear();
+                    isPayload = true;
+                }
+                else
+                {
+                    AddError(ChapterParserError::TYPE::INVALID_TIMESTAMP, reader_.LineNumber(), line);
+                    isSkipped = true;
+                }
+            }
+            else if((StartsWith(text, "NOTE") == true) || (StartsWith(text, "STYLE") == true)
+                    || (StartsWith(text, "REGION") == true))
+            {
+                isSkipped = true;
+            }
+        }
+    }
+
+    if(isPayload == true)
+    {
+        chapterMarkers.emplace_back(position, title);
+    }
+
+    return true;
+}
+
+// Returns the value of a CUE command without the surrounding quotes.
+static UnicodeStringView UnquoteCueValue(const UnicodeStringView& value)
+{
+    if((value.size() >= 2) && (value.front() == '"'))
+    {
+        const size_t valueEnd = value.rfind('"');
+        if(valueEnd > 0)
+        {
+            return value.substr(1, valueEnd - 1);
+        }
+    }
+
+    return value;
+}
+
+bool ChapterParser::ParseCUE(ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(reader_.IsValid() == true, false);
+
+    bool              isTrack         = false;
+    bool              hasIndex        = false;
+    double            position        = 0;
+    UnicodeStringView title;
+    size_t            trackLineNumber = 0;
+    UnicodeStringView trackLine;
+
+    const auto finishTrack = [&]() {
+        if(isTrack == true)
+        {
+            if(hasIndex == true)
+            {
+                chapterMarkers.emplace_back(position, UnicodeString(title));
+            }
+            else
+            {
+                AddError(ChapterParserError::TYPE::INVALID_FORMAT, trackLineNumber, trackLine);
+            }
+        }
+    };
+
+    UnicodeStringView line;
+    while(reader_.NextLine(line) == true)
+    {
+        const UnicodeStringView text       = TrimBlanks(line);
+        const size_t            commandEnd = std::min(text.find_first_of(" \t"), text.size());
+        const UnicodeStringView command    = text.substr(0, commandEnd);
+        const UnicodeStringView value      = TrimBlanks(text.substr(commandEnd));
+        if(command == "TRACK")
+        {
+            finishTrack();
+
+            isTrack         = true;
+            hasIndex        = false;
+            title           = UnicodeStringView();
+            trackLineNumber = reader_.LineNumber();
+            trackLine       = line;
+        }
+        else if((command == "TITLE") && (isTrack == true))
+        {
+            title = UnquoteCueValue(value);
+        }
+        else if((command == "INDEX") && (isTrack == true))
+        {
+            const size_t            numberEnd = std::min(value.find_first_of(" \t"), value.size());
+            const UnicodeStringView number    = value.substr(0, numberEnd);
+            if((number == "01") || (number == "1"))
+            {
+                hasIndex = ParseCueTimestamp(TrimBlanks(value.substr(numberEnd)), position);
+                if(hasIndex == false)
+                {
+                    AddError(ChapterParserError::TYPE::INVALID_TIMESTAMP, reader_.LineNumber(), line);
+                    isTrack = false;
+                }
+            }
+        }
+    }
+
+    finishTrack();
+
+    return true;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_CHAPTER_PARSER_H_INCL__
+#define __ULTRASCHALL_REAPER_CHAPTER_PARSER_H_INCL__
+
+#include "Common.h"
+#include "ChapterTag.h"
+#include "TextFileReader.h"
+
+namespace ultraschall { namespace reaper {
+
+struct ChapterParserError
+{
+    enum class TYPE
+    {
+        INVALID_FORMAT,
+        INVALID_TIMESTAMP
+    };
+
+    TYPE              type;
+    size_t            lineNumber;
+    UnicodeStringView line;
+};
+
+typedef std::vector<ChapterParserError> ChapterParserErrorArray;
+
+// Parses chapter files in a single pass over the file contents. Errors point into the file contents and stay valid as
+// long as the parser exists. Only the first MAX_ERRORS errors are kept, the remaining ones are counted.
+class ChapterParser
+{
+public:
+    static const size_t MAX_ERRORS = 32;
+
+    enum class FORMAT
+    {
+        MP4CHAPS,
+        PSC,
+        JSON,
+        WEBVTT,
+        CUE,
+        UNKNOWN_FORMAT
+    };
+
+    ChapterParser(const UnicodeString& filename);
+
+    inline bool IsValid() const;
+
+    // Detects the format from the contents of the file instead of its extension.
+    FORMAT QueryFormat() const;
+
+    // Parses the file in the format returned by QueryFormat(). Files with an unknown format are read as mp4chaps
+    // files so that every line that can't be read is reported.
+    bool Parse(ChapterTagArray& chapterMarkers);
+
+    // Reads lines in the format 'HH:MM:SS.mmm Title'. The title is taken verbatim from the first non-blank character
+    // after the timestamp.
+    bool ParseMP4Chaps(ChapterTagArray& chapterMarkers);
+
+    // Reads the chapter elements of a Podlove Simple Chapters document. Image references are resolved against the
+    // directory of the chapter file.
+    bool ParsePSC(ChapterTagArray& chapterMarkers);
+
+    // Reads the chapters array of a Podcasting 2.0 JSON chapters document. Chapters with "toc": false are skipped.
+    bool ParseJSON(ChapterTagArray& chapterMarkers);
+
+    // Reads the cues of a WebVTT chapters track. The payload lines of a cue make up the title, tags are removed and
+    // character references are decoded.
+    bool ParseWebVTT(ChapterTagArray& chapterMarkers);
+
+    // Reads the tracks of a CUE sheet. A track starts at its INDEX 01 entry.
+    bool ParseCUE(ChapterTagArray& chapterMarkers);
+
+    inline const ChapterParserErrorArray& Errors() const;
+    inline size_t                         ErrorCount() const;
+
+private:
+    ChapterParser(const ChapterParser&) = delete;
+    ChapterParser& operator=(const ChapterParser&) = delete;
+
+    TextFileReader          reader_;
+    UnicodeString           directory_;
+    ChapterParserErrorArray errors_;
+    size_t                  errorCount_ = 0;
+
+    void AddError(const ChapterParserError::TYPE type, const size_t lineNumber, const UnicodeStringView& line);
+    void AddError(const ChapterParserError::TYPE type, const char* position);
+
+    UnicodeString ResolveImageReference(const UnicodeString& reference) const;
+};
+
+inline bool ChapterParser::IsValid() const
+{
+    return reader_.IsValid();
+}
+
+inline const ChapterParserErrorArray& ChapterParser::Errors() const
+{
+    return errors_;
+}
+
+inline size_t ChapterParser::ErrorCount() const
+{
+    return errorCount_;
+}
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_CHAPTER_PARSER_H_INCL__
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ChapterValidator.h"
+#include "FileManager.h"
+#include "Globals.h"
+
+namespace ultraschall { namespace reaper {
+
+// Chapter formats store positions in milliseconds, closer positions can't be told apart.
+static const double POSITION_RESOLUTION = 0.001;
+
+static bool IsValidUrl(const UnicodeString& url)
+{
+    return (url.compare(0, 7, "http://") == 0) || (url.compare(0, 8, "https://") == 0);
+}
+
+ChapterValidator::ChapterValidator(const double maxPosition) : maxPosition_(maxPosition) {}
+
+ChapterDiagnosticArray ChapterValidator::Validate(const ChapterTagArray& chapterMarkers) const
+{
+    ChapterDiagnosticArray diagnostics;
+
+    std::vector<size_t> order(chapterMarkers.size());
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](const size_t lhs, const size_t rhs) {
+        return chapterMarkers[lhs].Position() < chapterMarkers[rhs].Position();
+    });
+
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        const size_t      index   = order[i];
+        const ChapterTag& current = chapterMarkers[index];
+
+        if((current.Position() < 0) || (current.Position() > maxPosition_))
+        {
+            diagnostics.push_back({ChapterDiagnostic::TYPE::OUT_OF_RANGE, true, index});
+        }
+
+        if(current.Title().empty() == true)
+        {
+            diagnostics.push_back({ChapterDiagnostic::TYPE::MISSING_TITLE, true, index});
+        }
+        else if(current.Title().size() > Globals::MAX_CHAPTER_TITLE_LENGTH)
+        {
+            diagnostics.push_back({ChapterDiagnostic::TYPE::TITLE_TOO_LONG, false, index});
+        }
+
+        if(i > 0)
+        {
+            const double distance = current.Position() - chapterMarkers[order[i - 1]].Position();
+            if(distance < POSITION_RESOLUTION)
+            {
+                diagnostics.push_back({ChapterDiagnostic::TYPE::DUPLICATE_POSITION, false, index});
+            }
+            else if(distance < MIN_CHAPTER_DISTANCE)
+            {
+                diagnostics.push_back({ChapterDiagnostic::TYPE::POSITION_TOO_CLOSE, false, index});
+            }
+        }
+
+        if((current.Image().empty() == false) && (FileManager::FileExists(current.Image()) == false))
+        {
+            diagnostics.push_back({ChapterDiagnostic::TYPE::IMAGE_NOT_FOUND, false, index});
+        }
+
+        if((current.Url().empty() == false) && (IsValidUrl(current.Url()) == false))
+        {
+            diagnostics.push_back({ChapterDiagnostic::TYPE::INVALID_URL, false, index});
+        }
+    }
+
+    return diagnostics;
+}
+
+bool ChapterValidator::HasErrors(const ChapterDiagnosticArray& diagnostics)
+{
+    return std::find_if(diagnostics.begin(), diagnostics.end(), [](const ChapterDiagnostic& diagnostic) {
+               return diagnostic.isError;
+           })
+           != diagnostics.end();
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_CHAPTER_VALIDATOR_H_INCL__
+#define __ULTRASCHALL_REAPER_CHAPTER_VALIDATOR_H_INCL__
+
+#include "Common.h"
+#include "ChapterTag.h"
+
+namespace ultraschall { namespace reaper {
+
+struct ChapterDiagnostic
+{
+    enum class TYPE
+    {
+        OUT_OF_RANGE,
+        MISSING_TITLE,
+        TITLE_TOO_LONG,
+        DUPLICATE_POSITION,
+        POSITION_TOO_CLOSE,
+        IMAGE_NOT_FOUND,
+        INVALID_URL
+    };
+
+    TYPE type;
+
+    // Errors prevent the chapter markers from being used, warnings are only reported.
+    bool isError;
+
+    // The index of the chapter marker in the array that has been validated.
+    size_t index;
+};
+
+typedef std::vector<ChapterDiagnostic> ChapterDiagnosticArray;
+
+// Validates chapter markers against a snapshot of the project bounds. The markers are sorted once and checked in a
+// single pass, the project isn't queried per marker.
+class ChapterValidator
+{
+public:
+    static constexpr const double MIN_CHAPTER_DISTANCE = 1.0;
+
+    ChapterValidator(const double maxPosition);
+
+    // The diagnostics are ordered by the position of the chapter markers.
+    ChapterDiagnosticArray Validate(const ChapterTagArray& chapterMarkers) const;
+
+    static bool HasErrors(const ChapterDiagnosticArray& diagnostics);
+
+private:
+    const double maxPosition_;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_CHAPTER_VALIDATOR_H_INCL__
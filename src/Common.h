@@ -76,6 +76,10 @@
         }                         \
     }
 
+// Offsets into and sizes of files. size_t is 32 bits wide on 32-bit targets, rendered projects exceed 4 GiB.
+typedef uint64_t FileOffset;
+typedef uint64_t FileSize;
+
 #define ULTRASCHALL_VERSION "5.0.2"
 
 #endif // #ifndef __ULTRASCHALL_REAPER_COMMON_H_INCL__
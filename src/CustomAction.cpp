@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "CustomAction.h"
+#include "ChapterValidator.h"
 #include "FileManager.h"
 #include "StringUtilities.h"
 #include "NotificationStore.h"
@@ -84,33 +85,53 @@ bool CustomAction::AreChapterMarkersValid(const ChapterTagArray& markers)
 
     NotificationStore supervisor("ULTRASCHALL_CHAPTER_VALIDITY_CHECK");
 
-    size_t errorCount = 0;
-
-    for(size_t i = 0; i < markers.size(); i++)
+    const ChapterValidator       validator(CurrentProject().MaxPosition());
+    const ChapterDiagnosticArray diagnostics = validator.Validate(markers);
+    for(size_t i = 0; i < diagnostics.size(); i++)
     {
-        const ChapterTag&   current      = markers[i];
-        const UnicodeString safeName     = current.Title();
-        const double        safePosition = current.Position();
+        const ChapterDiagnostic& diagnostic = diagnostics[i];
+        const ChapterTag&        current    = markers[diagnostic.index];
+        const UnicodeString      safeName   = (current.Title().empty() == false) ? current.Title() : "Unknown";
 
-        if(CurrentProject().IsValidPosition(current.Position()) == false)
+        UnicodeStringStream os;
+        switch(diagnostic.type)
         {
-            UnicodeStringStream os;
-            os << "The chapter marker '" << ((safeName.empty() == false) ? safeName : UnicodeString("Unknown"))
-               << "' is out of track range.";
-            supervisor.RegisterError(os.str());
-            ++errorCount;
+            case ChapterDiagnostic::TYPE::OUT_OF_RANGE:
+                os << "The chapter marker '" << safeName << "' is out of track range.";
+                break;
+            case ChapterDiagnostic::TYPE::MISSING_TITLE:
+                os << "The chapter marker at '" << SecondsToString(current.Position()) << "' has no name.";
+                break;
+            case ChapterDiagnostic::TYPE::TITLE_TOO_LONG:
+                os << "The chapter marker title '" << safeName << "' is longer than "
+                   << Globals::MAX_CHAPTER_TITLE_LENGTH << " characters.";
+                break;
+            case ChapterDiagnostic::TYPE::DUPLICATE_POSITION:
+                os << "The chapter marker '" << safeName << "' has the same position as the previous chapter marker.";
+                break;
+            case ChapterDiagnostic::TYPE::POSITION_TOO_CLOSE:
+                os << "The chapter marker '" << safeName << "' is less than " << ChapterValidator::MIN_CHAPTER_DISTANCE
+                   << " second away from the previous chapter marker.";
+                break;
+            case ChapterDiagnostic::TYPE::IMAGE_NOT_FOUND:
+                os << "The image of the chapter marker '" << safeName << "' does not exist.";
+                break;
+            case ChapterDiagnostic::TYPE::INVALID_URL:
+                os << "The url of the chapter marker '" << safeName << "' is not a valid http(s) url.";
+                break;
         }
 
-        if(current.Title().empty() == true)
+        if(diagnostic.isError == true)
         {
-            UnicodeStringStream os;
-            os << "The chapter marker at '" << SecondsToString(safePosition) << "' has no name.";
             supervisor.RegisterError(os.str());
-            ++errorCount;
+        }
+        else
+        {
+            supervisor.RegisterWarning(os.str());
         }
     }
 
-    return (0 == errorCount);
+    return ChapterValidator::HasErrors(diagnostics) == false;
 }
 
 }} // namespace ultraschall::reaper
@@ -0,0 +1,242 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "DirectoryCache.h"
+#include "StringUtilities.h"
+
+namespace ultraschall { namespace reaper {
+
+DirectoryCache& DirectoryCache::Instance()
+{
+    static DirectoryCache self;
+    return self;
+}
+
+DirectoryCache::~DirectoryCache()
+{
+    Clear();
+}
+
+void DirectoryCache::Clear()
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    while(snapshots_.empty() == false)
+    {
+        Remove(snapshots_.begin());
+    }
+
+    useCount_ = 0;
+}
+
+bool DirectoryCache::SplitFileName(const UnicodeString& filename, UnicodeString& directory, UnicodeString& name)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+
+    const size_t offset = filename.find_last_of(PlatformGateway::QueryPathSeparator());
+    PRECONDITION_RETURN(offset != UnicodeString::npos, false);
+
+    directory = (offset > 0) ? filename.substr(0, offset) : filename.substr(0, 1);
+    name      = filename.substr(offset + 1);
+
+    // Names that still contain a separator can't be found in a listing of the parent directory.
+    return (name.empty() == false) && (name.find('/') == UnicodeString::npos) && (name != ".") && (name != "..");
+}
+
+void DirectoryCache::ReleaseWatch(const int64_t watch, const Snapshot* pOwner)
+{
+    PRECONDITION(watch != -1);
+
+    // Different spellings of the same directory share a single watch.
+    bool shared = false;
+    std::map<UnicodeString, Snapshot>::const_iterator i = snapshots_.begin();
+    for(; (i != snapshots_.end()) && (false == shared); i++)
+    {
+        shared = (&i->second != pOwner) && (i->second.watch == watch);
+    }
+
+    if(false == shared)
+    {
+        PlatformGateway::UnwatchDirectory(watch);
+    }
+}
+
+void DirectoryCache::Remove(std::map<UnicodeString, Snapshot>::iterator snapshotIterator)
+{
+    if(snapshotIterator->second.watch != -1)
+    {
+        ReleaseWatch(snapshotIterator->second.watch, &snapshotIterator->second);
+    }
+
+    snapshots_.erase(snapshotIterator);
+}
+
+void DirectoryCache::ProcessChanges()
+{
+    std::vector<int64_t> watches = PlatformGateway::QueryChangedDirectories();
+    std::sort(watches.begin(), watches.end());
+    watches.erase(std::unique(watches.begin(), watches.end()), watches.end());
+
+    for(size_t i = 0; i < watches.size(); i++)
+    {
+        for(std::map<UnicodeString, Snapshot>::iterator j = snapshots_.begin(); j != snapshots_.end(); j++)
+        {
+            if((watches[i] == -1) || (j->second.watch == watches[i]))
+            {
+                j->second.current = false;
+            }
+        }
+    }
+}
+
+bool DirectoryCache::Refresh(const UnicodeString& directory, Snapshot& snapshot)
+{
+    // The watch is established before the directory is listed, changes made in between invalidate the new snapshot.
+    const int64_t watch = PlatformGateway::WatchDirectory(directory);
+    if((snapshot.watch != -1) && (snapshot.watch != watch))
+    {
+        ReleaseWatch(snapshot.watch, &snapshot);
+    }
+
+    snapshot.watch   = watch;
+    snapshot.current = true;
+    snapshot.entries.clear();
+    snapshot.foldedNames.clear();
+
+    // Without a watch nobody would tell that the listing is outdated.
+    PRECONDITION_RETURN(watch != -1, false);
+
+    DirectoryEntryArray entries;
+    const bool          success = PlatformGateway::QueryDirectoryEntries(directory, entries);
+    if(true == success)
+    {
+        const bool caseSensitive = PlatformGateway::QueryCaseSensitiveFileNames();
+        for(size_t i = 0; i < entries.size(); i++)
+        {
+            if(false == caseSensitive)
+            {
+                snapshot.foldedNames.insert(std::make_pair(StringLowercase(entries[i].name), entries[i].name));
+            }
+
+            snapshot.entries.insert(std::make_pair(entries[i].name, entries[i]));
+        }
+    }
+
+    return success;
+}
+
+DirectoryCache::Snapshot* DirectoryCache::QuerySnapshot(const UnicodeString& directory)
+{
+    PRECONDITION_RETURN(directory.empty() == false, nullptr);
+
+    std::map<UnicodeString, Snapshot>::iterator snapshotIterator = snapshots_.find(directory);
+    if(snapshotIterator == snapshots_.end())
+    {
+        if(snapshots_.size() >= MAX_SNAPSHOTS)
+        {
+            std::map<UnicodeString, Snapshot>::iterator leastRecentlyUsed = snapshots_.begin();
+            for(std::map<UnicodeString, Snapshot>::iterator i = snapshots_.begin(); i != snapshots_.end(); i++)
+            {
+                if(i->second.lastUsed < leastRecentlyUsed->second.lastUsed)
+                {
+                    leastRecentlyUsed = i;
+                }
+            }
+
+            Remove(leastRecentlyUsed);
+        }
+
+        snapshotIterator = snapshots_.insert(std::make_pair(directory, Snapshot())).first;
+    }
+
+    Snapshot* pSnapshot = &snapshotIterator->second;
+    pSnapshot->lastUsed = ++useCount_;
+
+    if((pSnapshot->current == false) && (Refresh(directory, *pSnapshot) == false))
+    {
+        Remove(snapshotIterator);
+        pSnapshot = nullptr;
+    }
+
+    return pSnapshot;
+}
+
+DirectoryCache::LOOKUP_RESULT DirectoryCache::Lookup(const UnicodeString& filename, DirectoryEntry& entry)
+{
+    UnicodeString directory;
+    UnicodeString name;
+    PRECONDITION_RETURN(SplitFileName(filename, directory, name) == true, LOOKUP_RESULT::UNKNOWN);
+
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    LOOKUP_RESULT result = LOOKUP_RESULT::UNKNOWN;
+
+    ProcessChanges();
+
+    const Snapshot* pSnapshot = QuerySnapshot(directory);
+    if(pSnapshot != nullptr)
+    {
+        std::map<UnicodeString, DirectoryEntry>::const_iterator entryIterator = pSnapshot->entries.find(name);
+        if((entryIterator == pSnapshot->entries.end()) && (pSnapshot->foldedNames.empty() == false))
+        {
+            std::map<UnicodeString, UnicodeString>::const_iterator foldedIterator
+                = pSnapshot->foldedNames.find(StringLowercase(name));
+            if(foldedIterator != pSnapshot->foldedNames.end())
+            {
+                entryIterator = pSnapshot->entries.find(foldedIterator->second);
+            }
+        }
+
+        if(entryIterator != pSnapshot->entries.end())
+        {
+            entry  = entryIterator->second;
+            result = LOOKUP_RESULT::FOUND;
+        }
+        else
+        {
+            result = LOOKUP_RESULT::NOT_FOUND;
+        }
+    }
+
+    return result;
+}
+
+void DirectoryCache::Invalidate(const UnicodeString& filename)
+{
+    UnicodeString directory;
+    UnicodeString name;
+    PRECONDITION(SplitFileName(filename, directory, name) == true);
+
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    std::map<UnicodeString, Snapshot>::iterator snapshotIterator = snapshots_.find(directory);
+    if(snapshotIterator != snapshots_.end())
+    {
+        snapshotIterator->second.current = false;
+    }
+}
+
+}} // namespace ultraschall::reaper
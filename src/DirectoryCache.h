@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_DIRECTORY_CACHE_H_INCL__
+#define __ULTRASCHALL_REAPER_DIRECTORY_CACHE_H_INCL__
+
+#include "Common.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+// Process-wide cache of directory listings, used to answer existence queries without opening files. Only directories
+// that the platform can watch are cached, their snapshots are dropped as soon as a change is reported. The sizes in a
+// snapshot are hints, anything that writes to a file must query its size from the file itself.
+class DirectoryCache
+{
+public:
+    static DirectoryCache& Instance();
+
+    enum class LOOKUP_RESULT
+    {
+        FOUND,
+        NOT_FOUND,
+        UNKNOWN
+    };
+
+    LOOKUP_RESULT Lookup(const UnicodeString& filename, DirectoryEntry& entry);
+
+    // Drops the snapshot of the directory containing filename.
+    void Invalidate(const UnicodeString& filename);
+
+    void Clear();
+
+private:
+    DirectoryCache() {}
+    ~DirectoryCache();
+
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    static const size_t MAX_SNAPSHOTS = 64;
+
+    struct Snapshot
+    {
+        std::map<UnicodeString, DirectoryEntry> entries;
+        std::map<UnicodeString, UnicodeString>  foldedNames;
+        int64_t                                 watch    = -1;
+        bool                                    current  = false;
+        uint64_t                                lastUsed = 0;
+    };
+
+    static bool SplitFileName(const UnicodeString& filename, UnicodeString& directory, UnicodeString& name);
+
+    void      ReleaseWatch(const int64_t watch, const Snapshot* pOwner);
+    void      ProcessChanges();
+    Snapshot* QuerySnapshot(const UnicodeString& directory);
+    bool      Refresh(const UnicodeString& directory, Snapshot& snapshot);
+    void      Remove(std::map<UnicodeString, Snapshot>::iterator snapshotIterator);
+
+    std::map<UnicodeString, Snapshot> snapshots_;
+    uint64_t                          useCount_ = 0;
+    mutable std::recursive_mutex      cacheLock_;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_DIRECTORY_CACHE_H_INCL__
@@ -25,9 +25,14 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "Application.h"
+#include "AtomicFileWriter.h"
+#include "DirectoryCache.h"
 #include "FileManager.h"
+#include "IOService.h"
+#include "MappedBinaryStream.h"
 #include "StringUtilities.h"
 #include "PlatformGateway.h"
+#include "TextFileReader.h"
 
 namespace ultraschall { namespace reaper {
 
@@ -72,11 +77,20 @@ bool FileManager::FileExists(const UnicodeString& filename)
 
     bool fileExists = false;
 
-    std::ifstream is(U2H(filename), std::ios::in | std::ios::binary);
-    if(is.is_open() == true)
+    DirectoryEntry                      entry;
+    const DirectoryCache::LOOKUP_RESULT result = DirectoryCache::Instance().Lookup(filename, entry);
+    if(result == DirectoryCache::LOOKUP_RESULT::UNKNOWN)
     {
-        fileExists = true;
-        is.close();
+        std::ifstream is(U2H(filename), std::ios::in | std::ios::binary);
+        if(is.is_open() == true)
+        {
+            fileExists = true;
+            is.close();
+        }
+    }
+    else
+    {
+        fileExists = (result == DirectoryCache::LOOKUP_RESULT::FOUND);
     }
 
     return fileExists;
@@ -84,11 +98,11 @@ bool FileManager::FileExists(const UnicodeString& filename)
 
 size_t FileManager::FileExists(const UnicodeStringArray& paths)
 {
-    PRECONDITION_RETURN(paths.empty() == false, -1);
+    PRECONDITION_RETURN(paths.empty() == false, 0);
 
-    size_t offset = -1;
+    size_t offset = paths.size();
 
-    for(size_t i = 0; (i < paths.size()) && (offset == -1); i++)
+    for(size_t i = 0; (i < paths.size()) && (offset == paths.size()); i++)
     {
         if(FileExists(paths[i]) == true)
         {
@@ -114,21 +128,31 @@ UnicodeString FileManager::QueryFileDirectory(const UnicodeString& filename)
     return directory;
 }
 
-size_t FileManager::QueryFileSize(const UnicodeString& filename)
+ServiceStatus FileManager::QueryFileSize(const UnicodeString& filename, FileSize& fileSize)
 {
-    PRECONDITION_RETURN(filename.empty() == false, -1);
-    PRECONDITION_RETURN(FileExists(filename) == true, -1);
+    PRECONDITION_RETURN(filename.empty() == false, SERVICE_INVALID_ARGUMENT);
 
-    size_t size = -1;
+    ServiceStatus status = SERVICE_FILE_NOT_FOUND;
 
+    // The tag writers move and truncate data based on this size, it is always read from the file itself.
     std::ifstream file(U2H(filename), std::ios::in | std::ios::binary | std::ios::ate);
     if(file.is_open() == true)
     {
-        size = file.tellg();
+        const std::streamoff size = file.tellg();
+        if(size >= 0)
+        {
+            fileSize = static_cast<FileSize>(size);
+            status   = SERVICE_SUCCESS;
+        }
+        else
+        {
+            status = SERVICE_FILE_READ_FAILED;
+        }
+
         file.close();
     }
 
-    return size;
+    return status;
 }
 
 UnicodeString FileManager::NormalizeFileName(const UnicodeString& targetName)
@@ -155,6 +179,22 @@ FileManager::FILE_TYPE FileManager::QueryFileType(const UnicodeString& filename)
             {
                 type = FILE_TYPE::MP4CHAPS;
             }
+            else if((fileExtension == "psc") || (fileExtension == "xml"))
+            {
+                type = FILE_TYPE::PSC;
+            }
+            else if(fileExtension == "json")
+            {
+                type = FILE_TYPE::JSON;
+            }
+            else if(fileExtension == "vtt")
+            {
+                type = FILE_TYPE::WEBVTT;
+            }
+            else if(fileExtension == "cue")
+            {
+                type = FILE_TYPE::CUE;
+            }
             else if(fileExtension == "mp3")
             {
                 type = FILE_TYPE::MP3;
@@ -177,15 +217,14 @@ FileManager::FILE_TYPE FileManager::QueryFileType(const UnicodeString& filename)
     return type;
 }
 
-bool FileManager::IsDiskSpaceAvailable(const UnicodeString& filename, const size_t requiredBytes)
+bool FileManager::IsDiskSpaceAvailable(const UnicodeString& filename, const FileSize requiredBytes)
 {
     PRECONDITION_RETURN(filename.empty() == false, false);
-    PRECONDITION_RETURN(requiredBytes != -1, false);
 
     bool isAvailable = false;
 
-    const size_t availableSpace = PlatformGateway::QueryAvailableDiskSpace(QueryFileDirectory(filename));
-    if(availableSpace != -1)
+    FileSize availableSpace = 0;
+    if(ServiceSucceeded(PlatformGateway::QueryAvailableDiskSpace(QueryFileDirectory(filename), availableSpace)))
     {
         isAvailable = (requiredBytes <= availableSpace);
     }
@@ -193,43 +232,30 @@ bool FileManager::IsDiskSpaceAvailable(const UnicodeString& filename, const size
     return isAvailable;
 }
 
-BinaryStream* FileManager::ReadBinaryFile(const UnicodeString& filename)
+BinaryStream* FileManager::ReadBinaryFile(const UnicodeString& filename, const bool mapContents)
 {
     PRECONDITION_RETURN(filename.empty() == false, nullptr);
 
-    BinaryStream* pStream = nullptr;
+    // The contents of larger files are mapped, not copied.
+    return MappedBinaryStream::Create(filename, mapContents);
+}
 
-    const size_t fileSize = QueryFileSize(filename);
-    if(fileSize != -1)
-    {
-        std::ifstream file(U2H(filename), std::ios::in | std::ios::binary);
-        if(file.is_open() == true)
-        {
-            uint8_t* buffer = new uint8_t[fileSize];
-            if(buffer != nullptr)
-            {
-                file.read(reinterpret_cast<char*>(buffer), fileSize);
-                if(file)
-                {
-                    pStream = new BinaryStream(fileSize);
-                    if(pStream != nullptr)
-                    {
-                        const bool succeeded = pStream->Write(0, buffer, fileSize);
-                        if(succeeded == false)
-                        {
-                            SafeRelease(pStream);
-                        }
-                    }
-                }
-
-                SafeDeleteArray(buffer);
-            }
+std::future<BinaryStream*> FileManager::ReadBinaryFileAsync(const UnicodeString& filename, const bool mapContents)
+{
+    return IOService::Instance().Submit([filename, mapContents]() { return ReadBinaryFile(filename, mapContents); });
+}
 
-            file.close();
-        }
+std::vector<std::future<BinaryStream*>> FileManager::ReadBinaryFilesAsync(const UnicodeStringArray& filenames)
+{
+    std::vector<std::future<BinaryStream*>> streams;
+    streams.reserve(filenames.size());
+
+    for(size_t i = 0; i < filenames.size(); i++)
+    {
+        streams.push_back(ReadBinaryFileAsync(filenames[i]));
     }
 
-    return pStream;
+    return streams;
 }
 
 UnicodeStringArray FileManager::ReadTextFile(const UnicodeString& filename)
@@ -239,11 +265,11 @@ UnicodeStringArray FileManager::ReadTextFile(const UnicodeString& filename)
 
     UnicodeStringArray lines;
 
-    std::ifstream is(U2H(filename).c_str());
-    UnicodeString line;
-    while(std::getline(is, line))
+    TextFileReader    reader(filename);
+    UnicodeStringView line;
+    while(reader.NextLine(line) == true)
     {
-        lines.push_back(line);
+        lines.push_back(UnicodeString(line));
     }
 
     return lines;
@@ -255,17 +281,45 @@ bool FileManager::WriteTextFile(const UnicodeString& filename, const UnicodeStri
     PRECONDITION_RETURN(IsDiskSpaceAvailable(filename, str.size()) == true, false);
     PRECONDITION_RETURN(str.empty() == false, false);
 
+    AtomicFileWriter writer(filename);
+    writer.Write(str);
+    return writer.Commit();
+}
+
+bool FileManager::WriteBinaryFile(const UnicodeString& filename, BinaryStream* pStream)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(pStream != nullptr, false);
+    PRECONDITION_RETURN(IsDiskSpaceAvailable(filename, pStream->DataSize()) == true, false);
+
     bool status = false;
 
-    std::ofstream os(U2H(filename).c_str());
+    std::ofstream os(U2H(filename), std::ios::out | std::ios::binary | std::ios::trunc);
     if(os.is_open() == true)
     {
-        os << str;
+        os.write(reinterpret_cast<const char*>(pStream->Data()), pStream->DataSize());
+        status = os.good();
         os.close();
-        status = true;
     }
 
+    DirectoryCache::Instance().Invalidate(filename);
+
     return status;
 }
 
+std::future<bool> FileManager::WriteFileAsync(const UnicodeString& filename, BinaryStream* pStream)
+{
+    // The request holds a reference, the caller may release the stream right away.
+    if(pStream != nullptr)
+    {
+        pStream->AddRef();
+    }
+
+    return IOService::Instance().Submit([filename, pStream]() mutable {
+        const bool status = WriteBinaryFile(filename, pStream);
+        SafeRelease(pStream);
+        return status;
+    });
+}
+
 }} // namespace ultraschall::reaper
@@ -27,6 +27,8 @@
 #ifndef __ULTRASCHALL_REAPER_FILE_MANAGER_H_INCL__
 #define __ULTRASCHALL_REAPER_FILE_MANAGER_H_INCL__
 
+#include <future>
+
 #include "BinaryStream.h"
 #include "Common.h"
 
@@ -41,21 +43,44 @@ class FileManager
     static UnicodeString      StripPath(const UnicodeString& path);
     static UnicodeStringArray SplitPath(const UnicodeString& path);
 
-    static bool   FileExists(const UnicodeString& path);
+    static bool FileExists(const UnicodeString& path);
+
+    // Index of the first existing file, paths.size() if none of them exists
     static size_t FileExists(const UnicodeStringArray& paths);
 
     static UnicodeString QueryFileDirectory(const UnicodeString& filename);
 
-    enum class FILE_TYPE { MP4CHAPS, MP3, JPEG, PNG, UNKNOWN_FILE_TYPE, MAX_FILE_TYPE = UNKNOWN_FILE_TYPE };
+    enum class FILE_TYPE
+    {
+        MP4CHAPS,
+        PSC,
+        JSON,
+        WEBVTT,
+        CUE,
+        MP3,
+        JPEG,
+        PNG,
+        UNKNOWN_FILE_TYPE,
+        MAX_FILE_TYPE = UNKNOWN_FILE_TYPE
+    };
     static FILE_TYPE QueryFileType(const UnicodeString& filename);
 
-    static size_t QueryFileSize(const UnicodeString& filename);
-    static bool   IsDiskSpaceAvailable(const UnicodeString& filename, const size_t requiredBytes);
+    static ServiceStatus QueryFileSize(const UnicodeString& filename, FileSize& fileSize);
+    static bool          IsDiskSpaceAvailable(const UnicodeString& filename, const FileSize requiredBytes);
 
-    static BinaryStream*      ReadBinaryFile(const UnicodeString& filename);
+    // Returns nullptr if the file doesn't fit into the address space, large files have to be streamed. Streams that
+    // are kept for long must not map the file, the mapping locks it on Windows and faults if the file is truncated.
+    static BinaryStream*      ReadBinaryFile(const UnicodeString& filename, const bool mapContents = true);
     static UnicodeStringArray ReadTextFile(const UnicodeString& filename);
 
     static bool WriteTextFile(const UnicodeString& filename, const UnicodeString& str);
+    static bool WriteBinaryFile(const UnicodeString& filename, BinaryStream* pStream);
+
+    // The requests are served by IOService, the caller must release the streams returned by the futures.
+    static std::future<BinaryStream*>              ReadBinaryFileAsync(
+        const UnicodeString& filename, const bool mapContents = true);
+    static std::vector<std::future<BinaryStream*>> ReadBinaryFilesAsync(const UnicodeStringArray& filenames);
+    static std::future<bool>                       WriteFileAsync(const UnicodeString& filename, BinaryStream* pStream);
 
 private:
     static UnicodeString NormalizeFileName(const UnicodeString& targetName);
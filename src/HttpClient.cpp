@@ -95,20 +95,21 @@ size_t HttpClient::ReceiveDataHandler(void* pData, size_t dataSize, size_t itemS
 UnicodeString HttpClient::StreamToString(const SequentialStream* pStream)
 {
     PRECONDITION_RETURN(pStream != nullptr, UnicodeString());
-    PRECONDITION_RETURN(pStream->Data() != nullptr, UnicodeString());
     PRECONDITION_RETURN(pStream->DataSize() > 0, UnicodeString());
 
     UnicodeString result;
+    result.reserve(pStream->DataSize());
 
-    const size_t stringSize = pStream->DataSize() + sizeof(UnicodeChar);
-    UnicodeChar* pString    = new UnicodeChar[stringSize];
-    if(pString != nullptr)
-    {
-        memset(pString, 0, stringSize);
-        memcpy(pString, pStream->Data(), pStream->DataSize());
-        result = pString;
+    const SequentialStream::SegmentArray segments = pStream->Segments();
+    std::for_each(segments.begin(), segments.end(), [&](const SequentialStream::Segment& segment) {
+        result.append(reinterpret_cast<const UnicodeChar*>(segment.data), segment.dataSize);
+    });
 
-        SafeDeleteArray(pString);
+    // The response is handled as a C string, it ends at the first embedded zero
+    const size_t terminator = result.find('\0');
+    if(terminator != UnicodeString::npos)
+    {
+        result.resize(terminator);
     }
 
     return result;
@@ -25,13 +25,15 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "ID3V2.h"
-#include "BinaryStream.h"
-#include "FileManager.h"
-#include "Picture.h"
+#include "ImageCache.h"
+#include "MP3FrameIndex.h"
 #include "StringUtilities.h"
 
 namespace ultraschall { namespace reaper {
 
+// The size of the whole tag is a 28 bit sync-safe integer, a larger picture must not be narrowed to fit.
+static const size_t MAX_PICTURE_SIZE = 0x0fffffff;
+
 ID3V2Context* ID3V2StartTransaction(const UnicodeString& targetName)
 {
     PRECONDITION_RETURN(targetName.empty() == false, 0);
@@ -39,14 +41,88 @@ ID3V2Context* ID3V2StartTransaction(const UnicodeString& targetName)
     return new ID3V2Context(targetName);
 }
 
-bool ID3V2CommitTransaction(ID3V2Context*& pContext)
+// The chapter offsets have a fixed size, setting them does not change the size of the tag.
+static void UpdateChapterOffsets(ID3V2Context* pContext, const size_t tagSize)
+{
+    PRECONDITION(pContext != nullptr);
+    PRECONDITION(pContext->Tags() != nullptr);
+
+    MP3FrameIndex frameIndex;
+    if(frameIndex.Build(pContext->TargetName()) == true)
+    {
+        const size_t originalTagSize = pContext->OriginalTagSize();
+        const auto   fileOffset      = [&](const uint32_t time) -> uint32_t {
+            FileOffset offset = 0;
+            if((frameIndex.QueryOffset(time, offset) == false) || (offset < originalTagSize)
+               || ((offset - originalTagSize + tagSize) >= 0xffffffff))
+            {
+                return 0xffffffff;
+            }
+
+            return static_cast<uint32_t>(offset - originalTagSize + tagSize);
+        };
+
+        const taglib_id3v2::FrameList& frames = pContext->Tags()->frameList(taglib::ByteVector::fromCString("CHAP"));
+        for(taglib_id3v2::FrameList::ConstIterator i = frames.begin(); i != frames.end(); i++)
+        {
+            taglib_id3v2::ChapterFrame* pChapterFrame = dynamic_cast<taglib_id3v2::ChapterFrame*>(*i);
+            if(pChapterFrame != nullptr)
+            {
+                pChapterFrame->setStartOffset(fileOffset(pChapterFrame->startTime()));
+                pChapterFrame->setEndOffset(fileOffset(pChapterFrame->endTime()));
+            }
+        }
+    }
+}
+
+bool ID3V2CommitTransaction(
+    ID3V2Context*& pContext, const ID3V2PaddingPolicy& paddingPolicy, const ID3V2_COMMIT_STRATEGY commitStrategy)
 {
     PRECONDITION_RETURN(pContext != nullptr, false);
     PRECONDITION_RETURN(pContext->Tags() != nullptr, false);
 
-    pContext->Target()->strip(taglib_mp3::File::ID3v1 | taglib_mp3::File::APE);
-    const bool success = pContext->Target()->save(taglib_mp3::File::ID3v2, true, 3);
-    SafeDelete(pContext);
+    bool success = false;
+
+    // TagLib can't split the tag, the APPEND strategy only selects ID3v2.4 for the front tag.
+    const int version = (commitStrategy == ID3V2_COMMIT_STRATEGY::APPEND) ? 4 : 3;
+
+    if(pContext->CommitMode() == ID3V2_COMMIT_MODE::IN_PLACE)
+    {
+        taglib::ByteVector  tagData         = pContext->Tags()->render(version);
+        const UnicodeString targetName      = pContext->TargetName();
+        const size_t        originalTagSize = pContext->OriginalTagSize();
+        const size_t        paddingSize     = paddingPolicy.Budget(pContext->ChapterCount(), pContext->ImageSize());
+
+        size_t frameDataSize = 0;
+        size_t tagSize       = 0;
+        if((pContext->ChapterCount() > 0)
+           && ServiceSucceeded(ID3V2QueryFrameDataSize(
+               reinterpret_cast<const uint8_t*>(tagData.data()), tagData.size(), frameDataSize))
+           && ServiceSucceeded(
+               ID3V2QueryCommitTagSize(ID3V2_HEADER_SIZE + frameDataSize, originalTagSize, paddingSize, tagSize)))
+        {
+            UpdateChapterOffsets(pContext, tagSize);
+            tagData = pContext->Tags()->render(version);
+        }
+
+        // Close the file before writing to it through a different handle
+        SafeDelete(pContext);
+
+        success = ID3V2RemoveTrailingTags(targetName) && ID3V2RemoveAppendedTag(targetName)
+                  && ID3V2CommitTag(
+                      targetName, reinterpret_cast<const uint8_t*>(tagData.data()), tagData.size(), originalTagSize,
+                      paddingSize);
+    }
+    else
+    {
+        pContext->Target()->strip(taglib_mp3::File::ID3v1 | taglib_mp3::File::APE);
+        success = pContext->Target()->save(taglib_mp3::File::ID3v2, true, version);
+
+        const UnicodeString targetName = pContext->TargetName();
+        SafeDelete(pContext);
+
+        success = success && ID3V2RemoveAppendedTag(targetName);
+    }
 
     return success;
 }
@@ -193,6 +269,7 @@ bool ID3V2InsertChapterFrame(
             pEmbeddedFrame->setText(taglib::String(text, taglib::String::Type::UTF8));
             pChapterFrame->addEmbeddedFrame(pEmbeddedFrame);
             pContext->Tags()->addFrame(pChapterFrame);
+            pContext->RegisterChapter();
             success = true;
         }
         else
@@ -215,8 +292,9 @@ class AttachedPictureFrameV3 : public taglib_id3v2::AttachedPictureFrame
 };
 
 taglib_id3v2::FrameList* CreateEmbeddedFrames(
-    const UnicodeString& title, const UnicodeString& image, const UnicodeString& url)
+    ID3V2Context* pContext, const UnicodeString& title, const UnicodeString& image, const UnicodeString& url)
 {
+    PRECONDITION_RETURN(pContext != nullptr, nullptr);
     PRECONDITION_RETURN(title.empty() == false, nullptr);
 
     taglib_id3v2::FrameList* pFrameList = new taglib_id3v2::FrameList();
@@ -246,34 +324,29 @@ taglib_id3v2::FrameList* CreateEmbeddedFrames(
 
         if(image.empty() == false)
         {
-            BinaryStream* pPictureData = FileManager::ReadBinaryFile(image);
-            if(pPictureData != nullptr)
+            Image* pImage = ImageCache::Instance().Lookup(image);
+            if(pImage != nullptr)
             {
-                uint8_t      imageHeader[10] = {0};
-                const size_t imageHeaderSize = 10;
-                if(pPictureData->Read(0, imageHeader, imageHeaderSize) == true)
+                if((pImage->MimeType().empty() == false) && (pImage->DataSize() <= MAX_PICTURE_SIZE))
                 {
-                    const UnicodeString mimeType = Picture::FormatString(imageHeader, imageHeaderSize);
-                    if(mimeType.empty() == false)
+                    taglib_id3v2::AttachedPictureFrame* pPictureFrame = new AttachedPictureFrameV3();
+                    if(pPictureFrame != nullptr)
                     {
-                        taglib_id3v2::AttachedPictureFrame* pPictureFrame = new AttachedPictureFrameV3();
-                        if(pPictureFrame != nullptr)
-                        {
-                            pPictureFrame->setTextEncoding(taglib::String::Type::Latin1);
-                            pPictureFrame->setMimeType(mimeType);
-                            pPictureFrame->setType(taglib_id3v2::AttachedPictureFrame::Type::Other);
-
-                            const char*        pData    = reinterpret_cast<const char*>(pPictureData->Data());
-                            unsigned int       dataSize = static_cast<unsigned int>(pPictureData->DataSize());
-                            taglib::ByteVector pictureData;
-                            pictureData.setData(pData, dataSize);
-                            pPictureFrame->setPicture(pictureData);
-                            pFrameList->append(pPictureFrame);
-                        }
+                        pPictureFrame->setTextEncoding(taglib::String::Type::Latin1);
+                        pPictureFrame->setMimeType(pImage->MimeType());
+                        pPictureFrame->setType(taglib_id3v2::AttachedPictureFrame::Type::Other);
+
+                        const char*        pData    = reinterpret_cast<const char*>(pImage->Data());
+                        unsigned int       dataSize = static_cast<unsigned int>(pImage->DataSize());
+                        taglib::ByteVector pictureData;
+                        pictureData.setData(pData, dataSize);
+                        pPictureFrame->setPicture(pictureData);
+                        pFrameList->append(pPictureFrame);
+                        pContext->RegisterImage(pImage->DataSize());
                     }
                 }
 
-                SafeRelease(pPictureData);
+                SafeRelease(pImage);
             }
         }
     }
@@ -296,7 +369,7 @@ bool ID3V2InsertChapterFrame(
 
     const uint32_t           startOffset = 0xffffffff;
     const uint32_t           endOffset   = 0xffffffff;
-    taglib_id3v2::FrameList* pFrameList  = CreateEmbeddedFrames(text, image, url);
+    taglib_id3v2::FrameList* pFrameList  = CreateEmbeddedFrames(pContext, text, image, url);
     if(pFrameList != nullptr)
     {
         taglib_id3v2::ChapterFrame* pChapterFrame = new taglib_id3v2::ChapterFrame(
@@ -305,6 +378,7 @@ bool ID3V2InsertChapterFrame(
         if(pChapterFrame != nullptr)
         {
             pContext->Tags()->addFrame(pChapterFrame);
+            pContext->RegisterChapter();
             success = true;
         }
     }
@@ -312,11 +386,15 @@ bool ID3V2InsertChapterFrame(
     return success;
 }
 
+// The entry count of a CTOC frame is a single byte. Longer lists are split into nested tables of
+// contents that the top-level table of contents refers to.
 bool ID3V2InsertTableOfContentsFrame(ID3V2Context* pContext, const UnicodeStringArray& tableOfContentsItems)
 {
+    static const size_t MAX_ENTRY_COUNT = 255;
     PRECONDITION_RETURN(pContext != nullptr, false);
     PRECONDITION_RETURN(pContext->Tags() != nullptr, false);
     PRECONDITION_RETURN(tableOfContentsItems.empty() == false, false);
+    PRECONDITION_RETURN(tableOfContentsItems.size() <= (MAX_ENTRY_COUNT * MAX_ENTRY_COUNT), false);
 
     bool success = false;
 
@@ -327,9 +405,31 @@ bool ID3V2InsertTableOfContentsFrame(ID3V2Context* pContext, const UnicodeString
     {
         pTableOfContentsFrame->setIsTopLevel(true);
         pTableOfContentsFrame->setIsOrdered(true);
-        for(size_t j = 0; j < tableOfContentsItems.size(); j++)
+        if(tableOfContentsItems.size() <= MAX_ENTRY_COUNT)
         {
-            pTableOfContentsFrame->addChildElement(taglib::ByteVector::fromCString(tableOfContentsItems[j].c_str()));
+            for(size_t j = 0; j < tableOfContentsItems.size(); j++)
+            {
+                pTableOfContentsFrame->addChildElement(
+                    taglib::ByteVector::fromCString(tableOfContentsItems[j].c_str()));
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < tableOfContentsItems.size(); i += MAX_ENTRY_COUNT)
+            {
+                const UnicodeString childId = "toc" + std::to_string(i / MAX_ENTRY_COUNT);
+                taglib_id3v2::TableOfContentsFrame* pChildFrame
+                    = new taglib_id3v2::TableOfContentsFrame(taglib::ByteVector::fromCString(childId.c_str()));
+                pChildFrame->setIsTopLevel(false);
+                pChildFrame->setIsOrdered(true);
+                for(size_t j = i; j < std::min(i + MAX_ENTRY_COUNT, tableOfContentsItems.size()); j++)
+                {
+                    pChildFrame->addChildElement(taglib::ByteVector::fromCString(tableOfContentsItems[j].c_str()));
+                }
+
+                pTableOfContentsFrame->addChildElement(taglib::ByteVector::fromCString(childId.c_str()));
+                pContext->Tags()->addFrame(pChildFrame);
+            }
         }
 
         pContext->Tags()->addFrame(pTableOfContentsFrame);
@@ -350,28 +450,23 @@ bool ID3V2InsertCoverPictureFrame(ID3V2Context* pContext, const UnicodeString& i
     taglib_id3v2::AttachedPictureFrame* pPictureFrame = new AttachedPictureFrameV3();
     if(pPictureFrame != nullptr)
     {
-        BinaryStream* pPictureData = FileManager::ReadBinaryFile(image);
-        if(pPictureData != nullptr)
+        Image* pImage = ImageCache::Instance().Lookup(image);
+        if(pImage != nullptr)
         {
-            uint8_t      imageHeader[10] = {0};
-            const size_t imageHeaderSize = 10;
-            if(pPictureData->Read(0, imageHeader, imageHeaderSize) == true)
+            if((pImage->MimeType().empty() == false) && (pImage->DataSize() <= MAX_PICTURE_SIZE))
             {
-                const UnicodeString mimeType = Picture::FormatString(imageHeader, imageHeaderSize);
-                if(mimeType.empty() == false)
-                {
-                    pPictureFrame->setMimeType(mimeType);
-                    const char*        pData    = reinterpret_cast<const char*>(pPictureData->Data());
-                    unsigned int       dataSize = static_cast<unsigned int>(pPictureData->DataSize());
-                    taglib::ByteVector coverData(pData, dataSize);
-                    pPictureFrame->setPicture(coverData);
-
-                    pContext->Tags()->addFrame(pPictureFrame);
-                    success = true;
-                }
+                pPictureFrame->setMimeType(pImage->MimeType());
+                const char*        pData    = reinterpret_cast<const char*>(pImage->Data());
+                unsigned int       dataSize = static_cast<unsigned int>(pImage->DataSize());
+                taglib::ByteVector coverData(pData, dataSize);
+                pPictureFrame->setPicture(coverData);
+
+                pContext->Tags()->addFrame(pPictureFrame);
+                pContext->RegisterImage(pImage->DataSize());
+                success = true;
             }
 
-            SafeRelease(pPictureData);
+            SafeRelease(pImage);
         }
     }
 
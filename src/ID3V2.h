@@ -34,7 +34,8 @@
 namespace ultraschall { namespace reaper {
 
 ID3V2Context* ID3V2StartTransaction(const UnicodeString& targetName);
-bool          ID3V2CommitTransaction(ID3V2Context*& context);
+bool          ID3V2CommitTransaction(
+    ID3V2Context*& context, const ID3V2PaddingPolicy& paddingPolicy, const ID3V2_COMMIT_STRATEGY commitStrategy);
 void          ID3V2AbortTransaction(ID3V2Context*& context);
 
 void ID3V2RemoveAllFrames(ID3V2Context*);
@@ -0,0 +1,580 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ID3V2Commit.h"
+#include "FileManager.h"
+#include "PlatformGateway.h"
+#include "SystemProperties.h"
+
+namespace ultraschall { namespace reaper {
+
+static const UnicodeString ID3V2_SECTION_NAME("ultraschall_id3v2");
+
+static const size_t MAX_SYNC_SAFE_SIZE = 0x0fffffff;
+
+static uint32_t ReadSyncSafeInt(const uint8_t* data)
+{
+    return ((data[0] & 0x7f) << 21) | ((data[1] & 0x7f) << 14) | ((data[2] & 0x7f) << 7) | (data[3] & 0x7f);
+}
+
+static void WriteSyncSafeInt(uint8_t* data, const uint32_t value)
+{
+    data[0] = static_cast<uint8_t>((value >> 21) & 0x7f);
+    data[1] = static_cast<uint8_t>((value >> 14) & 0x7f);
+    data[2] = static_cast<uint8_t>((value >> 7) & 0x7f);
+    data[3] = static_cast<uint8_t>(value & 0x7f);
+}
+
+static uint32_t ReadBigEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint32_t ReadLittleEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[3]) << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+}
+
+static size_t QueryPaddingProperty(const UnicodeString& key, const size_t defaultValue)
+{
+    const int value = SystemProperty<int>::Query(ID3V2_SECTION_NAME, key);
+    return (value >= 0) ? static_cast<size_t>(value) : defaultValue;
+}
+
+ID3V2PaddingPolicy ID3V2PaddingPolicy::Query()
+{
+    ID3V2PaddingPolicy policy;
+
+    policy.minimumSize     = QueryPaddingProperty("padding_minimum", policy.minimumSize);
+    policy.chapterSize     = QueryPaddingProperty("padding_per_chapter", policy.chapterSize);
+    policy.imagePercentage = QueryPaddingProperty("padding_image_percentage", policy.imagePercentage);
+    policy.maximumSize     = QueryPaddingProperty("padding_maximum", policy.maximumSize);
+
+    return policy;
+}
+
+ID3V2_COMMIT_STRATEGY ID3V2QueryCommitStrategy()
+{
+    const int value = SystemProperty<int>::Query(ID3V2_SECTION_NAME, "commit_strategy");
+    return (value == 1) ? ID3V2_COMMIT_STRATEGY::APPEND : ID3V2_COMMIT_STRATEGY::PREPEND;
+}
+
+size_t ID3V2PaddingPolicy::Budget(const size_t chapterCount, const size_t imageSize) const
+{
+    // Leave room for retitled chapters, added urls and a slightly larger cover or
+    // chapter image, so that subsequent edits can be written over the existing tag.
+    const size_t budget = minimumSize + (chapterCount * chapterSize) + ((imageSize / 100) * imagePercentage);
+    return std::min(budget, maximumSize);
+}
+
+ServiceStatus ID3V2QueryTagSize(const UnicodeString& targetName, size_t& tagSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, SERVICE_INVALID_ARGUMENT);
+
+    ServiceStatus status = SERVICE_FILE_NOT_FOUND;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        uint8_t header[ID3V2_HEADER_SIZE] = {0};
+        file.read(reinterpret_cast<char*>(header), ID3V2_HEADER_SIZE);
+        if(file && (header[0] == 'I') && (header[1] == 'D') && (header[2] == '3') && (header[3] < 0xff)
+           && (header[4] < 0xff))
+        {
+            tagSize = ID3V2_HEADER_SIZE + ReadSyncSafeInt(&header[6]);
+            if((header[3] == 4) && ((header[5] & 0x10) != 0)) // footer
+            {
+                tagSize += ID3V2_HEADER_SIZE;
+            }
+        }
+        else
+        {
+            tagSize = 0;
+        }
+
+        status = SERVICE_SUCCESS;
+        file.close();
+    }
+
+    return status;
+}
+
+bool ID3V2IsTagCopyable(const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool isCopyable = false;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        uint8_t header[ID3V2_HEADER_SIZE] = {0};
+        file.read(reinterpret_cast<char*>(header), ID3V2_HEADER_SIZE);
+        if(file && (header[0] == 'I') && (header[1] == 'D') && (header[2] == '3'))
+        {
+            isCopyable = ((header[3] == 3) || (header[3] == 4)) && ((header[5] & 0x80) == 0);
+        }
+        else
+        {
+            isCopyable = true;
+        }
+
+        file.close();
+    }
+
+    return isCopyable;
+}
+
+// The size of the file is taken from the same handle, the caller passes it on to ReplaceFileTail.
+static ServiceStatus QueryAppendedTagSize(const UnicodeString& targetName, FileSize& fileSize, size_t& tagSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, SERVICE_INVALID_ARGUMENT);
+
+    ServiceStatus status = SERVICE_FILE_NOT_FOUND;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary | std::ios::ate);
+    if(file.is_open() == true)
+    {
+        tagSize                   = 0;
+        status                    = SERVICE_SUCCESS;
+        const std::streamoff size = file.tellg();
+        if(size >= 0)
+        {
+            fileSize = static_cast<FileSize>(size);
+        }
+        else
+        {
+            status = SERVICE_FILE_READ_FAILED;
+        }
+
+        if(size >= static_cast<std::streamoff>(2 * ID3V2_HEADER_SIZE))
+        {
+            uint8_t footer[ID3V2_HEADER_SIZE] = {0};
+            file.seekg(fileSize - ID3V2_HEADER_SIZE);
+            file.read(reinterpret_cast<char*>(footer), ID3V2_HEADER_SIZE);
+            if(file && (footer[0] == '3') && (footer[1] == 'D') && (footer[2] == 'I') && (footer[3] == 4))
+            {
+                const size_t appendedSize = (2 * ID3V2_HEADER_SIZE) + ReadSyncSafeInt(&footer[6]);
+                if(appendedSize <= fileSize)
+                {
+                    uint8_t header[ID3V2_HEADER_SIZE] = {0};
+                    file.seekg(fileSize - appendedSize);
+                    file.read(reinterpret_cast<char*>(header), ID3V2_HEADER_SIZE);
+                    if(file && (memcmp(header, "ID3", 3) == 0))
+                    {
+                        tagSize = appendedSize;
+                    }
+                }
+            }
+        }
+
+        file.close();
+    }
+
+    return status;
+}
+
+ServiceStatus ID3V2QueryAppendedTagSize(const UnicodeString& targetName, size_t& tagSize)
+{
+    FileSize fileSize = 0;
+    return QueryAppendedTagSize(targetName, fileSize, tagSize);
+}
+
+bool ID3V2RemoveAppendedTag(const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    FileSize fileSize        = 0;
+    size_t   appendedTagSize = 0;
+    PRECONDITION_RETURN(ServiceSucceeded(QueryAppendedTagSize(targetName, fileSize, appendedTagSize)), false);
+
+    bool success = true;
+    if(appendedTagSize > 0)
+    {
+        success
+            = PlatformGateway::ReplaceFileTail(targetName, fileSize, fileSize - appendedTagSize, FileSegmentArray());
+    }
+
+    return success;
+}
+
+bool ID3V2RemoveTrailingTags(const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    static const size_t ID3V1_TAG_SIZE    = 128;
+    static const size_t APE_HEADER_SIZE   = 32;
+    static const size_t TRAILER_READ_SIZE = ID3V1_TAG_SIZE + APE_HEADER_SIZE;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary | std::ios::ate);
+    PRECONDITION_RETURN(file.is_open() == true, false);
+
+    const std::streamoff size = file.tellg();
+    PRECONDITION_RETURN(size >= 0, false);
+
+    // An APE tag is stored in front of an ID3v1 tag, both are only looked for at the end of the file.
+    const FileSize fileSize                   = static_cast<FileSize>(size);
+    const size_t   trailerSize                = static_cast<size_t>(std::min<FileSize>(fileSize, TRAILER_READ_SIZE));
+    uint8_t        trailer[TRAILER_READ_SIZE] = {};
+    file.seekg(fileSize - trailerSize);
+    file.read(reinterpret_cast<char*>(trailer), trailerSize);
+    PRECONDITION_RETURN(file.good() == true, false);
+    file.close();
+
+    size_t trailerEnd = trailerSize;
+    if((trailerEnd >= ID3V1_TAG_SIZE) && (memcmp(&trailer[trailerEnd - ID3V1_TAG_SIZE], "TAG", 3) == 0))
+    {
+        trailerEnd -= ID3V1_TAG_SIZE;
+    }
+
+    FileSize tagsEnd = fileSize - (trailerSize - trailerEnd);
+    if((trailerEnd >= APE_HEADER_SIZE) && (memcmp(&trailer[trailerEnd - APE_HEADER_SIZE], "APETAGEX", 8) == 0))
+    {
+        // The size covers the items and the footer, bit 31 of the flags marks an additional header.
+        const uint8_t* footer  = &trailer[trailerEnd - APE_HEADER_SIZE];
+        FileSize       apeSize = ReadLittleEndianInt(&footer[12]);
+        if((ReadLittleEndianInt(&footer[20]) & 0x80000000) != 0)
+        {
+            apeSize += APE_HEADER_SIZE;
+        }
+
+        if((apeSize >= APE_HEADER_SIZE) && (apeSize <= tagsEnd))
+        {
+            tagsEnd -= apeSize;
+        }
+    }
+
+    bool success = true;
+    if(tagsEnd < fileSize)
+    {
+        success = PlatformGateway::ReplaceFileTail(targetName, fileSize, tagsEnd, FileSegmentArray());
+    }
+
+    return success;
+}
+
+ServiceStatus ID3V2QueryFrameDataSize(const uint8_t* tagData, const size_t tagDataSize, size_t& frameDataSize)
+{
+    PRECONDITION_RETURN(tagData != nullptr, SERVICE_INVALID_ARGUMENT);
+    PRECONDITION_RETURN(tagDataSize >= ID3V2_HEADER_SIZE, SERVICE_INVALID_ARGUMENT);
+    PRECONDITION_RETURN((tagData[0] == 'I') && (tagData[1] == 'D') && (tagData[2] == '3'), SERVICE_INVALID_ARGUMENT);
+
+    const uint8_t majorVersion = tagData[3];
+    PRECONDITION_RETURN((majorVersion == 3) || (majorVersion == 4), SERVICE_INVALID_ARGUMENT);
+
+    const size_t tagEnd = std::min(tagDataSize, ID3V2_HEADER_SIZE + ReadSyncSafeInt(&tagData[6]));
+    size_t       offset = ID3V2_HEADER_SIZE;
+
+    if(((tagData[5] & 0x40) != 0) && ((offset + 4) <= tagEnd)) // extended header
+    {
+        offset += (majorVersion == 3) ? (4 + ReadBigEndianInt(&tagData[offset])) : ReadSyncSafeInt(&tagData[offset]);
+    }
+
+    // Walk the frame headers only, the first zero byte in place of a frame id marks the padding.
+    static const size_t FRAME_HEADER_SIZE = 10;
+    while(((offset + FRAME_HEADER_SIZE) <= tagEnd) && (tagData[offset] != 0))
+    {
+        const uint32_t frameSize = (majorVersion == 3) ? ReadBigEndianInt(&tagData[offset + 4]) :
+                                                         ReadSyncSafeInt(&tagData[offset + 4]);
+        offset += FRAME_HEADER_SIZE + frameSize;
+    }
+
+    PRECONDITION_RETURN(offset <= tagEnd, SERVICE_FAILURE);
+
+    frameDataSize = offset - ID3V2_HEADER_SIZE;
+
+    return SERVICE_SUCCESS;
+}
+
+static bool WriteSegment(std::ostream& file, const ID3V2TagSegment& segment)
+{
+    PRECONDITION_RETURN(segment.data != nullptr, false);
+
+    file.write(reinterpret_cast<const char*>(segment.data), segment.dataSize);
+    return file.good();
+}
+
+static bool WriteTag(
+    std::ostream& file, const ID3V2TagSegmentArray& segments, const size_t requiredSize, const size_t tagSize)
+{
+    PRECONDITION_RETURN(segments.empty() == false, false);
+    PRECONDITION_RETURN(segments[0].data != nullptr, false);
+    PRECONDITION_RETURN(segments[0].dataSize >= ID3V2_HEADER_SIZE, false);
+    PRECONDITION_RETURN(requiredSize >= ID3V2_HEADER_SIZE, false);
+    PRECONDITION_RETURN(tagSize >= requiredSize, false);
+    PRECONDITION_RETURN((tagSize - ID3V2_HEADER_SIZE) <= MAX_SYNC_SAFE_SIZE, false);
+
+    uint8_t header[ID3V2_HEADER_SIZE] = {0};
+    memcpy(header, segments[0].data, ID3V2_HEADER_SIZE);
+    header[5] &= ~0x10; // the padded tag has no footer
+    WriteSyncSafeInt(&header[6], static_cast<uint32_t>(tagSize - ID3V2_HEADER_SIZE));
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(header), ID3V2_HEADER_SIZE);
+
+    const ID3V2TagSegment& first   = segments[0];
+    bool                   success = WriteSegment(
+        file, ID3V2TagSegment(&first.data[ID3V2_HEADER_SIZE], first.dataSize - ID3V2_HEADER_SIZE));
+    for(size_t i = 1; (i < segments.size()) && (true == success); i++)
+    {
+        success = WriteSegment(file, segments[i]);
+    }
+
+    static const uint8_t zeros[4096] = {0};
+    size_t               padding     = tagSize - requiredSize;
+    while((padding > 0) && (true == success))
+    {
+        const size_t chunkSize = std::min(padding, sizeof(zeros));
+        file.write(reinterpret_cast<const char*>(zeros), chunkSize);
+        success = file.good();
+        padding -= chunkSize;
+    }
+
+    file.flush();
+    return success && file.good();
+}
+
+// Compares the tag that is about to be written with the existing tag. Frames are always rendered
+// in the same order, unchanged metadata results in identical frame data and the commit can be
+// skipped. The comparison stops at the first difference.
+static bool IsTagUnchanged(
+    const UnicodeString& targetName, const FileOffset tagOffset, const ID3V2TagSegmentArray& segments,
+    const size_t requiredSize, const size_t originalTagSize, const uint8_t flags)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(segments.empty() == false, false);
+    PRECONDITION_RETURN(segments[0].dataSize >= ID3V2_HEADER_SIZE, false);
+    PRECONDITION_RETURN(requiredSize <= originalTagSize, false);
+
+    bool unchanged = false;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        const ID3V2TagSegment& first = segments[0];
+
+        uint8_t header[ID3V2_HEADER_SIZE] = {0};
+        file.seekg(tagOffset);
+        file.read(reinterpret_cast<char*>(header), ID3V2_HEADER_SIZE);
+        unchanged = file && (memcmp(header, first.data, 5) == 0) && (header[5] == flags);
+
+        static const size_t  MAX_CHUNK_SIZE = 64 * 1024;
+        std::vector<uint8_t> buffer;
+        for(size_t i = 0; (i < segments.size()) && (true == unchanged); i++)
+        {
+            const size_t   headerSize = (i == 0) ? ID3V2_HEADER_SIZE : 0;
+            const uint8_t* data       = &segments[i].data[headerSize];
+            const size_t   dataSize   = segments[i].dataSize - headerSize;
+            for(size_t offset = 0; (offset < dataSize) && (true == unchanged); offset += MAX_CHUNK_SIZE)
+            {
+                const size_t chunkSize = std::min(dataSize - offset, MAX_CHUNK_SIZE);
+                buffer.resize(chunkSize);
+                file.read(reinterpret_cast<char*>(buffer.data()), chunkSize);
+                unchanged = file && (memcmp(buffer.data(), &data[offset], chunkSize) == 0);
+            }
+        }
+
+        // The existing tag must not contain additional frames
+        if((true == unchanged) && (requiredSize < originalTagSize))
+        {
+            char next = 0;
+            file.read(&next, 1);
+            unchanged = file && (next == 0);
+        }
+
+        file.close();
+    }
+
+    return unchanged;
+}
+
+static bool UpdateTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& segments, const size_t requiredSize,
+    const size_t tagSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool success = false;
+
+    std::fstream file(U2H(targetName), std::ios::in | std::ios::out | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        success = WriteTag(file, segments, requiredSize, tagSize);
+        file.close();
+    }
+
+    return success;
+}
+
+static bool ReplaceTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& segments, const size_t requiredSize,
+    const size_t tagSize, const size_t originalTagSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool success = false;
+
+    // Write the new tag followed by the audio data into a sibling file and replace the target only
+    // once everything has reached the disk. A crash during the commit leaves the original untouched.
+    const UnicodeString tempName = targetName + ".ultraschall-commit";
+
+    std::ofstream file(U2H(tempName), std::ios::out | std::ios::trunc | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        success = WriteTag(file, segments, requiredSize, tagSize);
+        file.close();
+
+        if(true == success)
+        {
+            success = PlatformGateway::AppendFileData(tempName, targetName, originalTagSize)
+                      && PlatformGateway::RenameFile(tempName, targetName);
+        }
+
+        if(false == success)
+        {
+            std::remove(U2H(tempName).c_str());
+        }
+    }
+
+    return success;
+}
+
+ServiceStatus ID3V2QueryCommitTagSize(
+    const size_t requiredSize, const size_t originalTagSize, const size_t paddingSize, size_t& tagSize)
+{
+    PRECONDITION_RETURN(requiredSize >= ID3V2_HEADER_SIZE, SERVICE_INVALID_ARGUMENT);
+
+    if((originalTagSize > 0) && (requiredSize <= originalTagSize))
+    {
+        tagSize = originalTagSize;
+    }
+    else
+    {
+        tagSize = std::min(requiredSize + paddingSize, ID3V2_HEADER_SIZE + MAX_SYNC_SAFE_SIZE);
+    }
+
+    return SERVICE_SUCCESS;
+}
+
+bool ID3V2CommitTag(
+    const UnicodeString& targetName, const uint8_t* tagData, const size_t tagDataSize, const size_t originalTagSize,
+    const size_t paddingSize)
+{
+    PRECONDITION_RETURN(tagData != nullptr, false);
+    PRECONDITION_RETURN(tagDataSize >= ID3V2_HEADER_SIZE, false);
+
+    size_t frameDataSize = 0;
+    PRECONDITION_RETURN(ServiceSucceeded(ID3V2QueryFrameDataSize(tagData, tagDataSize, frameDataSize)), false);
+
+    // Drop the padding of the rendered tag, the commit appends its own.
+    const ID3V2TagSegmentArray segments = {ID3V2TagSegment(tagData, ID3V2_HEADER_SIZE + frameDataSize)};
+    return ID3V2CommitTag(targetName, segments, originalTagSize, paddingSize);
+}
+
+bool ID3V2CommitTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& segments, const size_t originalTagSize,
+    const size_t paddingSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(segments.empty() == false, false);
+
+    bool success = false;
+
+    size_t requiredSize = 0;
+    std::for_each(segments.begin(), segments.end(), [&](const ID3V2TagSegment& segment) {
+        requiredSize += segment.dataSize;
+    });
+
+    size_t tagSize = 0;
+    PRECONDITION_RETURN(
+        ServiceSucceeded(ID3V2QueryCommitTagSize(requiredSize, originalTagSize, paddingSize, tagSize)), false);
+
+    if(tagSize == originalTagSize)
+    {
+        // The new tag fits into the existing tag and its padding, the audio data stays untouched.
+        const uint8_t flags = segments[0].data[5] & ~0x10; // the padded tag has no footer
+        success = IsTagUnchanged(targetName, 0, segments, requiredSize, originalTagSize, flags)
+                  || UpdateTag(targetName, segments, requiredSize, originalTagSize);
+    }
+    else
+    {
+        FileSize   fileSize    = 0;
+        const bool sizeIsValid = (requiredSize <= tagSize)
+                                 && ServiceSucceeded(FileManager::QueryFileSize(targetName, fileSize))
+                                 && (fileSize >= originalTagSize);
+        if((true == sizeIsValid)
+           && (FileManager::IsDiskSpaceAvailable(targetName, (fileSize - originalTagSize) + tagSize) == true))
+        {
+            success = ReplaceTag(targetName, segments, requiredSize, tagSize, originalTagSize);
+        }
+    }
+
+    return success;
+}
+
+bool ID3V2CommitAppendedTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& frontSegments,
+    const ID3V2TagSegmentArray& appendedSegments, const size_t originalTagSize, const size_t paddingSize)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(appendedSegments.empty() == false, false);
+    PRECONDITION_RETURN(appendedSegments[0].dataSize >= ID3V2_HEADER_SIZE, false);
+
+    FileSize fileSize        = 0;
+    size_t   appendedTagSize = 0;
+    PRECONDITION_RETURN(ServiceSucceeded(QueryAppendedTagSize(targetName, fileSize, appendedTagSize)), false);
+    PRECONDITION_RETURN(fileSize >= (originalTagSize + appendedTagSize), false);
+
+    size_t requiredSize = 0;
+    std::for_each(appendedSegments.begin(), appendedSegments.end(), [&](const ID3V2TagSegment& segment) {
+        requiredSize += segment.dataSize;
+    });
+
+    // Only the tail of the file is written, the audio data stays where it is.
+    const FileOffset audioEnd = fileSize - appendedTagSize;
+    const uint8_t    flags    = appendedSegments[0].data[5];
+
+    bool success = false;
+    if(requiredSize == appendedTagSize)
+    {
+        success = IsTagUnchanged(targetName, audioEnd, appendedSegments, requiredSize, appendedTagSize, flags);
+    }
+
+    if(false == success)
+    {
+        // Fails without writing anything if the file has changed since its size has been queried.
+        success = PlatformGateway::ReplaceFileTail(targetName, fileSize, audioEnd, appendedSegments);
+    }
+
+    if(true == success)
+    {
+        success = ID3V2CommitTag(targetName, frontSegments, originalTagSize, paddingSize);
+    }
+
+    return success;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_ID3V2_COMMIT_H_INCL__
+#define __ULTRASCHALL_REAPER_ID3V2_COMMIT_H_INCL__
+
+#include "Common.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+enum class ID3V2_COMMIT_MODE
+{
+    REWRITE,  // let TagLib rewrite the whole file
+    IN_PLACE, // overwrite the existing tag if the new one fits into tag plus padding
+    MAX_COMMIT_MODE = IN_PLACE
+};
+
+enum class ID3V2_COMMIT_STRATEGY
+{
+    PREPEND, // ID3v2.3 tag in front of the audio data
+    APPEND,  // small ID3v2.4 tag in front of the audio data, pictures and chapters in a tag behind it
+    MAX_COMMIT_STRATEGY = APPEND
+};
+
+ID3V2_COMMIT_STRATEGY ID3V2QueryCommitStrategy();
+
+struct ID3V2PaddingPolicy
+{
+    size_t minimumSize     = 4 * 1024;
+    size_t chapterSize     = 256;
+    size_t imagePercentage = 25;
+    size_t maximumSize     = 4 * 1024 * 1024;
+
+    size_t Budget(const size_t chapterCount, const size_t imageSize) const;
+
+    static ID3V2PaddingPolicy Query();
+};
+
+static const size_t ID3V2_HEADER_SIZE = 10;
+
+// A rendered tag is a sequence of segments that point into buffers owned by the caller.
+typedef FileSegment      ID3V2TagSegment;
+typedef FileSegmentArray ID3V2TagSegmentArray;
+
+// Size of the tag at the start of the file, 0 if there is none
+ServiceStatus ID3V2QueryTagSize(const UnicodeString& targetName, size_t& tagSize);
+
+// False if the tag at the start of the file is unsynchronized or neither ID3v2.3 nor ID3v2.4, its frames can't be
+// copied into a new tag then.
+bool ID3V2IsTagCopyable(const UnicodeString& targetName);
+
+// Size of an ID3v2.4 tag with footer at the end of the file, 0 if there is none
+ServiceStatus ID3V2QueryAppendedTagSize(const UnicodeString& targetName, size_t& tagSize);
+bool          ID3V2RemoveAppendedTag(const UnicodeString& targetName);
+
+// Removes an APE and an ID3v1 tag from the end of the file, they would hide an appended tag.
+bool ID3V2RemoveTrailingTags(const UnicodeString& targetName);
+
+// Size of the frames of a rendered tag without header and padding
+ServiceStatus ID3V2QueryFrameDataSize(const uint8_t* tagData, const size_t tagDataSize, size_t& frameDataSize);
+
+// Size of the tag on disk after ID3V2CommitTag, including the padding. The original tag size is 0 if there is none.
+ServiceStatus ID3V2QueryCommitTagSize(
+    const size_t requiredSize, const size_t originalTagSize, const size_t paddingSize, size_t& tagSize);
+
+bool ID3V2CommitTag(
+    const UnicodeString& targetName, const uint8_t* tagData, const size_t tagDataSize, const size_t originalTagSize,
+    const size_t paddingSize);
+
+bool ID3V2CommitTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& segments, const size_t originalTagSize,
+    const size_t paddingSize);
+
+// Replaces the tag at the end of the file and commits the front tag. The audio data is only moved
+// if the front tag doesn't fit into the existing tag and its padding.
+bool ID3V2CommitAppendedTag(
+    const UnicodeString& targetName, const ID3V2TagSegmentArray& frontSegments,
+    const ID3V2TagSegmentArray& appendedSegments, const size_t originalTagSize, const size_t paddingSize);
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_ID3V2_COMMIT_H_INCL__
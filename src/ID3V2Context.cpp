@@ -25,20 +25,24 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "ID3V2Context.h"
+#include "MP3Properties.h"
 
 namespace ultraschall { namespace reaper { 
 
-ID3V2Context::ID3V2Context(const UnicodeString& targetName) : target_(new taglib_mp3::File(U2H(targetName).c_str())), tags_(nullptr)
+ID3V2Context::ID3V2Context(const UnicodeString& targetName) :
+    target_(new taglib_mp3::File(U2H(targetName).c_str(), false)), tags_(nullptr), targetName_(targetName)
 {
     if(target_->isOpen() == true)
     {
-        if(target_->audioProperties() != nullptr)
-        {
-            duration_ = target_->audioProperties()->length() * 1000;
-        }
+        MP3QueryDuration(targetName_, duration_);
 
-        target_->strip(taglib_mp3::File::ID3v1 | taglib_mp3::File::APE);
         tags_ = target_->ID3v2Tag();
+
+        // The tag can only be replaced in place if the size of the original tag is known.
+        if(ServiceFailed(ID3V2QueryTagSize(targetName_, originalTagSize_)))
+        {
+            commitMode_ = ID3V2_COMMIT_MODE::REWRITE;
+        }
     }
 }
 
@@ -28,6 +28,7 @@
 #define __ULTRASCHALL_REAPER_ID3V2_CONTEXT_H_INCL__
 
 #include "Common.h"
+#include "ID3V2Commit.h"
 
 #include "taglib_include.h"
 
@@ -45,10 +46,27 @@ class ID3V2Context
     inline taglib_id3v2::Tag* Tags();
     inline uint32_t           Duration() const;
 
+    inline const UnicodeString& TargetName() const;
+    inline size_t               OriginalTagSize() const;
+
+    inline ID3V2_COMMIT_MODE CommitMode() const;
+    inline void              SetCommitMode(const ID3V2_COMMIT_MODE commitMode);
+
+    inline void   RegisterChapter();
+    inline void   RegisterImage(const size_t imageSize);
+    inline size_t ChapterCount() const;
+    inline size_t ImageSize() const;
+
 private:
     taglib_mp3::File*  target_ = nullptr;
     taglib_id3v2::Tag* tags_   = nullptr;
-    uint32_t duration_ = -1;
+    uint32_t duration_ = 0; // milliseconds, 0 if unknown
+
+    UnicodeString     targetName_;
+    size_t            originalTagSize_ = 0;
+    ID3V2_COMMIT_MODE commitMode_      = ID3V2_COMMIT_MODE::IN_PLACE;
+    size_t            chapterCount_    = 0;
+    size_t            imageSize_       = 0;
 
     ID3V2Context(const ID3V2Context&) = delete;
     ID3V2Context& operator=(const ID3V2Context&) = delete;
@@ -74,6 +92,46 @@ inline uint32_t ID3V2Context::Duration() const
   return duration_;
 }
 
+inline const UnicodeString& ID3V2Context::TargetName() const
+{
+    return targetName_;
+}
+
+inline size_t ID3V2Context::OriginalTagSize() const
+{
+    return originalTagSize_;
+}
+
+inline ID3V2_COMMIT_MODE ID3V2Context::CommitMode() const
+{
+    return commitMode_;
+}
+
+inline void ID3V2Context::SetCommitMode(const ID3V2_COMMIT_MODE commitMode)
+{
+    commitMode_ = commitMode;
+}
+
+inline void ID3V2Context::RegisterChapter()
+{
+    chapterCount_++;
+}
+
+inline void ID3V2Context::RegisterImage(const size_t imageSize)
+{
+    imageSize_ += imageSize;
+}
+
+inline size_t ID3V2Context::ChapterCount() const
+{
+    return chapterCount_;
+}
+
+inline size_t ID3V2Context::ImageSize() const
+{
+    return imageSize_;
+}
+
 }} // namespace ultraschall::reaper::id3v2
 
 #endif // #ifndef __ULTRASCHALL_REAPER_ID3V2_CONTEXT_H_INCL__
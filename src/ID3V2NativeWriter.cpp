@@ -0,0 +1,348 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ID3V2NativeWriter.h"
+#include "FileManager.h"
+#include "MetadataCache.h"
+#include "MP3Properties.h"
+#include "PlatformGateway.h"
+#include "StringUtilities.h"
+
+namespace ultraschall { namespace reaper {
+
+static uint64_t HashTagSegments(const ID3V2TagSegmentArray& segments, const size_t paddingSize, const uint64_t seed)
+{
+    // FNV-1a, 64 bit
+    uint64_t hash = seed;
+    for(size_t i = 0; i < segments.size(); i++)
+    {
+        for(size_t j = 0; j < segments[i].dataSize; j++)
+        {
+            hash ^= segments[i].data[j];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    for(size_t i = 0; i < sizeof(uint64_t); i++)
+    {
+        hash ^= (static_cast<uint64_t>(paddingSize) >> (i * 8)) & 0xff;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t TagHashSeed(const ID3V2_COMMIT_STRATEGY commitStrategy)
+{
+    return (0xcbf29ce484222325ULL ^ static_cast<uint64_t>(commitStrategy)) * 0x100000001b3ULL;
+}
+
+static bool IsTagCommitted(const UnicodeString& targetName, const uint64_t tagHash)
+{
+    uint64_t committedTagHash = 0;
+    return (MetadataCache::Instance().QueryTagHash(targetName, committedTagHash) == true)
+           && (committedTagHash == tagHash);
+}
+
+ID3V2NativeWriter::~ID3V2NativeWriter()
+{
+    SafeDelete(pSerializer_);
+}
+
+bool ID3V2NativeWriter::Start(const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(pSerializer_ == nullptr, false);
+
+    bool started = false;
+
+    // Without a duration neither TLEN nor the end of the last chapter can be written.
+    duration_ = 0;
+    MP3QueryDuration(targetName, duration_);
+
+    if(ServiceSucceeded(ID3V2QueryTagSize(targetName, originalTagSize_)))
+    {
+        targetName_  = targetName;
+        pSerializer_ = new ID3V2Serializer();
+        started      = InsertExistingFrames();
+    }
+
+    return started;
+}
+
+bool ID3V2NativeWriter::InsertExistingFrames()
+{
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+
+    bool success = true;
+
+    if(originalTagSize_ > 0)
+    {
+        std::ifstream file(U2H(targetName_), std::ios::in | std::ios::binary);
+        if(file.is_open() == true)
+        {
+            std::vector<uint8_t> tagData(originalTagSize_);
+            file.read(reinterpret_cast<char*>(tagData.data()), tagData.size());
+            if(file)
+            {
+                static const UnicodeStringArray FRAME_IDS
+                    = {"TALB", "TPE1", "TIT2", "TCON", "TYER", "TDRC", "TLEN", "COMM", "APIC", "CTOC", "CHAP", "SEEK"};
+                // Rewriting a tag that can't be copied would drop all frames the writer doesn't know.
+                success = pSerializer_->InsertExistingFrames(tagData.data(), tagData.size(), FRAME_IDS);
+            }
+            else
+            {
+                success = false;
+            }
+
+            file.close();
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool ID3V2NativeWriter::Stop(const bool commit)
+{
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+
+    bool success = true;
+
+    if(true == commit)
+    {
+        success = ID3V2RemoveTrailingTags(targetName_);
+        if(true == success)
+        {
+            if((commitStrategy_ != ID3V2_COMMIT_STRATEGY::APPEND) || (CommitAppendedTag() == false))
+            {
+                success = CommitTag();
+            }
+        }
+    }
+
+    SafeDelete(pSerializer_);
+
+    return success;
+}
+
+void ID3V2NativeWriter::UpdateChapterOffsets(const size_t requiredSize, const size_t paddingSize)
+{
+    PRECONDITION(pSerializer_ != nullptr);
+
+    if(pSerializer_->ChapterCount() > 0)
+    {
+        MP3FrameIndex frameIndex;
+        if(frameIndex.Build(targetName_) == true)
+        {
+            size_t tagSize = 0;
+            if(ServiceSucceeded(ID3V2QueryCommitTagSize(requiredSize, originalTagSize_, paddingSize, tagSize)))
+            {
+                pSerializer_->UpdateChapterOffsets(frameIndex, originalTagSize_, tagSize);
+            }
+        }
+    }
+}
+
+bool ID3V2NativeWriter::CommitTag()
+{
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+
+    bool success = false;
+
+    const size_t paddingSize = paddingPolicy_.Budget(pSerializer_->ChapterCount(), pSerializer_->ImageSize());
+    UpdateChapterOffsets(pSerializer_->TagSize(), paddingSize);
+
+    ID3V2TagSegmentArray segments;
+    if(pSerializer_->Render(segments) == true)
+    {
+        // The file still holds this tag if nobody has touched it since the last commit
+        const uint64_t tagHash = HashTagSegments(segments, paddingSize, TagHashSeed(ID3V2_COMMIT_STRATEGY::PREPEND));
+        if(IsTagCommitted(targetName_, tagHash) == false)
+        {
+            FileIdentity previousIdentity;
+            PlatformGateway::QueryFileIdentity(targetName_, previousIdentity);
+
+            // A tag that has been appended by a previous commit would duplicate the chapters and pictures
+            if(ID3V2RemoveAppendedTag(targetName_) == true)
+            {
+                success = ID3V2CommitTag(targetName_, segments, originalTagSize_, paddingSize);
+                if(true == success)
+                {
+                    MetadataCache::Instance().UpdateTagHash(targetName_, previousIdentity, tagHash);
+                }
+            }
+        }
+        else
+        {
+            success = true;
+        }
+    }
+
+    return success;
+}
+
+bool ID3V2NativeWriter::CommitAppendedTag()
+{
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+
+    bool success = false;
+
+    FileSize fileSize        = 0;
+    size_t   appendedTagSize = 0;
+    if(ServiceSucceeded(FileManager::QueryFileSize(targetName_, fileSize))
+       && ServiceSucceeded(ID3V2QueryAppendedTagSize(targetName_, appendedTagSize))
+       && (fileSize >= (originalTagSize_ + appendedTagSize)))
+    {
+        // The SEEK frame points from the end of the front tag to the appended tag, across the audio data.
+        const FileSize audioSize = fileSize - originalTagSize_ - appendedTagSize;
+        if(audioSize <= 0xffffffff)
+        {
+            // The front tag only holds text frames, its padding doesn't depend on chapters and pictures.
+            const size_t paddingSize = paddingPolicy_.Budget(0, 0);
+            UpdateChapterOffsets(pSerializer_->FrontTagSize(), paddingSize);
+
+            ID3V2TagSegmentArray frontSegments;
+            ID3V2TagSegmentArray appendedSegments;
+            if(pSerializer_->Render(frontSegments, appendedSegments, static_cast<uint32_t>(audioSize)) == true)
+            {
+                const uint64_t tagHash = HashTagSegments(
+                    appendedSegments, 0,
+                    HashTagSegments(frontSegments, paddingSize, TagHashSeed(ID3V2_COMMIT_STRATEGY::APPEND)));
+                if(IsTagCommitted(targetName_, tagHash) == false)
+                {
+                    FileIdentity previousIdentity;
+                    PlatformGateway::QueryFileIdentity(targetName_, previousIdentity);
+
+                    success = ID3V2CommitAppendedTag(
+                        targetName_, frontSegments, appendedSegments, originalTagSize_, paddingSize);
+                    if(true == success)
+                    {
+                        MetadataCache::Instance().UpdateTagHash(targetName_, previousIdentity, tagHash);
+                    }
+                }
+                else
+                {
+                    success = true;
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+bool ID3V2NativeWriter::InsertProperties(const UnicodeString& targetName, const UnicodeStringDictionary& mediaData)
+{
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(mediaData.empty() == false, false);
+
+    bool success = true;
+
+    UnicodeString durationString;
+    if(mediaData.count("TLEN") > 0)
+    {
+        durationString = mediaData.at("TLEN");
+    }
+
+    if((durationString.empty() == true) && (duration_ > 0))
+    {
+        durationString = UnicodeStringFromInt(duration_);
+    }
+
+    struct MAP_ULTRASCHALL_PROPERTIES_TO_ID3V2_TAGS
+    {
+        const UnicodeChar*  frameId;
+        const CHAR_ENCODING targetEncoding;
+        const UnicodeString text;
+    };
+
+    MAP_ULTRASCHALL_PROPERTIES_TO_ID3V2_TAGS simpleFrameMappings[] = {
+        {"TALB", UTF16, mediaData.at("podcast")},        {"TPE1", UTF16, mediaData.at("author")},
+        {"TIT2", UTF16, mediaData.at("episode")},        {"TCON", UTF16, mediaData.at("category")},
+        {"TYER", UTF8, mediaData.at("publicationDate")}, {"TLEN", UTF8, durationString}};
+    const size_t maxSimpleFrames = sizeof(simpleFrameMappings) / sizeof(simpleFrameMappings[0]);
+
+    for(size_t i = 0; (i < maxSimpleFrames) && (true == success); i++)
+    {
+        success = pSerializer_->InsertTextFrame(
+            simpleFrameMappings[i].frameId, simpleFrameMappings[i].text, simpleFrameMappings[i].targetEncoding);
+    }
+
+    if(true == success)
+    {
+        success = pSerializer_->InsertCommentsFrame(mediaData.at("description"));
+    }
+
+    return success;
+}
+
+bool ID3V2NativeWriter::InsertCoverImage(const UnicodeString& targetName, const UnicodeString& coverImage)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(coverImage.empty() == false, false);
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+
+    return pSerializer_->InsertPictureFrame(coverImage);
+}
+
+bool ID3V2NativeWriter::InsertChapterMarkers(const UnicodeString& targetName, const ChapterTagArray& chapterMarkers)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(chapterMarkers.empty() == false, false);
+    PRECONDITION_RETURN(pSerializer_ != nullptr, false);
+    PRECONDITION_RETURN(duration_ > 0, false);
+
+    bool success = true;
+
+    UnicodeStringArray tableOfContentsItems;
+    for(size_t i = 0; (i < chapterMarkers.size()) && (true == success); i++)
+    {
+        const UnicodeString tableOfContentsItem = "chp" + UnicodeStringFromInt(static_cast<int>(i));
+        tableOfContentsItems.push_back(tableOfContentsItem);
+
+        const uint32_t startTime = static_cast<uint32_t>(chapterMarkers[i].Position() * 1000);
+        const uint32_t endTime   = (i < (chapterMarkers.size() - 1)) ?
+                                       static_cast<uint32_t>(chapterMarkers[i + 1].Position() * 1000) :
+                                       duration_;
+        success = pSerializer_->InsertChapterFrame(
+            tableOfContentsItem, chapterMarkers[i].Title(), startTime, endTime, chapterMarkers[i].Image(),
+            chapterMarkers[i].Url());
+    }
+
+    if(true == success)
+    {
+        success = pSerializer_->InsertTableOfContentsFrame(tableOfContentsItems);
+    }
+
+    return success;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_ID3V2_NATIVE_WRITER_H_INCL__
+#define __ULTRASCHALL_REAPER_ID3V2_NATIVE_WRITER_H_INCL__
+
+#include "Common.h"
+#include "ID3V2Serializer.h"
+#include "ITagWriter.h"
+
+namespace ultraschall { namespace reaper {
+
+class ID3V2NativeWriter : public ITagWriter
+{
+public:
+    virtual bool Start(const UnicodeString& targetName);
+
+    virtual bool Stop(const bool commit);
+
+    virtual bool InsertProperties(const UnicodeString& targetName, const UnicodeStringDictionary& mediaData);
+
+    virtual bool InsertCoverImage(const UnicodeString& targetName, const UnicodeString& coverImage);
+
+    virtual bool InsertChapterMarkers(const UnicodeString& targetName, const ChapterTagArray& chapterMarkers);
+
+protected:
+    virtual ~ID3V2NativeWriter();
+
+private:
+    ID3V2Serializer* pSerializer_     = nullptr;
+    UnicodeString    targetName_;
+    size_t           originalTagSize_ = 0;
+    uint32_t         duration_        = 0; // milliseconds, 0 if unknown
+
+    // Queried on construction, the writer may be started and stopped on a worker thread.
+    const ID3V2PaddingPolicy    paddingPolicy_  = ID3V2PaddingPolicy::Query();
+    const ID3V2_COMMIT_STRATEGY commitStrategy_ = ID3V2QueryCommitStrategy();
+
+    bool InsertExistingFrames();
+
+    void UpdateChapterOffsets(const size_t requiredSize, const size_t paddingSize);
+    bool CommitTag();
+    bool CommitAppendedTag();
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_ID3V2_NATIVE_WRITER_H_INCL__
@@ -0,0 +1,569 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ID3V2Reader.h"
+#include "FileManager.h"
+#include "ID3V2Commit.h"
+#include "Picture.h"
+
+namespace ultraschall { namespace reaper {
+
+static const size_t FRAME_HEADER_SIZE = 10;
+
+static const uint8_t LATIN1_ENCODING   = 0;
+static const uint8_t UTF16_ENCODING    = 1;
+static const uint8_t UTF16BE_ENCODING  = 2;
+static const uint8_t UTF8_ENCODING     = 3;
+static const uint8_t TOP_LEVEL_TOC     = 0x02;
+static const uint32_t INVALID_POSITION = 0xffffffff;
+
+struct ChapterFrame
+{
+    UnicodeString id;
+    uint32_t      startTime = INVALID_POSITION;
+    UnicodeString title;
+    UnicodeString url;
+    UnicodeString image;
+};
+
+struct TableOfContentsFrame
+{
+    UnicodeString      id;
+    uint8_t            flags = 0;
+    UnicodeStringArray children;
+};
+
+static uint32_t ReadBigEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint32_t ReadSyncSafeInt(const uint8_t* data)
+{
+    return ((data[0] & 0x7f) << 21) | ((data[1] & 0x7f) << 14) | ((data[2] & 0x7f) << 7) | (data[3] & 0x7f);
+}
+
+// Removes the zero bytes that have been inserted after each 0xff
+static std::vector<uint8_t> Resynchronize(const uint8_t* data, const size_t dataSize)
+{
+    std::vector<uint8_t> result;
+    result.reserve(dataSize);
+
+    for(size_t i = 0; i < dataSize; i++)
+    {
+        result.push_back(data[i]);
+        if((data[i] == 0xff) && ((i + 1) < dataSize) && (data[i + 1] == 0x00))
+        {
+            i++;
+        }
+    }
+
+    return result;
+}
+
+static size_t CharacterSize(const uint8_t encoding)
+{
+    return ((encoding == UTF16_ENCODING) || (encoding == UTF16BE_ENCODING)) ? 2 : 1;
+}
+
+// Returns the offset of the string terminator or dataSize if the string is not terminated
+static size_t FindTerminator(const uint8_t encoding, const uint8_t* data, const size_t dataSize)
+{
+    const size_t characterSize = CharacterSize(encoding);
+
+    size_t offset = 0;
+    while(((offset + characterSize) <= dataSize)
+          && ((data[offset] != 0) || ((characterSize == 2) && (data[offset + 1] != 0))))
+    {
+        offset += characterSize;
+    }
+
+    return std::min(offset, dataSize);
+}
+
+// Returns the offset behind the string terminator
+static size_t SkipString(const uint8_t encoding, const uint8_t* data, const size_t dataSize)
+{
+    return std::min(FindTerminator(encoding, data, dataSize) + CharacterSize(encoding), dataSize);
+}
+
+static UnicodeString DecodeString(const uint8_t encoding, const uint8_t* data, const size_t dataSize)
+{
+    const size_t  stringSize = FindTerminator(encoding, data, dataSize);
+    UnicodeString result;
+
+    if((encoding == UTF16_ENCODING) || (encoding == UTF16BE_ENCODING))
+    {
+        size_t offset       = 0;
+        bool   littleEndian = false;
+        if((encoding == UTF16_ENCODING) && (stringSize >= 2))
+        {
+            if((data[0] == 0xff) && (data[1] == 0xfe))
+            {
+                littleEndian = true;
+                offset       = 2;
+            }
+            else if((data[0] == 0xfe) && (data[1] == 0xff))
+            {
+                offset = 2;
+            }
+        }
+
+        WideUnicodeString wideString;
+        wideString.reserve((stringSize - offset) / 2);
+        for(; (offset + 2) <= stringSize; offset += 2)
+        {
+            wideString.push_back(
+                littleEndian ? static_cast<char16_t>(data[offset] | (data[offset + 1] << 8)) :
+                               static_cast<char16_t>((data[offset] << 8) | data[offset + 1]));
+        }
+
+        result = WU2U(wideString);
+    }
+    else if(encoding == UTF8_ENCODING)
+    {
+        result.assign(reinterpret_cast<const char*>(data), stringSize);
+    }
+    else
+    {
+        result.reserve(stringSize);
+        for(size_t i = 0; i < stringSize; i++)
+        {
+            if(data[i] < 0x80)
+            {
+                result.push_back(static_cast<char>(data[i]));
+            }
+            else
+            {
+                result.push_back(static_cast<char>(0xc0 | (data[i] >> 6)));
+                result.push_back(static_cast<char>(0x80 | (data[i] & 0x3f)));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Calls f(id, payload, payloadSize) for each frame, frames that can't be decoded are skipped.
+template<typename F>
+static void ForEachFrame(const uint8_t* data, const size_t dataSize, const uint8_t majorVersion, F f)
+{
+    size_t offset = 0;
+    while(((offset + FRAME_HEADER_SIZE) <= dataSize) && (data[offset] != 0))
+    {
+        const UnicodeString id(reinterpret_cast<const char*>(&data[offset]), 4);
+        const size_t        frameSize
+            = (majorVersion == 4) ? ReadSyncSafeInt(&data[offset + 4]) : ReadBigEndianInt(&data[offset + 4]);
+        if((offset + FRAME_HEADER_SIZE + frameSize) > dataSize)
+        {
+            break;
+        }
+
+        const uint8_t  formatFlags = data[offset + 9];
+        const uint8_t* payload     = &data[offset + FRAME_HEADER_SIZE];
+        size_t         payloadSize = frameSize;
+
+        bool supported      = true;
+        bool unsynchronized = false;
+        if(majorVersion == 4)
+        {
+            supported      = (formatFlags & 0x0c) == 0; // compression, encryption
+            unsynchronized = (formatFlags & 0x02) != 0;
+            if(((formatFlags & 0x40) != 0) && (payloadSize >= 1)) // group id
+            {
+                payload++;
+                payloadSize--;
+            }
+
+            if(((formatFlags & 0x01) != 0) && (payloadSize >= 4)) // data length indicator
+            {
+                payload += 4;
+                payloadSize -= 4;
+            }
+        }
+        else
+        {
+            supported = (formatFlags & 0xc0) == 0; // compression, encryption
+            if(((formatFlags & 0x20) != 0) && (payloadSize >= 1)) // group id
+            {
+                payload++;
+                payloadSize--;
+            }
+        }
+
+        if(true == supported)
+        {
+            if(true == unsynchronized)
+            {
+                const std::vector<uint8_t> resynchronized = Resynchronize(payload, payloadSize);
+                f(id, resynchronized.data(), resynchronized.size());
+            }
+            else
+            {
+                f(id, payload, payloadSize);
+            }
+        }
+
+        offset += FRAME_HEADER_SIZE + frameSize;
+    }
+}
+
+struct ImageFiles
+{
+    size_t                                      nextNumber = 1;
+    std::map<UnicodeString, std::future<bool>> writes;
+};
+
+static bool IsSameImage(const UnicodeString& imageName, const uint8_t* data, const size_t dataSize)
+{
+    bool isSameImage = false;
+
+    FileSize imageSize = 0;
+    if(ServiceSucceeded(FileManager::QueryFileSize(imageName, imageSize)) && (imageSize == dataSize))
+    {
+        BinaryStream* pImage = FileManager::ReadBinaryFile(imageName);
+        if(pImage != nullptr)
+        {
+            isSameImage = (pImage->DataSize() == dataSize) && (memcmp(pImage->Data(), data, dataSize) == 0);
+            SafeRelease(pImage);
+        }
+    }
+
+    return isSameImage;
+}
+
+// Embedded images are written next to the file as '<name>-chapter-<n>.<ext>', the chapter id is arbitrary tag data
+// and never becomes part of a path. An existing file is reused if it holds the same image, otherwise the next number
+// is tried, so files that weren't extracted from this tag are never overwritten.
+static UnicodeString ExtractImage(
+    const UnicodeString& filename, const uint8_t* data, const size_t dataSize, ImageFiles& imageFiles)
+{
+    static const size_t MAX_NAME_ATTEMPTS = 100;
+
+    UnicodeString imageName;
+
+    const Picture::FORMAT format = Picture::Format(data, dataSize);
+    if(format != Picture::FORMAT::UNKNOWN_PICTURE)
+    {
+        const UnicodeString prefix    = filename.substr(0, filename.rfind('.')) + "-chapter-";
+        const UnicodeString extension = (format == Picture::FORMAT::PNG) ? ".png" : ".jpg";
+
+        bool   isExisting = true;
+        size_t number     = imageFiles.nextNumber;
+        for(size_t i = 0; (imageName.empty() == true) && (i < MAX_NAME_ATTEMPTS); i++, number++)
+        {
+            const UnicodeString candidate = prefix + std::to_string(number) + extension;
+            if(FileManager::FileExists(candidate) == false)
+            {
+                imageName  = candidate;
+                isExisting = false;
+            }
+            else if(IsSameImage(candidate, data, dataSize) == true)
+            {
+                imageName = candidate;
+            }
+        }
+
+        imageFiles.nextNumber = number;
+
+        if((imageName.empty() == false) && (isExisting == false))
+        {
+            // The image is written in the background, the tag data doesn't outlive the parser.
+            BinaryStream* pImage = new BinaryStream(dataSize);
+            if(pImage->Write(0, data, dataSize) == true)
+            {
+                imageFiles.writes[imageName] = FileManager::WriteFileAsync(imageName, pImage);
+            }
+            else
+            {
+                imageName.clear();
+            }
+
+            SafeRelease(pImage);
+        }
+    }
+
+    return imageName;
+}
+
+static void ParseChapterFrame(
+    const UnicodeString& filename, const uint8_t majorVersion, const uint8_t* data, const size_t dataSize,
+    ChapterFrame& chapter, ImageFiles& imageFiles)
+{
+    const size_t idSize = SkipString(LATIN1_ENCODING, data, dataSize);
+    if((idSize + 16) <= dataSize)
+    {
+        chapter.id        = DecodeString(LATIN1_ENCODING, data, idSize);
+        chapter.startTime = ReadBigEndianInt(&data[idSize]);
+
+        const uint8_t* embeddedFrames = &data[idSize + 16];
+        ForEachFrame(
+            embeddedFrames, dataSize - idSize - 16, majorVersion,
+            [&](const UnicodeString& id, const uint8_t* payload, const size_t payloadSize) {
+                if(payloadSize < 1)
+                {
+                    return;
+                }
+
+                const uint8_t encoding = payload[0];
+                if(id == "TIT2")
+                {
+                    chapter.title = DecodeString(encoding, &payload[1], payloadSize - 1);
+                }
+                else if(id == "WXXX")
+                {
+                    const size_t urlOffset = 1 + SkipString(encoding, &payload[1], payloadSize - 1);
+                    chapter.url = DecodeString(LATIN1_ENCODING, &payload[urlOffset], payloadSize - urlOffset);
+                }
+                else if(id == "APIC")
+                {
+                    const uint8_t* mimeType     = &payload[1];
+                    const size_t   mimeTypeSize = SkipString(LATIN1_ENCODING, mimeType, payloadSize - 1);
+                    const size_t   typeOffset   = 1 + mimeTypeSize;
+                    if(typeOffset < payloadSize)
+                    {
+                        const size_t descriptionOffset = typeOffset + 1;
+                        const size_t pictureOffset
+                            = descriptionOffset
+                              + SkipString(encoding, &payload[descriptionOffset], payloadSize - descriptionOffset);
+                        const uint8_t* picture     = &payload[pictureOffset];
+                        const size_t   pictureSize = payloadSize - pictureOffset;
+                        if(DecodeString(LATIN1_ENCODING, mimeType, mimeTypeSize) == "-->") // linked image
+                        {
+                            chapter.image = DecodeString(LATIN1_ENCODING, picture, pictureSize);
+                        }
+                        else
+                        {
+                            chapter.image = ExtractImage(filename, picture, pictureSize, imageFiles);
+                        }
+                    }
+                }
+            });
+    }
+}
+
+static void ParseTableOfContentsFrame(const uint8_t* data, const size_t dataSize, TableOfContentsFrame& tableOfContents)
+{
+    size_t offset = SkipString(LATIN1_ENCODING, data, dataSize);
+    if((offset + 2) <= dataSize)
+    {
+        tableOfContents.id    = DecodeString(LATIN1_ENCODING, data, offset);
+        tableOfContents.flags = data[offset];
+
+        const size_t entryCount = data[offset + 1];
+        offset += 2;
+        for(size_t i = 0; (i < entryCount) && (offset < dataSize); i++)
+        {
+            const size_t entrySize = SkipString(LATIN1_ENCODING, &data[offset], dataSize - offset);
+            tableOfContents.children.push_back(DecodeString(LATIN1_ENCODING, &data[offset], entrySize));
+            offset += entrySize;
+        }
+    }
+}
+
+// Collects the chapters that are referenced by a table of contents and its nested tables of contents
+static void CollectChapters(
+    const UnicodeString& id, const std::map<UnicodeString, ChapterFrame>& chapters,
+    const std::map<UnicodeString, TableOfContentsFrame>& tablesOfContents, UnicodeStringArray& visitedIds,
+    std::vector<ChapterFrame>& result)
+{
+    if(std::find(visitedIds.begin(), visitedIds.end(), id) == visitedIds.end())
+    {
+        visitedIds.push_back(id);
+
+        const auto chapter = chapters.find(id);
+        if(chapter != chapters.end())
+        {
+            result.push_back(chapter->second);
+        }
+        else
+        {
+            const auto tableOfContents = tablesOfContents.find(id);
+            if(tableOfContents != tablesOfContents.end())
+            {
+                std::for_each(
+                    tableOfContents->second.children.begin(), tableOfContents->second.children.end(),
+                    [&](const UnicodeString& childId) {
+                        CollectChapters(childId, chapters, tablesOfContents, visitedIds, result);
+                    });
+            }
+        }
+    }
+}
+
+struct TagFrames
+{
+    std::map<UnicodeString, ChapterFrame>         chapters;
+    std::map<UnicodeString, TableOfContentsFrame> tablesOfContents;
+    UnicodeString                                 topLevelId;
+    ImageFiles                                    imageFiles;
+};
+
+static bool ReadTag(
+    const UnicodeString& filename, const FileOffset offset, const size_t size, std::vector<uint8_t>& tagData)
+{
+    std::ifstream file(U2H(filename), std::ios::in | std::ios::binary);
+    PRECONDITION_RETURN(file.is_open() == true, false);
+
+    tagData.resize(size);
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(tagData.data()), tagData.size());
+    const bool success = (file.gcount() == static_cast<std::streamsize>(tagData.size()));
+    file.close();
+
+    return success;
+}
+
+static void ParseTag(const UnicodeString& filename, const std::vector<uint8_t>& tagData, TagFrames& tagFrames)
+{
+    PRECONDITION(tagData.size() > ID3V2_HEADER_SIZE);
+    PRECONDITION(memcmp(tagData.data(), "ID3", 3) == 0);
+
+    const uint8_t majorVersion = tagData[3];
+    const uint8_t flags        = tagData[5];
+    PRECONDITION((majorVersion == 3) || (majorVersion == 4));
+
+    const size_t         frameDataEnd = std::min(tagData.size(), ID3V2_HEADER_SIZE + ReadSyncSafeInt(&tagData[6]));
+    std::vector<uint8_t> frameData(tagData.begin() + ID3V2_HEADER_SIZE, tagData.begin() + frameDataEnd);
+    if((majorVersion == 3) && ((flags & 0x80) != 0)) // v2.4 tags are unsynchronized per frame
+    {
+        frameData = Resynchronize(frameData.data(), frameData.size());
+    }
+
+    size_t offset = 0;
+    if(((flags & 0x40) != 0) && (frameData.size() >= 4)) // extended header
+    {
+        offset = (majorVersion == 3) ? (4 + ReadBigEndianInt(frameData.data())) : ReadSyncSafeInt(frameData.data());
+    }
+
+    PRECONDITION(offset < frameData.size());
+
+    ForEachFrame(
+        &frameData[offset], frameData.size() - offset, majorVersion,
+        [&](const UnicodeString& id, const uint8_t* payload, const size_t payloadSize) {
+            if(id == "CHAP")
+            {
+                ChapterFrame chapter;
+                ParseChapterFrame(filename, majorVersion, payload, payloadSize, chapter, tagFrames.imageFiles);
+                if(chapter.id.empty() == false)
+                {
+                    tagFrames.chapters[chapter.id] = chapter;
+                }
+            }
+            else if(id == "CTOC")
+            {
+                TableOfContentsFrame tableOfContents;
+                ParseTableOfContentsFrame(payload, payloadSize, tableOfContents);
+                if(tableOfContents.id.empty() == false)
+                {
+                    if((tagFrames.topLevelId.empty() == true) && ((tableOfContents.flags & TOP_LEVEL_TOC) != 0))
+                    {
+                        tagFrames.topLevelId = tableOfContents.id;
+                    }
+
+                    tagFrames.tablesOfContents[tableOfContents.id] = tableOfContents;
+                }
+            }
+        });
+}
+
+ChapterTagArray ID3V2ReadChapterMarkers(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, ChapterTagArray());
+
+    TagFrames            tagFrames;
+    std::vector<uint8_t> tagData;
+
+    size_t tagSize = 0;
+    if(ServiceSucceeded(ID3V2QueryTagSize(filename, tagSize)) && (tagSize > ID3V2_HEADER_SIZE)
+       && (ReadTag(filename, 0, tagSize, tagData) == true))
+    {
+        ParseTag(filename, tagData, tagFrames);
+    }
+
+    // Chapters and pictures may have been moved to a tag at the end of the file
+    size_t   appendedTagSize = 0;
+    FileSize fileSize        = 0;
+    if(ServiceSucceeded(ID3V2QueryAppendedTagSize(filename, appendedTagSize)) && (appendedTagSize > 0)
+       && ServiceSucceeded(FileManager::QueryFileSize(filename, fileSize))
+       && (ReadTag(filename, fileSize - appendedTagSize, appendedTagSize, tagData) == true))
+    {
+        ParseTag(filename, tagData, tagFrames);
+    }
+
+    // Chapters whose image couldn't be written are imported without it
+    for(std::map<UnicodeString, std::future<bool>>::iterator i = tagFrames.imageFiles.writes.begin();
+        i != tagFrames.imageFiles.writes.end(); i++)
+    {
+        if(i->second.get() == false)
+        {
+            for(std::map<UnicodeString, ChapterFrame>::iterator j = tagFrames.chapters.begin();
+                j != tagFrames.chapters.end(); j++)
+            {
+                if(j->second.image == i->first)
+                {
+                    j->second.image.clear();
+                }
+            }
+        }
+    }
+
+    const std::map<UnicodeString, ChapterFrame>&         chapters         = tagFrames.chapters;
+    const std::map<UnicodeString, TableOfContentsFrame>& tablesOfContents = tagFrames.tablesOfContents;
+    const UnicodeString&                                 topLevelId       = tagFrames.topLevelId;
+
+    // Without a top-level table of contents all chapters are imported
+    std::vector<ChapterFrame> selectedChapters;
+    if(topLevelId.empty() == false)
+    {
+        UnicodeStringArray visitedIds;
+        CollectChapters(topLevelId, chapters, tablesOfContents, visitedIds, selectedChapters);
+    }
+    else
+    {
+        std::for_each(chapters.begin(), chapters.end(), [&](const std::pair<UnicodeString, ChapterFrame>& chapter) {
+            selectedChapters.push_back(chapter.second);
+        });
+    }
+
+    std::stable_sort(
+        selectedChapters.begin(), selectedChapters.end(),
+        [](const ChapterFrame& lhs, const ChapterFrame& rhs) { return lhs.startTime < rhs.startTime; });
+
+    ChapterTagArray chapterMarkers;
+    chapterMarkers.reserve(selectedChapters.size());
+    std::for_each(selectedChapters.begin(), selectedChapters.end(), [&](const ChapterFrame& chapter) {
+        if(chapter.startTime != INVALID_POSITION)
+        {
+            chapterMarkers.push_back(
+                ChapterTag(static_cast<double>(chapter.startTime) / 1000, chapter.title, chapter.image, chapter.url));
+        }
+    });
+
+    return chapterMarkers;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,677 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ID3V2Serializer.h"
+
+namespace ultraschall { namespace reaper {
+
+static const size_t FRAME_HEADER_SIZE = 10;
+
+static uint32_t NextCodePoint(const UnicodeString& str, size_t& offset)
+{
+    const uint8_t lead       = static_cast<uint8_t>(str[offset++]);
+    uint32_t      codePoint  = lead;
+    const size_t  trailCount = (lead >= 0xf0) ? 3 : ((lead >= 0xe0) ? 2 : ((lead >= 0xc0) ? 1 : 0));
+    if(trailCount > 0)
+    {
+        codePoint = lead & (0x3f >> trailCount);
+        for(size_t i = 0; (i < trailCount) && (offset < str.size()) && ((str[offset] & 0xc0) == 0x80); i++)
+        {
+            codePoint = (codePoint << 6) | (str[offset++] & 0x3f);
+        }
+    }
+
+    return codePoint;
+}
+
+static size_t Utf16Size(const UnicodeString& str)
+{
+    size_t size   = 0;
+    size_t offset = 0;
+    while(offset < str.size())
+    {
+        size += (NextCodePoint(str, offset) >= 0x10000) ? 4 : 2;
+    }
+
+    return size;
+}
+
+static size_t Latin1Size(const UnicodeString& str)
+{
+    size_t size   = 0;
+    size_t offset = 0;
+    while(offset < str.size())
+    {
+        NextCodePoint(str, offset);
+        size++;
+    }
+
+    return size;
+}
+
+static uint8_t* WriteUtf16(uint8_t* cursor, const UnicodeString& str)
+{
+    size_t offset = 0;
+    while(offset < str.size())
+    {
+        uint32_t codePoint = NextCodePoint(str, offset);
+        if(codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            const uint16_t highSurrogate = static_cast<uint16_t>(0xd800 + (codePoint >> 10));
+            *cursor++                    = static_cast<uint8_t>(highSurrogate & 0xff);
+            *cursor++                    = static_cast<uint8_t>(highSurrogate >> 8);
+            codePoint                    = 0xdc00 + (codePoint & 0x3ff);
+        }
+
+        *cursor++ = static_cast<uint8_t>(codePoint & 0xff);
+        *cursor++ = static_cast<uint8_t>((codePoint >> 8) & 0xff);
+    }
+
+    return cursor;
+}
+
+static uint8_t* WriteLatin1(uint8_t* cursor, const UnicodeString& str)
+{
+    size_t offset = 0;
+    while(offset < str.size())
+    {
+        const uint32_t codePoint = NextCodePoint(str, offset);
+        *cursor++                = (codePoint <= 0xff) ? static_cast<uint8_t>(codePoint) : '?';
+    }
+
+    return cursor;
+}
+
+static uint8_t* WriteBigEndianInt(uint8_t* cursor, const uint32_t value)
+{
+    *cursor++ = static_cast<uint8_t>(value >> 24);
+    *cursor++ = static_cast<uint8_t>(value >> 16);
+    *cursor++ = static_cast<uint8_t>(value >> 8);
+    *cursor++ = static_cast<uint8_t>(value);
+    return cursor;
+}
+
+static uint8_t* WriteSyncSafeInt(uint8_t* cursor, const uint32_t value)
+{
+    *cursor++ = static_cast<uint8_t>((value >> 21) & 0x7f);
+    *cursor++ = static_cast<uint8_t>((value >> 14) & 0x7f);
+    *cursor++ = static_cast<uint8_t>((value >> 7) & 0x7f);
+    *cursor++ = static_cast<uint8_t>(value & 0x7f);
+    return cursor;
+}
+
+static uint8_t* WriteFrameSize(uint8_t* cursor, const uint32_t value, const uint8_t majorVersion)
+{
+    return (majorVersion == 4) ? WriteSyncSafeInt(cursor, value) : WriteBigEndianInt(cursor, value);
+}
+
+static uint8_t* WriteUtf16Bom(uint8_t* cursor)
+{
+    *cursor++ = 0xff;
+    *cursor++ = 0xfe;
+    return cursor;
+}
+
+static uint32_t ReadBigEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint32_t ReadSyncSafeInt(const uint8_t* data)
+{
+    return ((data[0] & 0x7f) << 21) | ((data[1] & 0x7f) << 14) | ((data[2] & 0x7f) << 7) | (data[3] & 0x7f);
+}
+
+ID3V2Serializer::~ID3V2Serializer()
+{
+    for(size_t i = 0; i < images_.size(); i++)
+    {
+        SafeRelease(images_[i]);
+    }
+}
+
+bool ID3V2Serializer::InsertTextFrame(const UnicodeString& id, const UnicodeString& text, const CHAR_ENCODING encoding)
+{
+    PRECONDITION_RETURN(id.size() == 4, false);
+
+    if(text.empty() == false)
+    {
+        Frame frame(FRAME_TYPE::TEXT, id);
+        frame.encoding = encoding;
+        frame.text     = text;
+        frames_.push_back(frame);
+    }
+
+    return true;
+}
+
+bool ID3V2Serializer::InsertCommentsFrame(const UnicodeString& text)
+{
+    if(text.empty() == false)
+    {
+        Frame frame(FRAME_TYPE::COMMENTS, "COMM");
+        frame.text = text;
+        frames_.push_back(frame);
+    }
+
+    return true;
+}
+
+bool ID3V2Serializer::CreatePictureFrame(const UnicodeString& image, Frame& frame)
+{
+    PRECONDITION_RETURN(image.empty() == false, false);
+
+    bool success = false;
+
+    // The serializer keeps the image referenced until the rendered segments have been committed.
+    Image* pImage = ImageCache::Instance().Lookup(image);
+    if(pImage != nullptr)
+    {
+        if(pImage->MimeType().empty() == false)
+        {
+            frame.mimeType    = pImage->MimeType();
+            frame.payload     = pImage->Data();
+            frame.payloadSize = pImage->DataSize();
+            images_.push_back(pImage);
+            success = true;
+        }
+        else
+        {
+            SafeRelease(pImage);
+        }
+    }
+
+    return success;
+}
+
+bool ID3V2Serializer::InsertPictureFrame(const UnicodeString& image)
+{
+    PRECONDITION_RETURN(image.empty() == false, false);
+
+    bool success = false;
+
+    Frame frame(FRAME_TYPE::PICTURE, "APIC");
+    if(CreatePictureFrame(image, frame) == true)
+    {
+        imageSize_ += frame.payloadSize;
+        frames_.push_back(frame);
+        success = true;
+    }
+
+    return success;
+}
+
+bool ID3V2Serializer::InsertChapterFrame(
+    const UnicodeString& id, const UnicodeString& text, const uint32_t startTime, const uint32_t endTime,
+    const UnicodeString& image, const UnicodeString& url)
+{
+    PRECONDITION_RETURN(id.empty() == false, false);
+    PRECONDITION_RETURN(text.empty() == false, false);
+    PRECONDITION_RETURN(startTime != 0xffffffff, false);
+    PRECONDITION_RETURN(endTime != 0xffffffff, false);
+
+    Frame frame(FRAME_TYPE::CHAPTER, "CHAP");
+    frame.text      = id;
+    frame.startTime = startTime;
+    frame.endTime   = endTime;
+
+    Frame titleFrame(FRAME_TYPE::TEXT, "TIT2");
+    titleFrame.encoding = UTF16;
+    titleFrame.text     = text;
+    frame.embeddedFrames.push_back(titleFrame);
+
+    if(url.empty() == false)
+    {
+        Frame urlFrame(FRAME_TYPE::URL, "WXXX");
+        urlFrame.description = "chapter url";
+        urlFrame.text        = url;
+        frame.embeddedFrames.push_back(urlFrame);
+    }
+
+    if(image.empty() == false)
+    {
+        Frame pictureFrame(FRAME_TYPE::PICTURE, "APIC");
+        if(CreatePictureFrame(image, pictureFrame) == true)
+        {
+            imageSize_ += pictureFrame.payloadSize;
+            frame.embeddedFrames.push_back(pictureFrame);
+        }
+    }
+
+    frames_.push_back(frame);
+    chapterCount_++;
+
+    return true;
+}
+
+void ID3V2Serializer::UpdateChapterOffsets(
+    const MP3FrameIndex& frameIndex, const size_t originalTagSize, const size_t tagSize)
+{
+    // The audio data moves from behind the original tag to behind the new one.
+    const auto fileOffset = [&](const uint32_t time) -> uint32_t {
+        FileOffset offset = 0;
+        if((frameIndex.QueryOffset(time, offset) == false) || (offset < originalTagSize)
+           || ((offset - originalTagSize + tagSize) >= 0xffffffff))
+        {
+            return 0xffffffff;
+        }
+
+        return static_cast<uint32_t>(offset - originalTagSize + tagSize);
+    };
+
+    std::for_each(frames_.begin(), frames_.end(), [&](Frame& frame) {
+        if(frame.type == FRAME_TYPE::CHAPTER)
+        {
+            frame.startOffset = fileOffset(frame.startTime);
+            frame.endOffset   = fileOffset(frame.endTime);
+        }
+    });
+}
+
+// The entry count of a CTOC frame is a single byte. Longer lists are split into nested tables of
+// contents that the top-level table of contents refers to.
+bool ID3V2Serializer::InsertTableOfContentsFrame(const UnicodeStringArray& tableOfContentsItems)
+{
+    static const size_t MAX_ENTRY_COUNT = 255;
+    PRECONDITION_RETURN(tableOfContentsItems.empty() == false, false);
+    PRECONDITION_RETURN(tableOfContentsItems.size() <= (MAX_ENTRY_COUNT * MAX_ENTRY_COUNT), false);
+
+    Frame frame(FRAME_TYPE::TABLE_OF_CONTENTS, "CTOC");
+    frame.text = "toc";
+    if(tableOfContentsItems.size() <= MAX_ENTRY_COUNT)
+    {
+        frame.children = tableOfContentsItems;
+    }
+    else
+    {
+        for(size_t i = 0; i < tableOfContentsItems.size(); i += MAX_ENTRY_COUNT)
+        {
+            const size_t itemsEnd = std::min(i + MAX_ENTRY_COUNT, tableOfContentsItems.size());
+
+            Frame childFrame(FRAME_TYPE::TABLE_OF_CONTENTS, "CTOC");
+            childFrame.text       = "toc" + std::to_string(frame.children.size());
+            childFrame.isTopLevel = false;
+            childFrame.children.assign(tableOfContentsItems.begin() + i, tableOfContentsItems.begin() + itemsEnd);
+            frame.children.push_back(childFrame.text);
+            frames_.push_back(childFrame);
+        }
+    }
+
+    frames_.push_back(frame);
+
+    return true;
+}
+
+bool ID3V2Serializer::InsertExistingFrames(
+    const uint8_t* tagData, const size_t tagDataSize, const UnicodeStringArray& excludedFrameIds)
+{
+    PRECONDITION_RETURN(tagData != nullptr, false);
+    PRECONDITION_RETURN(tagDataSize >= ID3V2_HEADER_SIZE, false);
+    PRECONDITION_RETURN((tagData[0] == 'I') && (tagData[1] == 'D') && (tagData[2] == '3'), false);
+
+    // Frames of other versions or unsynchronized tags can't be copied verbatim
+    const uint8_t majorVersion = tagData[3];
+    PRECONDITION_RETURN((majorVersion == 3) || (majorVersion == 4), false);
+    PRECONDITION_RETURN((tagData[5] & 0x80) == 0, false);
+
+    const size_t tagEnd = std::min(tagDataSize, ID3V2_HEADER_SIZE + ReadSyncSafeInt(&tagData[6]));
+    size_t       offset = ID3V2_HEADER_SIZE;
+    if(((tagData[5] & 0x40) != 0) && ((offset + 4) <= tagEnd))
+    {
+        offset += (majorVersion == 3) ? (4 + ReadBigEndianInt(&tagData[offset])) : ReadSyncSafeInt(&tagData[offset]);
+    }
+
+    while(((offset + FRAME_HEADER_SIZE) <= tagEnd) && (tagData[offset] != 0))
+    {
+        const UnicodeString id(reinterpret_cast<const char*>(&tagData[offset]), 4);
+        const size_t        frameSize = FRAME_HEADER_SIZE
+                                 + ((majorVersion == 3) ? ReadBigEndianInt(&tagData[offset + 4]) :
+                                                          ReadSyncSafeInt(&tagData[offset + 4]));
+        if((offset + frameSize) > tagEnd)
+        {
+            break;
+        }
+
+        // The format flags of ID3v2.4 frames (unsynchronization, data length indicator, ...) and of ID3v2.3
+        // frames (compression, encryption, grouping) change the layout of the payload, such frames are only
+        // copied into tags of the same version.
+        const uint8_t formatFlags = tagData[offset + 9];
+        if(std::find(excludedFrameIds.begin(), excludedFrameIds.end(), id) == excludedFrameIds.end())
+        {
+            Frame frame(FRAME_TYPE::RAW, id);
+            frame.version       = majorVersion;
+            frame.isConvertible = (majorVersion == 3) ? ((formatFlags & 0xe0) == 0) : (formatFlags == 0);
+            frame.raw.assign(&tagData[offset], &tagData[offset + frameSize]);
+            frames_.push_back(frame);
+        }
+
+        offset += frameSize;
+    }
+
+    return true;
+}
+
+size_t ID3V2Serializer::PayloadSize(const Frame& frame)
+{
+    size_t payloadSize = 0;
+
+    switch(frame.type)
+    {
+        case FRAME_TYPE::TEXT:
+            payloadSize = 1 + ((frame.encoding == UTF16) ? (2 + Utf16Size(frame.text)) : Latin1Size(frame.text));
+            break;
+        case FRAME_TYPE::COMMENTS:
+            payloadSize = 1 + 3 + 4 + 2 + Utf16Size(frame.text);
+            break;
+        case FRAME_TYPE::PICTURE:
+            payloadSize = 1 + Latin1Size(frame.mimeType) + 1 + 1 + 1 + frame.payloadSize;
+            break;
+        case FRAME_TYPE::URL:
+            payloadSize = 1 + Latin1Size(frame.description) + 1 + Latin1Size(frame.text);
+            break;
+        case FRAME_TYPE::CHAPTER:
+            payloadSize = Latin1Size(frame.text) + 1 + 16;
+            std::for_each(frame.embeddedFrames.begin(), frame.embeddedFrames.end(), [&](const Frame& embeddedFrame) {
+                payloadSize += FrameSize(embeddedFrame);
+            });
+            break;
+        case FRAME_TYPE::TABLE_OF_CONTENTS:
+            payloadSize = Latin1Size(frame.text) + 1 + 2;
+            std::for_each(frame.children.begin(), frame.children.end(), [&](const UnicodeString& child) {
+                payloadSize += Latin1Size(child) + 1;
+            });
+            break;
+        case FRAME_TYPE::SEEK:
+            payloadSize = 4;
+            break;
+        case FRAME_TYPE::RAW:
+            payloadSize = frame.raw.size() - FRAME_HEADER_SIZE;
+            break;
+        default:
+            break;
+    }
+
+    return payloadSize;
+}
+
+size_t ID3V2Serializer::FrameSize(const Frame& frame)
+{
+    return FRAME_HEADER_SIZE + PayloadSize(frame);
+}
+
+size_t ID3V2Serializer::BufferSize(const Frame& frame)
+{
+    size_t bufferSize = FrameSize(frame);
+    if(frame.type == FRAME_TYPE::PICTURE)
+    {
+        bufferSize -= frame.payloadSize;
+    }
+    else if(frame.type == FRAME_TYPE::CHAPTER)
+    {
+        std::for_each(frame.embeddedFrames.begin(), frame.embeddedFrames.end(), [&](const Frame& embeddedFrame) {
+            bufferSize -= (FrameSize(embeddedFrame) - BufferSize(embeddedFrame));
+        });
+    }
+
+    return bufferSize;
+}
+
+size_t ID3V2Serializer::TagSize() const
+{
+    size_t tagSize = ID3V2_HEADER_SIZE;
+    std::for_each(frames_.begin(), frames_.end(), [&](const Frame& frame) {
+        if(IsRenderedFrame(frame, 3) == true)
+        {
+            tagSize += FrameSize(frame);
+        }
+    });
+
+    return tagSize;
+}
+
+size_t ID3V2Serializer::ChapterCount() const
+{
+    return chapterCount_;
+}
+
+size_t ID3V2Serializer::ImageSize() const
+{
+    return imageSize_;
+}
+
+uint8_t* ID3V2Serializer::RenderFrame(
+    const Frame& frame, const uint8_t majorVersion, uint8_t* cursor, const uint8_t*& segmentStart,
+    ID3V2TagSegmentArray& segments)
+{
+    if(frame.type == FRAME_TYPE::RAW)
+    {
+        memcpy(cursor, frame.raw.data(), frame.raw.size());
+        if(frame.version != majorVersion)
+        {
+            // The status flags of both versions differ as well, they are dropped.
+            WriteFrameSize(cursor + 4, static_cast<uint32_t>(PayloadSize(frame)), majorVersion);
+            cursor[8] = 0;
+            cursor[9] = 0;
+        }
+
+        return cursor + frame.raw.size();
+    }
+
+    // TYER has been replaced by TDRC in ID3v2.4, both take the same text.
+    const bool isRecordingTime = (majorVersion == 4) && (frame.id == "TYER");
+    memcpy(cursor, (true == isRecordingTime) ? "TDRC" : frame.id.c_str(), 4);
+    cursor    = WriteFrameSize(cursor + 4, static_cast<uint32_t>(PayloadSize(frame)), majorVersion);
+    *cursor++ = 0; // flags
+    *cursor++ = 0;
+
+    switch(frame.type)
+    {
+        case FRAME_TYPE::TEXT:
+            if(frame.encoding == UTF16)
+            {
+                *cursor++ = 1;
+                cursor    = WriteUtf16(WriteUtf16Bom(cursor), frame.text);
+            }
+            else
+            {
+                *cursor++ = 0;
+                cursor    = WriteLatin1(cursor, frame.text);
+            }
+            break;
+        case FRAME_TYPE::COMMENTS:
+            *cursor++ = 1;
+            memcpy(cursor, "eng", 3);
+            cursor    = WriteUtf16Bom(cursor + 3); // empty description
+            *cursor++ = 0;
+            *cursor++ = 0;
+            cursor    = WriteUtf16(WriteUtf16Bom(cursor), frame.text);
+            break;
+        case FRAME_TYPE::PICTURE:
+            *cursor++ = 0;
+            cursor    = WriteLatin1(cursor, frame.mimeType);
+            *cursor++ = 0;
+            *cursor++ = 0; // picture type 'Other'
+            *cursor++ = 0; // empty description
+            segments.push_back(ID3V2TagSegment(segmentStart, cursor - segmentStart));
+            segments.push_back(ID3V2TagSegment(frame.payload, frame.payloadSize));
+            segmentStart = cursor;
+            break;
+        case FRAME_TYPE::URL:
+            *cursor++ = 0;
+            cursor    = WriteLatin1(cursor, frame.description);
+            *cursor++ = 0;
+            cursor    = WriteLatin1(cursor, frame.text);
+            break;
+        case FRAME_TYPE::CHAPTER:
+            cursor    = WriteLatin1(cursor, frame.text);
+            *cursor++ = 0;
+            cursor    = WriteBigEndianInt(cursor, frame.startTime);
+            cursor    = WriteBigEndianInt(cursor, frame.endTime);
+            cursor    = WriteBigEndianInt(cursor, frame.startOffset);
+            cursor    = WriteBigEndianInt(cursor, frame.endOffset);
+            for(size_t i = 0; i < frame.embeddedFrames.size(); i++)
+            {
+                cursor = RenderFrame(frame.embeddedFrames[i], majorVersion, cursor, segmentStart, segments);
+            }
+            break;
+        case FRAME_TYPE::TABLE_OF_CONTENTS:
+            cursor    = WriteLatin1(cursor, frame.text);
+            *cursor++ = 0;
+            *cursor++ = (true == frame.isTopLevel) ? 0x03 : 0x01; // top-level, ordered
+            *cursor++ = static_cast<uint8_t>(frame.children.size());
+            for(size_t i = 0; i < frame.children.size(); i++)
+            {
+                cursor    = WriteLatin1(cursor, frame.children[i]);
+                *cursor++ = 0;
+            }
+            break;
+        case FRAME_TYPE::SEEK:
+            cursor = WriteBigEndianInt(cursor, frame.startOffset);
+            break;
+        default:
+            break;
+    }
+
+    return cursor;
+}
+
+bool ID3V2Serializer::IsRenderedFrame(const Frame& frame, const uint8_t majorVersion)
+{
+    return (frame.type != FRAME_TYPE::RAW) || (frame.isConvertible == true) || (frame.version == majorVersion);
+}
+
+bool ID3V2Serializer::IsAppendedFrame(const Frame& frame)
+{
+    return (frame.type == FRAME_TYPE::PICTURE) || (frame.type == FRAME_TYPE::CHAPTER)
+           || (frame.type == FRAME_TYPE::TABLE_OF_CONTENTS);
+}
+
+size_t ID3V2Serializer::FrontTagSize() const
+{
+    size_t tagSize = ID3V2_HEADER_SIZE + FRAME_HEADER_SIZE + 4; // SEEK
+    std::for_each(frames_.begin(), frames_.end(), [&](const Frame& frame) {
+        if((IsAppendedFrame(frame) == false) && (IsRenderedFrame(frame, 4) == true))
+        {
+            tagSize += FrameSize(frame);
+        }
+    });
+
+    return tagSize;
+}
+
+bool ID3V2Serializer::RenderTag(
+    const std::vector<const Frame*>& frames, const uint8_t majorVersion, const bool hasFooter,
+    std::vector<uint8_t>& buffer, ID3V2TagSegmentArray& segments)
+{
+    segments.clear();
+
+    size_t frameDataSize = 0;
+    size_t bufferSize    = ID3V2_HEADER_SIZE + (hasFooter ? ID3V2_HEADER_SIZE : 0);
+    std::for_each(frames.begin(), frames.end(), [&](const Frame* pFrame) {
+        frameDataSize += FrameSize(*pFrame);
+        bufferSize += BufferSize(*pFrame);
+    });
+
+    PRECONDITION_RETURN(frameDataSize <= 0x0fffffff, false);
+
+    buffer.assign(bufferSize, 0);
+
+    uint8_t* cursor = buffer.data();
+    *cursor++       = 'I';
+    *cursor++       = 'D';
+    *cursor++       = '3';
+    *cursor++       = majorVersion;
+    *cursor++       = 0;
+    *cursor++       = hasFooter ? 0x10 : 0; // flags
+    cursor          = WriteSyncSafeInt(cursor, static_cast<uint32_t>(frameDataSize));
+
+    const uint8_t* segmentStart = buffer.data();
+    for(size_t i = 0; i < frames.size(); i++)
+    {
+        cursor = RenderFrame(*frames[i], majorVersion, cursor, segmentStart, segments);
+    }
+
+    if(true == hasFooter)
+    {
+        memcpy(cursor, buffer.data(), ID3V2_HEADER_SIZE);
+        memcpy(cursor, "3DI", 3);
+        cursor += ID3V2_HEADER_SIZE;
+    }
+
+    if(cursor > segmentStart)
+    {
+        segments.push_back(ID3V2TagSegment(segmentStart, cursor - segmentStart));
+    }
+
+    return cursor == (buffer.data() + bufferSize);
+}
+
+bool ID3V2Serializer::Render(ID3V2TagSegmentArray& segments)
+{
+    std::vector<const Frame*> frames;
+    frames.reserve(frames_.size());
+    std::for_each(frames_.begin(), frames_.end(), [&](const Frame& frame) {
+        if(IsRenderedFrame(frame, 3) == true)
+        {
+            frames.push_back(&frame);
+        }
+    });
+
+    return RenderTag(frames, 3, false, buffer_, segments);
+}
+
+bool ID3V2Serializer::Render(
+    ID3V2TagSegmentArray& frontSegments, ID3V2TagSegmentArray& appendedSegments, const uint32_t seekOffset)
+{
+    Frame seekFrame(FRAME_TYPE::SEEK, "SEEK");
+    seekFrame.startOffset = seekOffset;
+
+    std::vector<const Frame*> frontFrames;
+    std::vector<const Frame*> appendedFrames;
+    std::for_each(frames_.begin(), frames_.end(), [&](const Frame& frame) {
+        if(IsRenderedFrame(frame, 4) == false)
+        {
+            return;
+        }
+
+        if(IsAppendedFrame(frame) == true)
+        {
+            appendedFrames.push_back(&frame);
+        }
+        else
+        {
+            frontFrames.push_back(&frame);
+        }
+    });
+
+    frontFrames.push_back(&seekFrame);
+
+    return RenderTag(frontFrames, 4, false, buffer_, frontSegments)
+           && RenderTag(appendedFrames, 4, true, appendedBuffer_, appendedSegments);
+}
+
+}} // namespace ultraschall::reaper
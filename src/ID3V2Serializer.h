@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_ID3V2_SERIALIZER_H_INCL__
+#define __ULTRASCHALL_REAPER_ID3V2_SERIALIZER_H_INCL__
+
+#include "Common.h"
+#include "ID3V2Commit.h"
+#include "ImageCache.h"
+#include "MP3FrameIndex.h"
+
+namespace ultraschall { namespace reaper {
+
+// Serializes ID3v2.3 tags without intermediate frame objects. Frames are recorded first,
+// the exact tag size is known before rendering and all headers and text fields are written
+// into a single buffer. Picture payloads are not copied, they become segments that point
+// into the shared buffers of the image cache.
+class ID3V2Serializer
+{
+public:
+    ~ID3V2Serializer();
+
+    bool InsertTextFrame(const UnicodeString& id, const UnicodeString& text, const CHAR_ENCODING encoding);
+    bool InsertCommentsFrame(const UnicodeString& text);
+    bool InsertPictureFrame(const UnicodeString& image);
+    bool InsertChapterFrame(
+        const UnicodeString& id, const UnicodeString& text, const uint32_t startTime, const uint32_t endTime,
+        const UnicodeString& image, const UnicodeString& url);
+    bool InsertTableOfContentsFrame(const UnicodeStringArray& tableOfContentsItems);
+
+    // Fills the byte offsets of all chapters for a file that starts with a tag of tagSize bytes
+    void UpdateChapterOffsets(const MP3FrameIndex& frameIndex, const size_t originalTagSize, const size_t tagSize);
+
+    // Copies all frames of an existing ID3v2.3 or ID3v2.4 tag that are not listed in excludedFrameIds. Frames whose
+    // format flags change the payload layout are only rendered into tags of their own version.
+    bool InsertExistingFrames(
+        const uint8_t* tagData, const size_t tagDataSize, const UnicodeStringArray& excludedFrameIds);
+
+    size_t TagSize() const;
+    size_t ChapterCount() const;
+    size_t ImageSize() const;
+
+    // Renders an ID3v2.3 tag with all frames
+    bool Render(ID3V2TagSegmentArray& segments);
+
+    // Renders an ID3v2.4 tag for the front of the file with a SEEK frame that points seekOffset bytes
+    // behind its end, and an ID3v2.4 tag with footer for the end of the file. Pictures, chapters and
+    // the table of contents go into the appended tag.
+    bool Render(
+        ID3V2TagSegmentArray& frontSegments, ID3V2TagSegmentArray& appendedSegments, const uint32_t seekOffset);
+    size_t FrontTagSize() const;
+
+private:
+    enum class FRAME_TYPE
+    {
+        TEXT,
+        COMMENTS,
+        PICTURE,
+        URL,
+        CHAPTER,
+        TABLE_OF_CONTENTS,
+        SEEK,
+        RAW,
+        MAX_FRAME_TYPE = RAW
+    };
+
+    struct Frame
+    {
+        FRAME_TYPE           type;
+        UnicodeString        id;
+        CHAR_ENCODING        encoding = UTF8;
+        UnicodeString        text;
+        UnicodeString        description;
+        UnicodeString        mimeType;
+        const uint8_t*       payload       = nullptr;
+        size_t               payloadSize   = 0;
+        uint32_t             startTime     = 0;
+        uint32_t             endTime       = 0;
+        uint32_t             startOffset   = 0xffffffff; // offset of the next tag for SEEK frames
+        uint32_t             endOffset     = 0xffffffff;
+        uint8_t              version       = 3;    // of RAW frames
+        bool                 isConvertible = true; // RAW frames that can be rendered with a different version
+        bool                 isTopLevel    = true; // of TABLE_OF_CONTENTS frames
+        UnicodeStringArray   children;
+        std::vector<Frame>   embeddedFrames;
+        std::vector<uint8_t> raw;
+
+        Frame(const FRAME_TYPE frameType, const UnicodeString& frameId) : type(frameType), id(frameId) {}
+    };
+
+    std::vector<Frame>   frames_;
+    std::vector<uint8_t> buffer_;
+    std::vector<uint8_t> appendedBuffer_;
+    std::vector<Image*>  images_;
+    size_t               chapterCount_ = 0;
+    size_t               imageSize_    = 0;
+
+    bool CreatePictureFrame(const UnicodeString& image, Frame& frame);
+
+    static size_t FrameSize(const Frame& frame);
+    static size_t PayloadSize(const Frame& frame);
+
+    static bool     IsRenderedFrame(const Frame& frame, const uint8_t majorVersion);
+    static bool     IsAppendedFrame(const Frame& frame);
+    static size_t   BufferSize(const Frame& frame);
+    static uint8_t* RenderFrame(
+        const Frame& frame, const uint8_t majorVersion, uint8_t* cursor, const uint8_t*& segmentStart,
+        ID3V2TagSegmentArray& segments);
+    static bool RenderTag(
+        const std::vector<const Frame*>& frames, const uint8_t majorVersion, const bool hasFooter,
+        std::vector<uint8_t>& buffer, ID3V2TagSegmentArray& segments);
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_ID3V2_SERIALIZER_H_INCL__
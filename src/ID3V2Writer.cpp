@@ -53,18 +53,22 @@ bool ID3V2Writer::Start(const UnicodeString& targetName)
   return contextStarted;
 }
 
-void ID3V2Writer::Stop(const bool commit)
+bool ID3V2Writer::Stop(const bool commit)
 {
-  PRECONDITION(pContext_ != nullptr);
+  PRECONDITION_RETURN(pContext_ != nullptr, false);
+
+  bool success = true;
 
   if(true == commit)
   {
-    ID3V2CommitTransaction(pContext_);
+    success = ID3V2CommitTransaction(pContext_, paddingPolicy_, commitStrategy_);
   }
   else
   {
     ID3V2AbortTransaction(pContext_);
   }
+
+  return success;
 }
 
 bool ID3V2Writer::InsertProperties(const UnicodeString& targetName, const UnicodeStringDictionary& mediaData)
@@ -81,7 +85,7 @@ bool ID3V2Writer::InsertProperties(const UnicodeString& targetName, const Unicod
     durationString = mediaData.at("TLEN");
   }
 
-  if(durationString.empty() == true)
+  if((durationString.empty() == true) && (pContext_->Duration() > 0))
   {
     durationString = UnicodeStringFromInt(pContext_->Duration());
   }
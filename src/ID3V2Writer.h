@@ -28,6 +28,7 @@
 #define __ULTRASCHALL_REAPER_ID3V2_WRITER_H_INCL__
 
 #include "Common.h"
+#include "ID3V2Commit.h"
 #include "ITagWriter.h"
 
 namespace ultraschall { namespace reaper {
@@ -39,7 +40,7 @@ class ID3V2Writer : public ITagWriter
 public:
     virtual bool Start(const UnicodeString& targetName);
 
-    virtual void Stop(const bool commit);
+    virtual bool Stop(const bool commit);
 
     virtual bool InsertProperties(const UnicodeString& targetName, const UnicodeStringDictionary& mediaData);
 
@@ -51,6 +52,10 @@ class ID3V2Writer : public ITagWriter
     virtual ~ID3V2Writer();
 
     ID3V2Context* pContext_ = nullptr;
+
+    // Queried on construction, the writer may be started and stopped on a worker thread.
+    const ID3V2PaddingPolicy    paddingPolicy_  = ID3V2PaddingPolicy::Query();
+    const ID3V2_COMMIT_STRATEGY commitStrategy_ = ID3V2QueryCommitStrategy();
 };
 
 }} // namespace ultraschall::reaper
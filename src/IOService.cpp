@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "IOService.h"
+
+namespace ultraschall { namespace reaper {
+
+IOService& IOService::Instance()
+{
+    static IOService self;
+    return self;
+}
+
+IOService::~IOService()
+{
+    Stop();
+}
+
+void IOService::Enqueue(const std::function<void()>& request)
+{
+    bool runInPlace = false;
+
+    {
+        std::lock_guard<std::mutex> lock(requestsLock_);
+        if(false == stopped_)
+        {
+            requests_.push_back(request);
+            if(workers_.size() < std::min(requests_.size(), MAX_WORKERS))
+            {
+                workers_.push_back(std::thread(&IOService::ProcessRequests, this));
+            }
+        }
+        else
+        {
+            runInPlace = true;
+        }
+    }
+
+    // Requests after Stop() are still served, the future must become ready.
+    if(true == runInPlace)
+    {
+        request();
+    }
+    else
+    {
+        requestsAvailable_.notify_one();
+    }
+}
+
+void IOService::ProcessRequests()
+{
+    std::unique_lock<std::mutex> lock(requestsLock_);
+    for(;;)
+    {
+        requestsAvailable_.wait(lock, [this]() { return (requests_.empty() == false) || (true == stopped_); });
+        if(requests_.empty() == true)
+        {
+            break;
+        }
+
+        const std::function<void()> request = requests_.front();
+        requests_.pop_front();
+
+        lock.unlock();
+        request();
+        lock.lock();
+    }
+}
+
+void IOService::Stop()
+{
+    std::vector<std::thread> workers;
+
+    {
+        std::lock_guard<std::mutex> lock(requestsLock_);
+        stopped_ = true;
+        workers.swap(workers_);
+    }
+
+    // Pending requests are completed before the workers exit.
+    requestsAvailable_.notify_all();
+    std::for_each(workers.begin(), workers.end(), [](std::thread& worker) { worker.join(); });
+}
+
+}} // namespace ultraschall::reaper
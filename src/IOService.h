@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_IO_SERVICE_H_INCL__
+#define __ULTRASCHALL_REAPER_IO_SERVICE_H_INCL__
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "Common.h"
+
+namespace ultraschall { namespace reaper {
+
+// Small pool of threads that runs blocking file operations off the main thread. The workers are started with the
+// first request and joined by Stop(), which must be called before the plugin is unloaded.
+class IOService
+{
+public:
+    static IOService& Instance();
+
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> Submit(F f);
+
+    void Stop();
+
+private:
+    IOService() {}
+    ~IOService();
+
+    IOService(const IOService&) = delete;
+    IOService& operator=(const IOService&) = delete;
+
+    // The requests are bound by disk latency, not by the number of cores.
+    static const size_t MAX_WORKERS = 4;
+
+    void Enqueue(const std::function<void()>& request);
+    void ProcessRequests();
+
+    std::deque<std::function<void()>> requests_;
+    std::vector<std::thread>          workers_;
+    bool                              stopped_ = false;
+    std::mutex                        requestsLock_;
+    std::condition_variable           requestsAvailable_;
+};
+
+template<typename F>
+std::future<typename std::result_of<F()>::type> IOService::Submit(F f)
+{
+    typedef typename std::result_of<F()>::type Result;
+
+    // std::function requires a copyable target, the task is shared between the queue and the worker.
+    std::shared_ptr<std::packaged_task<Result()>> pTask = std::make_shared<std::packaged_task<Result()>>(f);
+    std::future<Result>                           result = pTask->get_future();
+    Enqueue([pTask]() { (*pTask)(); });
+    return result;
+}
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_IO_SERVICE_H_INCL__
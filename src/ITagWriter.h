@@ -39,7 +39,8 @@ class ITagWriter : public SharedObject
 public:
     virtual bool Start(const UnicodeString& targetName) = 0;
 
-    virtual void Stop(const bool commit) = 0;
+    // Returns false if the tag couldn't be committed to the target.
+    virtual bool Stop(const bool commit) = 0;
 
     virtual bool InsertProperties(const UnicodeString& targetName, const UnicodeStringDictionary& mediaData) = 0;
 
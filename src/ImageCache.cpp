@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ImageCache.h"
+#include "FileManager.h"
+#include "MetadataCache.h"
+#include "Picture.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+Image::Image(BinaryStream* pStream, const uint64_t hash) : pStream_(pStream), hash_(hash)
+{
+    PRECONDITION(pStream_ != nullptr);
+
+    pStream_->AddRef();
+    mimeType_ = Picture::FormatString(pStream_);
+    Picture::Dimensions(pStream_->Data(), pStream_->DataSize(), width_, height_);
+}
+
+Image::~Image()
+{
+    SafeRelease(pStream_);
+}
+
+const uint8_t* Image::Data() const
+{
+    return (pStream_ != nullptr) ? pStream_->Data() : nullptr;
+}
+
+size_t Image::DataSize() const
+{
+    return (pStream_ != nullptr) ? pStream_->DataSize() : 0;
+}
+
+ImageCache& ImageCache::Instance()
+{
+    static ImageCache self;
+    return self;
+}
+
+ImageCache::~ImageCache()
+{
+    Clear();
+}
+
+void ImageCache::Clear()
+{
+    std::map<UnicodeString, std::future<BinaryStream*>> pendingReads;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+        for(std::multimap<uint64_t, CachedImage>::iterator i = images_.begin(); i != images_.end(); i++)
+        {
+            SafeRelease(i->second.pImage);
+        }
+
+        images_.clear();
+        files_.clear();
+        cacheSize_ = 0;
+
+        pendingReads.swap(pendingReads_);
+    }
+
+    // Prefetched files that nobody asked for are waited for without holding the lock.
+    for(std::map<UnicodeString, std::future<BinaryStream*>>::iterator i = pendingReads.begin();
+        i != pendingReads.end(); i++)
+    {
+        BinaryStream* pStream = i->second.get();
+        SafeRelease(pStream);
+    }
+}
+
+void ImageCache::Prefetch(const UnicodeStringArray& filenames)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    for(size_t i = 0; i < filenames.size(); i++)
+    {
+        const UnicodeString& filename = filenames[i];
+        if((filename.empty() == false) && (files_.count(filename) == 0) && (pendingReads_.count(filename) == 0)
+           && (activeReads_.count(filename) == 0))
+        {
+            pendingReads_.insert(std::make_pair(filename, FileManager::ReadBinaryFileAsync(filename, false)));
+        }
+    }
+}
+
+uint64_t ImageCache::ComputeHash(const uint8_t* data, const size_t dataSize)
+{
+    PRECONDITION_RETURN(data != nullptr, 0);
+
+    // FNV-1a, 64 bit
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < dataSize; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+BinaryStream* ImageCache::ReadFile(
+    const UnicodeString& filename, const FileSize size, std::future<BinaryStream*>& pendingRead)
+{
+    BinaryStream* pStream = nullptr;
+
+    if(pendingRead.valid() == true)
+    {
+        pStream = pendingRead.get();
+
+        // The file has been replaced after it has been prefetched.
+        if((pStream != nullptr) && (pStream->DataSize() != size))
+        {
+            SafeRelease(pStream);
+        }
+    }
+
+    if(pStream == nullptr)
+    {
+        pStream = FileManager::ReadBinaryFile(filename, false);
+    }
+
+    return pStream;
+}
+
+void ImageCache::Touch(const Image* pImage)
+{
+    PRECONDITION(pImage != nullptr);
+
+    const auto range = images_.equal_range(pImage->Hash());
+    for(std::multimap<uint64_t, CachedImage>::iterator i = range.first; i != range.second; i++)
+    {
+        if(i->second.pImage == pImage)
+        {
+            i->second.lastUse = ++useCount_;
+        }
+    }
+}
+
+void ImageCache::Evict(const size_t requiredSize)
+{
+    while((images_.empty() == false) && ((cacheSize_ + requiredSize) > MAX_CACHE_SIZE))
+    {
+        std::multimap<uint64_t, CachedImage>::iterator leastRecentlyUsed = images_.begin();
+        for(std::multimap<uint64_t, CachedImage>::iterator i = images_.begin(); i != images_.end(); i++)
+        {
+            if(i->second.lastUse < leastRecentlyUsed->second.lastUse)
+            {
+                leastRecentlyUsed = i;
+            }
+        }
+
+        Image* pImage = leastRecentlyUsed->second.pImage;
+        for(std::map<UnicodeString, File>::iterator i = files_.begin(); i != files_.end();)
+        {
+            i = (i->second.pImage == pImage) ? files_.erase(i) : std::next(i);
+        }
+
+        // Images already handed out stay valid, the cache only drops its own reference.
+        cacheSize_ -= pImage->DataSize();
+        SafeRelease(pImage);
+        images_.erase(leastRecentlyUsed);
+    }
+}
+
+Image* ImageCache::Insert(BinaryStream* pStream, const uint64_t hash)
+{
+    PRECONDITION_RETURN(pStream != nullptr, nullptr);
+
+    Image* pImage = nullptr;
+
+    const auto range = images_.equal_range(hash);
+    for(std::multimap<uint64_t, CachedImage>::iterator i = range.first; (i != range.second) && (pImage == nullptr);
+        i++)
+    {
+        Image* pCandidate = i->second.pImage;
+        if((pCandidate->DataSize() == pStream->DataSize())
+           && (memcmp(pCandidate->Data(), pStream->Data(), pStream->DataSize()) == 0))
+        {
+            pImage = pCandidate;
+        }
+    }
+
+    if(pImage == nullptr)
+    {
+        Evict(pStream->DataSize());
+
+        CachedImage cachedImage;
+        cachedImage.pImage = new Image(pStream, hash);
+        images_.insert(std::make_pair(hash, cachedImage));
+        cacheSize_ += pStream->DataSize();
+        pImage = cachedImage.pImage;
+    }
+
+    Touch(pImage);
+
+    return pImage;
+}
+
+Image* ImageCache::Lookup(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    FileSize       size             = 0;
+    const uint64_t modificationTime = PlatformGateway::QueryFileModificationTime(filename);
+    PRECONDITION_RETURN(ServiceSucceeded(FileManager::QueryFileSize(filename, size)) && (size > 0), nullptr);
+
+    Image* pImage = nullptr;
+
+    bool done = false;
+    while(false == done)
+    {
+        std::unique_lock<std::recursive_mutex> lock(cacheLock_);
+
+        const std::map<UnicodeString, File>::const_iterator fileIterator = files_.find(filename);
+        const std::map<UnicodeString, std::shared_future<void>>::const_iterator activeReadIterator
+            = activeReads_.find(filename);
+        if((fileIterator != files_.end()) && (fileIterator->second.size == size)
+           && (fileIterator->second.modificationTime == modificationTime))
+        {
+            pImage = fileIterator->second.pImage;
+            pImage->AddRef();
+            Touch(pImage);
+            done = true;
+        }
+        else if(activeReadIterator != activeReads_.end())
+        {
+            // Another thread is reading the file, the image is looked up again once it is done.
+            const std::shared_future<void> activeRead = activeReadIterator->second;
+            lock.unlock();
+            activeRead.wait();
+        }
+        else
+        {
+            std::promise<void> readFinished;
+            activeReads_.insert(std::make_pair(filename, readFinished.get_future().share()));
+
+            std::future<BinaryStream*> pendingRead;
+            std::map<UnicodeString, std::future<BinaryStream*>>::iterator pendingIterator
+                = pendingReads_.find(filename);
+            if(pendingIterator != pendingReads_.end())
+            {
+                pendingRead = std::move(pendingIterator->second);
+                pendingReads_.erase(pendingIterator);
+            }
+
+            lock.unlock();
+
+            ImageProperties imageProperties;
+            BinaryStream*   pStream = ReadFile(filename, size, pendingRead);
+            if(pStream != nullptr)
+            {
+                // The hash of an unchanged file is known from previous runs.
+                if(MetadataCache::Instance().QueryImageProperties(filename, imageProperties) == false)
+                {
+                    imageProperties.hash   = ComputeHash(pStream->Data(), pStream->DataSize());
+                    imageProperties.format = Picture::Format(pStream);
+                    Picture::Dimensions(
+                        pStream->Data(), pStream->DataSize(), imageProperties.width, imageProperties.height);
+                    MetadataCache::Instance().InsertImageProperties(filename, imageProperties);
+                }
+            }
+
+            lock.lock();
+
+            if(pStream != nullptr)
+            {
+                pImage = Insert(pStream, imageProperties.hash);
+                if(pImage != nullptr)
+                {
+                    File& file            = files_[filename];
+                    file.size             = pStream->DataSize();
+                    file.modificationTime = modificationTime;
+                    file.pImage           = pImage;
+                    pImage->AddRef();
+                }
+            }
+
+            activeReads_.erase(filename);
+            lock.unlock();
+
+            readFinished.set_value();
+            SafeRelease(pStream);
+            done = true;
+        }
+    }
+
+    return pImage;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_IMAGE_CACHE_H_INCL__
+#define __ULTRASCHALL_REAPER_IMAGE_CACHE_H_INCL__
+
+#include <future>
+
+#include "Common.h"
+#include "BinaryStream.h"
+
+namespace ultraschall { namespace reaper {
+
+class Image : public SharedObject
+{
+public:
+    Image(BinaryStream* pStream, const uint64_t hash);
+
+    const uint8_t* Data() const;
+    size_t         DataSize() const;
+
+    inline const UnicodeString& MimeType() const;
+    inline uint32_t             Width() const;
+    inline uint32_t             Height() const;
+    inline uint64_t             Hash() const;
+
+protected:
+    virtual ~Image();
+
+private:
+    BinaryStream* pStream_ = nullptr;
+    UnicodeString mimeType_;
+    uint32_t      width_  = 0;
+    uint32_t      height_ = 0;
+    uint64_t      hash_   = 0;
+};
+
+inline const UnicodeString& Image::MimeType() const
+{
+    return mimeType_;
+}
+
+inline uint32_t Image::Width() const
+{
+    return width_;
+}
+
+inline uint32_t Image::Height() const
+{
+    return height_;
+}
+
+inline uint64_t Image::Hash() const
+{
+    return hash_;
+}
+
+// Process-wide cache of cover and chapter images. Files are identified by path, size and
+// modification time, identical content found under different paths shares a single buffer.
+// Files are read outside of the lock, the least recently used images are dropped when the
+// cache exceeds MAX_CACHE_SIZE. The images are copied into memory instead of being mapped, so
+// the files can be replaced or deleted while they are cached.
+class ImageCache
+{
+public:
+    static ImageCache& Instance();
+
+    // Returns an additional reference to the cached image, the caller must release it.
+    Image* Lookup(const UnicodeString& filename);
+
+    // Starts reading the files in the background, Lookup() picks up the pending reads.
+    void Prefetch(const UnicodeStringArray& filenames);
+
+    void Clear();
+
+private:
+    ImageCache() {}
+    ~ImageCache();
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    static const size_t MAX_CACHE_SIZE = 256 * 1024 * 1024;
+
+    struct File
+    {
+        FileSize size             = 0;
+        uint64_t modificationTime = 0;
+        Image*   pImage           = nullptr;
+    };
+
+    struct CachedImage
+    {
+        Image*   pImage  = nullptr;
+        uint64_t lastUse = 0;
+    };
+
+    static uint64_t ComputeHash(const uint8_t* data, const size_t dataSize);
+
+    static BinaryStream* ReadFile(
+        const UnicodeString& filename, const FileSize size, std::future<BinaryStream*>& pendingRead);
+
+    Image* Insert(BinaryStream* pStream, const uint64_t hash);
+    void   Touch(const Image* pImage);
+    void   Evict(const size_t requiredSize);
+
+    std::map<UnicodeString, File>                       files_;
+    std::multimap<uint64_t, CachedImage>                images_;
+    std::map<UnicodeString, std::future<BinaryStream*>> pendingReads_;
+    std::map<UnicodeString, std::shared_future<void>>   activeReads_; // files that a Lookup() is reading
+    size_t                                              cacheSize_ = 0;
+    uint64_t                                            useCount_  = 0;
+    mutable std::recursive_mutex                        cacheLock_;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_IMAGE_CACHE_H_INCL__
@@ -25,8 +25,10 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "InsertChapterMarkersAction.h"
+#include "ChapterParser.h"
 #include "CustomActionFactory.h"
 #include "FileManager.h"
+#include "ID3V2Reader.h"
 #include "StringUtilities.h"
 #include "PlatformGateway.h"
 #include "NotificationStore.h"
@@ -44,29 +46,35 @@ ServiceStatus InsertChapterMarkersAction::Execute()
     ServiceStatus     status = SERVICE_FAILURE;
     NotificationStore supervisor(UniqueId());
 
-    ReaperProject currentProject = ReaperProject::Current();
-    size_t        addedTags      = 0;
-    for(size_t i = 0; i < chapterMarkers_.size(); i++)
+    ReaperProject   currentProject = ReaperProject::Current();
+    ChapterTagArray failedChapterMarkers;
+    const size_t    addedTags = currentProject.InsertChapterMarkers(chapterMarkers_, failedChapterMarkers);
+    for(size_t i = 0; i < failedChapterMarkers.size(); i++)
     {
-        if(currentProject.InsertChapterMarker(chapterMarkers_[i].Title(), chapterMarkers_[i].Position()) == true)
-        {
-            addedTags++;
-        }
-        else
-        {
-            UnicodeStringStream os;
-            os << "Chapter marker '" << chapterMarkers_[i].Title() << "' at position '"
-               << SecondsToString(chapterMarkers_[i].Position()) << "' could not be added.";
-            supervisor.RegisterError(os.str());
-        }
+        UnicodeStringStream os;
+        os << "Chapter marker '" << failedChapterMarkers[i].Title() << "' at position '"
+           << SecondsToString(failedChapterMarkers[i].Position()) << "' could not be added.";
+        supervisor.RegisterError(os.str());
     }
 
-    if(chapterMarkers_.size() != addedTags)
+    if(failedChapterMarkers.empty() == false)
     {
         UnicodeStringStream os;
         os << "Not all chapter markers were added.";
         supervisor.RegisterError(os.str());
     }
+    else
+    {
+        const size_t skippedTags = chapterMarkers_.size() - addedTags;
+        if(skippedTags > 0)
+        {
+            UnicodeStringStream os;
+            os << skippedTags << " chapter marker(s) already existed and were skipped.";
+            supervisor.RegisterWarning(os.str());
+        }
+
+        status = SERVICE_SUCCESS;
+    }
 
     return status;
 }
@@ -90,14 +98,14 @@ bool InsertChapterMarkersAction::ConfigureSources()
         const FileManager::FILE_TYPE mediaType = FileManager::QueryFileType(source_);
         switch(mediaType)
         {
-            case FileManager::FILE_TYPE::MP4CHAPS:
-                chapterMarkers = ReadTextFile(source_);
-                break;
             case FileManager::FILE_TYPE::MP3:
-                // TODO v6: Read chapters from MP3
-                // chapterMarkers = ReadMP3File(source_);
+                chapterMarkers = ReadMP3File(source_);
+                break;
+            case FileManager::FILE_TYPE::JPEG:
+            case FileManager::FILE_TYPE::PNG:
                 break;
             default:
+                chapterMarkers = ReadChaptersFile(source_, mediaType);
                 break;
         }
 
@@ -114,63 +122,67 @@ bool InsertChapterMarkersAction::ConfigureSources()
     return result;
 }
 
-ChapterTagArray InsertChapterMarkersAction::ReadTextFile(const UnicodeString& filename)
+ChapterTagArray InsertChapterMarkersAction::ReadChaptersFile(
+    const UnicodeString& filename, const FileManager::FILE_TYPE fileType)
 {
     PRECONDITION_RETURN(filename.empty() == false, ChapterTagArray());
 
     NotificationStore supervisor(UniqueId());
     ChapterTagArray   chapterMarkers;
 
-    const UnicodeStringArray lines = FileManager::ReadTextFile(filename);
-    if(lines.empty() == false)
+    ChapterParser parser(filename);
+    if((fileType == FileManager::FILE_TYPE::UNKNOWN_FILE_TYPE)
+       && (parser.QueryFormat() == ChapterParser::FORMAT::UNKNOWN_FORMAT))
     {
-        for(size_t i = 0; i < lines.size(); i++)
+        UnicodeStringStream os;
+        os << "The format of the file '" << filename << "' is not supported.";
+        supervisor.RegisterError(os.str());
+    }
+    else if(parser.Parse(chapterMarkers) == true)
+    {
+        const ChapterParserErrorArray& errors = parser.Errors();
+        for(size_t i = 0; i < errors.size(); i++)
         {
-            const UnicodeString normalizedLine = UnicodeStringCopyTrimLeft(lines[i]);
-            if(normalizedLine.empty() == false)
+            UnicodeStringStream os;
+            os << "Line " << errors[i].lineNumber << ": ";
+            if(errors[i].type == ChapterParserError::TYPE::INVALID_TIMESTAMP)
             {
-                if(normalizedLine.size() >= Globals::MIN_CHAPTER_MARKER_LINE_LENGTH)
-                {
-                    const UnicodeStringArray items = UnicodeStringTokenize(normalizedLine, ' ');
-                    if(items.empty() == false)
-                    {
-                        const double position = StringToSeconds(items[0]);
-                        if(position >= 0)
-                        {
-                            UnicodeString title;
-                            for(size_t j = 1; j < items.size(); j++)
-                            {
-                                if(items[j].empty() == false)
-                                {
-                                    if(title.empty() == false)
-                                    {
-                                        title += ' ';
-                                    }
-
-                                    title += items[j];
-                                }
-                            }
-
-                            chapterMarkers.push_back(ChapterTag(position, title));
-                        }
-                        else
-                        {
-                            UnicodeStringStream os;
-                            os << "Line " << (i + 1) << ": Invalid timestamp in '" << lines[i] << "'.";
-                            supervisor.RegisterError(os.str());
-                        }
-                    }
-                }
-                else
-                {
-                    UnicodeStringStream os;
-                    os << "Line " << (i + 1) << ": Invalid format in '" << lines[i] << "'.";
-                    supervisor.RegisterError(os.str());
-                }
+                os << "Invalid timestamp";
             }
+            else
+            {
+                os << "Invalid format";
+            }
+
+            os << " in '" << errors[i].line << "'.";
+            supervisor.RegisterError(os.str());
+        }
+
+        if(parser.ErrorCount() > errors.size())
+        {
+            UnicodeStringStream os;
+            os << (parser.ErrorCount() - errors.size()) << " more lines could not be read.";
+            supervisor.RegisterError(os.str());
+        }
+
+        if((chapterMarkers.empty() == true) && (parser.ErrorCount() == 0))
+        {
+            UnicodeStringStream os;
+            os << "The file '" << filename << "' does not contain chapter markers";
+            supervisor.RegisterWarning(os.str());
         }
     }
-    else
+
+    return chapterMarkers;
+}
+
+ChapterTagArray InsertChapterMarkersAction::ReadMP3File(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, ChapterTagArray());
+
+    NotificationStore     supervisor(UniqueId());
+    const ChapterTagArray chapterMarkers = ID3V2ReadChapterMarkers(filename);
+    if(chapterMarkers.empty() == true)
     {
         UnicodeStringStream os;
         os << "The file '" << filename << "' does not contain chapter markers";
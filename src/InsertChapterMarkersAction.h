@@ -29,6 +29,7 @@
 
 #include "Common.h"
 #include "CustomAction.h"
+#include "FileManager.h"
 
 namespace ultraschall { namespace reaper {
 
@@ -59,7 +60,7 @@ class InsertChapterMarkersAction : public CustomAction
     bool ConfigureTargets();
     bool ConfigureSources();
 
-    static ChapterTagArray ReadTextFile(const UnicodeString& filename);
+    static ChapterTagArray ReadChaptersFile(const UnicodeString& filename, const FileManager::FILE_TYPE fileType);
     static ChapterTagArray ReadMP3File(const UnicodeString& filename);
 };
 
@@ -24,14 +24,18 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "CustomActionFactory.h"
 #include "PlatformGateway.h"
 #include "FileManager.h"
 #include "ITagWriter.h"
+#include "ImageCache.h"
 #include "InsertMediaPropertiesAction.h"
+#include "MetadataCache.h"
 #include "NotificationStore.h"
 #include "StringUtilities.h"
 #include "SystemProperties.h"
@@ -53,72 +57,90 @@ ServiceStatus InsertMediaPropertiesAction::Execute()
     NotificationStore notificationStore(UniqueId());
     size_t            errorCount = 0;
 
-    for(size_t i = 0; i < targets_.size(); i++) {
-        ITagWriter* pTagWriter = TagWriterFactory::Create(targets_[i]);
-        if(pTagWriter != 0) {
-            if(pTagWriter->Start(targets_[i]) == true) {
-                const UnicodeStringArray missingMediaDataFields     = FindMissingMediaData();
-                const size_t             missingFieldCount          = missingMediaDataFields.size();
-                static const size_t      REQUIRED_MEDIA_DATA_FIELDS = 6;
-                if((missingFieldCount > 0) && (missingFieldCount < REQUIRED_MEDIA_DATA_FIELDS)) {
-                    UnicodeStringStream os;
-                    os << "MP3 metadata is incomplete.";
-                    notificationStore.RegisterWarning(os.str());
-                }
-                else if(missingFieldCount == REQUIRED_MEDIA_DATA_FIELDS) {
-                    UnicodeStringStream os;
-                    os << "MP3 metadata is missing";
-                    notificationStore.RegisterWarning(os.str());
-                }
+    // Everything that depends on the REAPER API is checked once on the main thread. The targets
+    // are tagged from the snapshot taken in ConfigureSources.
+    const UnicodeStringArray missingMediaDataFields     = FindMissingMediaData();
+    const size_t             missingFieldCount          = missingMediaDataFields.size();
+    static const size_t      REQUIRED_MEDIA_DATA_FIELDS = 6;
+    if((missingFieldCount > 0) && (missingFieldCount < REQUIRED_MEDIA_DATA_FIELDS)) {
+        UnicodeStringStream os;
+        os << "MP3 metadata is incomplete.";
+        notificationStore.RegisterWarning(os.str());
+    }
+    else if(missingFieldCount == REQUIRED_MEDIA_DATA_FIELDS) {
+        UnicodeStringStream os;
+        os << "MP3 metadata is missing";
+        notificationStore.RegisterWarning(os.str());
+    }
 
-                if(missingFieldCount < REQUIRED_MEDIA_DATA_FIELDS) {
-                    if(pTagWriter->InsertProperties(targets_[i], mediaData_) == false) {
-                        UnicodeStringStream os;
-                        os << "Failed to insert MP3 metadata into " << targets_[i] << ".";
-                        notificationStore.RegisterError(os.str());
-                        errorCount++;
-                    }
-                }
+    insertMediaData_ = (missingFieldCount < REQUIRED_MEDIA_DATA_FIELDS);
 
-                if(coverImage_.empty() == false) {
-                    if(pTagWriter->InsertCoverImage(targets_[i], coverImage_) == false) {
-                        UnicodeStringStream os;
-                        os << "Failed to insert cover image into " << targets_[i] << ".";
-                        notificationStore.RegisterError(os.str());
-                        errorCount++;
-                    }
-                }
-                else {
-                    UnicodeStringStream os;
-                    os << "The cover image is missing.";
-                    notificationStore.RegisterWarning(os.str());
-                }
+    if(coverImage_.empty() == true) {
+        UnicodeStringStream os;
+        os << "The cover image is missing.";
+        notificationStore.RegisterWarning(os.str());
+    }
 
-                if(chapterMarkers_.empty() == true) {
-                    UnicodeStringStream os;
-                    os << "The chapter markers are missing.";
-                    notificationStore.RegisterWarning(os.str());
-                }
-                else if(AreChapterMarkersValid(chapterMarkers_) == false) {
-                    UnicodeStringStream os;
-                    os << "One or more chapter markers are invalid.";
-                    notificationStore.RegisterError(os.str());
-                    errorCount++;
-                }
-                else {
-                    if(pTagWriter->InsertChapterMarkers(targets_[i], chapterMarkers_) == false) {
-                        UnicodeStringStream os;
-                        os << "Failed to insert chapter markers into " << targets_[i] << ".";
-                        notificationStore.RegisterError(os.str());
-                        errorCount++;
-                    }
-                }
+    if(chapterMarkers_.empty() == true) {
+        UnicodeStringStream os;
+        os << "The chapter markers are missing.";
+        notificationStore.RegisterWarning(os.str());
+    }
+    else if(AreChapterMarkersValid(chapterMarkers_) == false) {
+        UnicodeStringStream os;
+        os << "One or more chapter markers are invalid.";
+        notificationStore.RegisterError(os.str());
+        errorCount++;
+    }
 
-                pTagWriter->Stop(0 == errorCount);
+    if(0 == errorCount) {
+        // The images are read in the background while the tag writers examine the targets.
+        UnicodeStringArray images(1, coverImage_);
+        for(size_t i = 0; i < chapterMarkers_.size(); i++) {
+            images.push_back(chapterMarkers_[i].Image());
+        }
+
+        ImageCache::Instance().Prefetch(images);
+
+        // The tag writers query their settings on construction, create them here as well.
+        std::vector<ITagWriter*> tagWriters;
+        for(size_t i = 0; i < targets_.size(); i++) {
+            tagWriters.push_back(TagWriterFactory::Create(targets_[i]));
+        }
+
+        std::vector<NotificationArray> notifications(targets_.size());
+        std::vector<size_t>            errorCounts(targets_.size(), 0);
+        std::atomic<size_t>            nextTarget(0);
+
+        const auto worker = [&]() {
+            for(size_t i = nextTarget++; i < targets_.size(); i = nextTarget++) {
+                if(tagWriters[i] != nullptr) {
+                    errorCounts[i] = InsertMediaProperties(tagWriters[i], targets_[i], notifications[i]);
+                }
             }
+        };
+
+        // The main thread takes part in the work, a single target is tagged without a worker.
+        const size_t concurrency = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        const size_t workerCount = std::min(targets_.size(), concurrency) - 1;
+
+        std::vector<std::thread> workers;
+        for(size_t i = 0; i < workerCount; i++) {
+            workers.push_back(std::thread(worker));
+        }
+
+        worker();
 
-            SafeRelease(pTagWriter);
+        std::for_each(workers.begin(), workers.end(), [](std::thread& workerThread) { workerThread.join(); });
+
+        for(size_t i = 0; i < targets_.size(); i++) {
+            notificationStore.RegisterNotifications(notifications[i]);
+            errorCount += errorCounts[i];
+            SafeRelease(tagWriters[i]);
         }
+
+        // Properties that have been gathered for the targets and the images are reused by the next run.
+        MetadataCache::Instance().Save();
     }
 
     if(0 == errorCount) {
@@ -134,6 +156,59 @@ ServiceStatus InsertMediaPropertiesAction::Execute()
     return status;
 }
 
+size_t InsertMediaPropertiesAction::InsertMediaProperties(
+    ITagWriter* pTagWriter, const UnicodeString& targetName, NotificationArray& notifications) const
+{
+    PRECONDITION_RETURN(pTagWriter != nullptr, 1);
+    PRECONDITION_RETURN(targetName.empty() == false, 1);
+
+    size_t errorCount = 0;
+
+    if(pTagWriter->Start(targetName) == true) {
+        if(true == insertMediaData_) {
+            if(pTagWriter->InsertProperties(targetName, mediaData_) == false) {
+                UnicodeStringStream os;
+                os << "Failed to insert MP3 metadata into " << targetName << ".";
+                notifications.push_back(Notification(NotificationClass::NOTIFICATION_ERROR, os.str()));
+                errorCount++;
+            }
+        }
+
+        if(coverImage_.empty() == false) {
+            if(pTagWriter->InsertCoverImage(targetName, coverImage_) == false) {
+                UnicodeStringStream os;
+                os << "Failed to insert cover image into " << targetName << ".";
+                notifications.push_back(Notification(NotificationClass::NOTIFICATION_ERROR, os.str()));
+                errorCount++;
+            }
+        }
+
+        if(chapterMarkers_.empty() == false) {
+            if(pTagWriter->InsertChapterMarkers(targetName, chapterMarkers_) == false) {
+                UnicodeStringStream os;
+                os << "Failed to insert chapter markers into " << targetName << ".";
+                notifications.push_back(Notification(NotificationClass::NOTIFICATION_ERROR, os.str()));
+                errorCount++;
+            }
+        }
+
+        if(pTagWriter->Stop(0 == errorCount) == false) {
+            UnicodeStringStream os;
+            os << "Failed to write the tag to " << targetName << ".";
+            notifications.push_back(Notification(NotificationClass::NOTIFICATION_ERROR, os.str()));
+            errorCount++;
+        }
+    }
+    else {
+        UnicodeStringStream os;
+        os << "Failed to read the existing tag of " << targetName << ", the file has not been changed.";
+        notifications.push_back(Notification(NotificationClass::NOTIFICATION_ERROR, os.str()));
+        errorCount++;
+    }
+
+    return errorCount;
+}
+
 bool InsertMediaPropertiesAction::ConfigureSources()
 {
     bool result = true;
@@ -171,18 +246,30 @@ bool InsertMediaPropertiesAction::ConfigureSources()
     return result;
 }
 
+// Renders of several bitrates or variants share the project name, e.g. 'episode.mp3' and 'episode-64k.mp3'. All MP3
+// files in the project directory whose names start with the project name are tagged at once.
 bool InsertMediaPropertiesAction::ConfigureTargets()
 {
     NotificationStore supervisor(UniqueId());
 
     targets_.clear();
 
-    static const UnicodeStringArray fileExtensions = {".mp3"};
-    for(size_t i = 0; i < fileExtensions.size(); i++) {
-        UnicodeString targetName = CreateProjectPath(fileExtensions[i]);
-        if(FileManager::FileExists(targetName) != false) {
-            targets_.push_back(targetName);
+    const bool          caseSensitive = PlatformGateway::QueryCaseSensitiveFileNames();
+    const UnicodeString directory     = CurrentProjectDirectory();
+    const UnicodeString projectName
+        = (true == caseSensitive) ? CurrentProjectName() : StringLowercase(CurrentProjectName());
+
+    DirectoryEntryArray entries;
+    if(PlatformGateway::QueryDirectoryEntries(directory, entries) == true) {
+        for(size_t i = 0; i < entries.size(); i++) {
+            const UnicodeString name = (true == caseSensitive) ? entries[i].name : StringLowercase(entries[i].name);
+            if((name.compare(0, projectName.size(), projectName) == 0)
+               && (FileManager::QueryFileType(entries[i].name) == FileManager::FILE_TYPE::MP3)) {
+                targets_.push_back(FileManager::AppendPath(directory, entries[i].name));
+            }
         }
+
+        std::sort(targets_.begin(), targets_.end());
     }
 
     if(targets_.empty() == true) {
@@ -209,7 +296,7 @@ UnicodeString InsertMediaPropertiesAction::FindCoverImage()
     }
 
     const size_t imageIndex = FileManager::FileExists(files);
-    if(imageIndex != -1) {
+    if(imageIndex < files.size()) {
         coverImage = files[imageIndex];
     }
 
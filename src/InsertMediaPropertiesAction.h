@@ -29,6 +29,7 @@
 
 #include "Common.h"
 #include "CustomAction.h"
+#include "Notification.h"
 
 namespace ultraschall { namespace reaper {
 
@@ -61,10 +62,14 @@ class InsertMediaPropertiesAction : public CustomAction
     UnicodeString FindCoverImage();
     UnicodeStringArray   FindMissingMediaData();
 
+    size_t InsertMediaProperties(
+        ITagWriter* pTagWriter, const UnicodeString& targetName, NotificationArray& notifications) const;
+
     UnicodeStringArray      targets_;
     UnicodeString           coverImage_;
     ChapterTagArray         chapterMarkers_;
     UnicodeStringDictionary mediaData_;
+    bool                    insertMediaData_ = false;
 };
 
 }} // namespace ultraschall::reaper
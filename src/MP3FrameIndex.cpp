@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <thread>
+
+#include "MP3FrameIndex.h"
+#include "MetadataCache.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+// The frame offsets are kept in 32 bits relative to the first audio frame. Longer audio streams are
+// rejected instead of wrapping around, the offsets in a CHAP frame are 32 bit values as well.
+static const FileSize MAX_AUDIO_SIZE = 0xffffffff;
+
+static const size_t MIN_CHUNK_SIZE  = 4 * 1024 * 1024;
+static const size_t MIN_SYNC_FRAMES = 3;
+
+// Files that can't be mapped are read in windows of STREAM_WINDOW_SIZE bytes. Frames are only accepted
+// MAX_LOOKAHEAD bytes before the end of a window, enough to check the frames that follow them.
+static const size_t STREAM_WINDOW_SIZE = 4 * 1024 * 1024;
+static const size_t MAX_LOOKAHEAD      = 64 * 1024;
+
+static bool IsFrame(
+    const uint8_t* data, const size_t offset, const size_t streamEnd, const MP3FrameHeader& reference,
+    MP3FrameHeader& header)
+{
+    return ((offset + MP3_FRAME_HEADER_SIZE) <= streamEnd) && (MP3ParseFrameHeader(&data[offset], header) == true)
+           && (header.version == reference.version) && (header.layer == reference.layer)
+           && (header.sampleRate == reference.sampleRate) && ((offset + header.frameSize) <= streamEnd);
+}
+
+size_t MP3FrameIndex::Resync(
+    const uint8_t* data, size_t offset, const size_t streamEnd, const MP3FrameHeader& reference)
+{
+    // A position is accepted once a few frames in a row start where their predecessor ends,
+    // or the chain runs into the end of the stream.
+    for(; (offset + MP3_FRAME_HEADER_SIZE) <= streamEnd; offset++)
+    {
+        size_t         cursor     = offset;
+        size_t         frameCount = 0;
+        MP3FrameHeader header;
+        while((frameCount < MIN_SYNC_FRAMES) && (IsFrame(data, cursor, streamEnd, reference, header) == true))
+        {
+            cursor += header.frameSize;
+            frameCount++;
+        }
+
+        if((frameCount == MIN_SYNC_FRAMES) || ((frameCount > 0) && (cursor == streamEnd)))
+        {
+            return offset;
+        }
+    }
+
+    return streamEnd;
+}
+
+size_t MP3FrameIndex::Scan(
+    const uint8_t* data, size_t offset, const size_t chunkEnd, const size_t streamEnd,
+    const MP3FrameHeader& reference, const size_t baseOffset, std::vector<uint32_t>& frameOffsets)
+{
+    // Each frame has to be followed by another frame or the end of the stream, which keeps
+    // sync patterns inside damaged data from being taken for a frame.
+    MP3FrameHeader header;
+    MP3FrameHeader nextHeader;
+    while(offset < chunkEnd)
+    {
+        if((IsFrame(data, offset, streamEnd, reference, header) == true)
+           && (((offset + header.frameSize) == streamEnd)
+               || (IsFrame(data, offset + header.frameSize, streamEnd, reference, nextHeader) == true)))
+        {
+            frameOffsets.push_back(static_cast<uint32_t>(baseOffset + offset));
+            offset += header.frameSize;
+        }
+        else
+        {
+            offset = Resync(data, offset + 1, streamEnd, reference);
+        }
+    }
+
+    return offset;
+}
+
+bool MP3FrameIndex::Build(const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    targetName_ = targetName;
+    seekTable_  = MP3SeekTable();
+
+    PRECONDITION_RETURN(MP3QueryProperties(targetName, properties_) == true, false);
+    PRECONDITION_RETURN(properties_.audioSize <= MAX_AUDIO_SIZE, false);
+
+    bool success = (MetadataCache::Instance().QuerySeekTable(targetName, seekTable_) == true)
+                   && (seekTable_.interval == SEEK_POINT_INTERVAL) && (seekTable_.seekPoints.empty() == false);
+    if(false == success)
+    {
+        std::vector<uint32_t> frameOffsets;
+        success = ScanFile(targetName, frameOffsets);
+        if(true == success)
+        {
+            seekTable_            = MP3SeekTable();
+            seekTable_.frameCount = static_cast<uint32_t>(frameOffsets.size());
+            seekTable_.interval   = SEEK_POINT_INTERVAL;
+            seekTable_.seekPoints.reserve((frameOffsets.size() / SEEK_POINT_INTERVAL) + 1);
+            for(size_t i = 0; i < frameOffsets.size(); i += SEEK_POINT_INTERVAL)
+            {
+                seekTable_.seekPoints.push_back(frameOffsets[i]);
+            }
+
+            MetadataCache::Instance().InsertSeekTable(targetName, seekTable_);
+        }
+    }
+
+    return success;
+}
+
+bool MP3FrameIndex::ScanFile(const UnicodeString& targetName, std::vector<uint32_t>& frameOffsets)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    frameOffsets.clear();
+
+    bool success = false;
+
+    size_t         fileSize = 0;
+    const uint8_t* data     = PlatformGateway::MapFile(targetName, fileSize);
+    if(data != nullptr)
+    {
+        if(properties_.audioOffset < fileSize)
+        {
+            const size_t audioOffset = static_cast<size_t>(properties_.audioOffset);
+            const size_t streamSize  = std::min(static_cast<size_t>(properties_.audioSize), fileSize - audioOffset);
+            success                  = ScanStream(&data[audioOffset], streamSize, frameOffsets);
+        }
+
+        PlatformGateway::UnmapFile(data, fileSize);
+    }
+    else
+    {
+        success = ReadFile(targetName, frameOffsets);
+    }
+
+    return success;
+}
+
+bool MP3FrameIndex::ScanStream(const uint8_t* data, const size_t streamSize, std::vector<uint32_t>& frameOffsets)
+{
+    PRECONDITION_RETURN(data != nullptr, false);
+
+    MP3FrameHeader reference;
+    PRECONDITION_RETURN(streamSize >= MP3_FRAME_HEADER_SIZE, false);
+    PRECONDITION_RETURN(MP3ParseFrameHeader(data, reference) == true, false);
+
+    const size_t chunkCount
+        = std::max<size_t>(std::min<size_t>(std::thread::hardware_concurrency(), streamSize / MIN_CHUNK_SIZE), 1);
+    const size_t chunkSize = (streamSize + chunkCount - 1) / chunkCount;
+
+    std::vector<Chunk> chunks(chunkCount);
+    const auto         scanChunk = [&](const size_t i) {
+        const size_t chunkStart = i * chunkSize;
+        const size_t chunkEnd   = std::min(chunkStart + chunkSize, streamSize);
+
+        Chunk& chunk = chunks[i];
+        chunk.frameOffsets.reserve((chunkSize / reference.frameSize) + 1);
+        chunk.scanOffset = (i == 0) ? chunkStart : Resync(data, chunkStart, streamSize, reference);
+        chunk.nextOffset = Scan(data, chunk.scanOffset, chunkEnd, streamSize, reference, 0, chunk.frameOffsets);
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t i = 1; i < chunkCount; i++)
+    {
+        workers.push_back(std::thread(scanChunk, i));
+    }
+
+    scanChunk(0);
+
+    std::for_each(workers.begin(), workers.end(), [](std::thread& worker) { worker.join(); });
+
+    // A chunk that resynchronized on something that only looked like a frame header is
+    // scanned again, starting where the previous chunk ended.
+    frameOffsets.reserve((streamSize / reference.frameSize) + chunkCount);
+    size_t expectedOffset = 0;
+    for(size_t i = 0; i < chunkCount; i++)
+    {
+        Chunk& chunk = chunks[i];
+        if(chunk.scanOffset != expectedOffset)
+        {
+            const size_t chunkEnd = std::min((i + 1) * chunkSize, streamSize);
+            chunk.frameOffsets.clear();
+            chunk.nextOffset = Scan(data, expectedOffset, chunkEnd, streamSize, reference, 0, chunk.frameOffsets);
+        }
+
+        frameOffsets.insert(frameOffsets.end(), chunk.frameOffsets.begin(), chunk.frameOffsets.end());
+        expectedOffset = chunk.nextOffset;
+    }
+
+    return frameOffsets.empty() == false;
+}
+
+bool MP3FrameIndex::ReadFile(const UnicodeString& targetName, std::vector<uint32_t>& frameOffsets)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary);
+    PRECONDITION_RETURN(file.is_open() == true, false);
+
+    const size_t         streamSize = static_cast<size_t>(properties_.audioSize);
+    std::vector<uint8_t> window(std::min(streamSize, STREAM_WINDOW_SIZE));
+    MP3FrameHeader       reference;
+    size_t               windowOffset = 0;
+    bool                 resync       = false;
+
+    bool success = true;
+    while((windowOffset < streamSize) && (true == success))
+    {
+        const size_t windowSize = std::min(window.size(), streamSize - windowOffset);
+        file.seekg(properties_.audioOffset + windowOffset);
+        file.read(reinterpret_cast<char*>(window.data()), windowSize);
+        success = file && ((windowOffset > 0) || (MP3ParseFrameHeader(window.data(), reference) == true));
+        if(true == success)
+        {
+            const bool   isLastWindow = (windowOffset + windowSize) == streamSize;
+            const size_t scanEnd      = (true == isLastWindow) ? windowSize : (windowSize - MAX_LOOKAHEAD);
+            const size_t scanOffset   = (true == resync) ? Resync(window.data(), 0, windowSize, reference) : 0;
+            const size_t nextOffset
+                = Scan(window.data(), scanOffset, scanEnd, windowSize, reference, windowOffset, frameOffsets);
+
+            // Positions close to the end of the window can't be checked against the frames behind them. The
+            // next window resynchronizes there, everything before has been checked against complete frames.
+            const size_t syncEnd = scanEnd + (MAX_LOOKAHEAD / 2);
+            resync               = (false == isLastWindow) && (nextOffset > syncEnd);
+            windowOffset += (true == isLastWindow) ? windowSize : std::min(nextOffset, syncEnd);
+        }
+    }
+
+    file.close();
+
+    return success && (frameOffsets.empty() == false);
+}
+
+bool MP3FrameIndex::QueryFrameOffset(const uint32_t frame, uint32_t& frameOffset) const
+{
+    PRECONDITION_RETURN(frame < seekTable_.frameCount, false);
+
+    const size_t seekPoint = frame / SEEK_POINT_INTERVAL;
+    PRECONDITION_RETURN(seekPoint < seekTable_.seekPoints.size(), false);
+
+    // The frames behind the seek point are scanned the same way as during the build, the lookahead behind the
+    // next seek point lets the scan check the last frames against their successors.
+    const size_t streamSize = static_cast<size_t>(properties_.audioSize);
+    const size_t scanStart  = seekTable_.seekPoints[seekPoint];
+    const size_t scanEnd    = ((seekPoint + 1) < seekTable_.seekPoints.size()) ?
+                                  seekTable_.seekPoints[seekPoint + 1] :
+                                  streamSize;
+    PRECONDITION_RETURN((scanStart < scanEnd) && (scanEnd <= streamSize), false);
+    const size_t windowSize = std::min(scanEnd + MAX_LOOKAHEAD, streamSize) - scanStart;
+
+    std::ifstream file(U2H(targetName_), std::ios::in | std::ios::binary);
+    PRECONDITION_RETURN(file.is_open() == true, false);
+
+    std::vector<uint8_t> window(windowSize);
+    file.seekg(properties_.audioOffset + scanStart);
+    file.read(reinterpret_cast<char*>(window.data()), window.size());
+    file.close();
+
+    MP3FrameHeader reference;
+    PRECONDITION_RETURN(file.good() == true, false);
+    PRECONDITION_RETURN(window.size() >= MP3_FRAME_HEADER_SIZE, false);
+    PRECONDITION_RETURN(MP3ParseFrameHeader(window.data(), reference) == true, false);
+
+    std::vector<uint32_t> frameOffsets;
+    frameOffsets.reserve(SEEK_POINT_INTERVAL);
+    Scan(window.data(), 0, scanEnd - scanStart, window.size(), reference, scanStart, frameOffsets);
+
+    const size_t frameIndex = frame % SEEK_POINT_INTERVAL;
+    PRECONDITION_RETURN(frameIndex < frameOffsets.size(), false);
+    frameOffset = frameOffsets[frameIndex];
+
+    return true;
+}
+
+bool MP3FrameIndex::QueryOffset(const uint32_t time, FileOffset& offset) const
+{
+    PRECONDITION_RETURN(seekTable_.frameCount > 0, false);
+    PRECONDITION_RETURN(properties_.samplesPerFrame > 0, false);
+
+    bool success = true;
+
+    // The first frames hold the encoder delay, playback time starts behind it.
+    const uint64_t sample = ((static_cast<uint64_t>(time) * properties_.sampleRate) / 1000) + properties_.encoderDelay;
+    const uint64_t frame  = sample / properties_.samplesPerFrame;
+    if(frame < seekTable_.frameCount)
+    {
+        uint32_t frameOffset = 0;
+        success              = QueryFrameOffset(static_cast<uint32_t>(frame), frameOffset);
+        offset               = properties_.audioOffset + frameOffset;
+    }
+    else
+    {
+        offset = properties_.audioOffset + properties_.audioSize;
+    }
+
+    return success;
+}
+
+size_t MP3FrameIndex::FrameCount() const
+{
+    return seekTable_.frameCount;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_MP3_FRAME_INDEX_H_INCL__
+#define __ULTRASCHALL_REAPER_MP3_FRAME_INDEX_H_INCL__
+
+#include "Common.h"
+#include "MP3Properties.h"
+
+namespace ultraschall { namespace reaper {
+
+// Offsets of every interval-th audio frame, relative to the first audio frame
+struct MP3SeekTable
+{
+    uint32_t              frameCount = 0;
+    uint32_t              interval   = 0;
+    std::vector<uint32_t> seekPoints;
+};
+
+// Maps playback time to the byte offset of the audio frame that contains it. The file is
+// memory mapped and its frame headers are walked once, in chunks that are scanned in
+// parallel and stitched together afterwards. Files that can't be mapped are read in
+// windows instead. Only a seek table is kept, in memory and in the MetadataCache. A query
+// scans the frames behind the closest seek point again.
+class MP3FrameIndex
+{
+public:
+    static const uint32_t SEEK_POINT_INTERVAL = 64;
+
+    bool Build(const UnicodeString& targetName);
+
+    // Offset from the start of the indexed file, the end of the audio stream for times past
+    // the last frame. Fails if the index is empty.
+    bool QueryOffset(const uint32_t time, FileOffset& offset) const;
+
+    size_t FrameCount() const;
+
+private:
+    struct Chunk
+    {
+        size_t                scanOffset = 0;
+        size_t                nextOffset = 0;
+        std::vector<uint32_t> frameOffsets;
+    };
+
+    bool ScanFile(const UnicodeString& targetName, std::vector<uint32_t>& frameOffsets);
+    bool ScanStream(const uint8_t* data, const size_t streamSize, std::vector<uint32_t>& frameOffsets);
+    bool ReadFile(const UnicodeString& targetName, std::vector<uint32_t>& frameOffsets);
+
+    bool QueryFrameOffset(const uint32_t frame, uint32_t& frameOffset) const;
+
+    static size_t Resync(
+        const uint8_t* data, size_t offset, const size_t streamEnd, const MP3FrameHeader& reference);
+    static size_t Scan(
+        const uint8_t* data, size_t offset, const size_t chunkEnd, const size_t streamEnd,
+        const MP3FrameHeader& reference, const size_t baseOffset, std::vector<uint32_t>& frameOffsets);
+
+    UnicodeString targetName_;
+    MP3Properties properties_;
+    MP3SeekTable  seekTable_; // relative to the first audio frame, see MAX_AUDIO_SIZE
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_MP3_FRAME_INDEX_H_INCL__
@@ -0,0 +1,361 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MP3Properties.h"
+#include "FileManager.h"
+#include "ID3V2Commit.h"
+#include "MetadataCache.h"
+
+namespace ultraschall { namespace reaper {
+
+static const size_t MAX_PROBE_SIZE     = 64 * 1024;
+static const size_t ID3V1_TAG_SIZE     = 128;
+static const size_t APE_FOOTER_SIZE    = 32;
+static const size_t ID3V2_FOOTER_SIZE  = 10;
+static const size_t VBRI_HEADER_OFFSET = MP3_FRAME_HEADER_SIZE + 32;
+
+static uint32_t ReadBigEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static uint32_t ReadSyncSafeInt(const uint8_t* data)
+{
+    return ((data[0] & 0x7f) << 21) | ((data[1] & 0x7f) << 14) | ((data[2] & 0x7f) << 7) | (data[3] & 0x7f);
+}
+
+static uint32_t ReadLittleEndianInt(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[3]) << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+}
+
+bool MP3ParseFrameHeader(const uint8_t* data, MP3FrameHeader& header)
+{
+    PRECONDITION_RETURN(data != nullptr, false);
+
+    if((data[0] != 0xff) || ((data[1] & 0xe0) != 0xe0))
+    {
+        return false;
+    }
+
+    const uint8_t versionIndex    = (data[1] >> 3) & 0x03;
+    const uint8_t layerIndex      = (data[1] >> 1) & 0x03;
+    const uint8_t bitrateIndex    = (data[2] >> 4) & 0x0f;
+    const uint8_t sampleRateIndex = (data[2] >> 2) & 0x03;
+    const uint8_t padding         = (data[2] >> 1) & 0x01;
+    const uint8_t channelMode     = (data[3] >> 6) & 0x03;
+    const uint8_t emphasis        = data[3] & 0x03;
+    if((versionIndex == 1) || (layerIndex == 0) || (bitrateIndex == 0) || (bitrateIndex == 15)
+       || (sampleRateIndex == 3) || (emphasis == 2))
+    {
+        return false;
+    }
+
+    static const uint16_t BITRATES[5][16] = {
+        {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0}, // MPEG-1, layer 1
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0},    // MPEG-1, layer 2
+        {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},     // MPEG-1, layer 3
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0},    // MPEG-2/2.5, layer 1
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0}          // MPEG-2/2.5, layer 2 and 3
+    };
+    static const uint32_t SAMPLE_RATES[3] = {44100, 48000, 32000};
+
+    header.version = (versionIndex == 3) ? 1 : ((versionIndex == 2) ? 2 : 25);
+    header.layer   = 4 - layerIndex;
+
+    const size_t   bitrateTable  = (header.version == 1) ? (header.layer - 1) : ((header.layer == 1) ? 3 : 4);
+    const uint32_t sampleRateDiv = (header.version == 1) ? 1 : ((header.version == 2) ? 2 : 4);
+    header.bitrate               = BITRATES[bitrateTable][bitrateIndex] * 1000;
+    header.sampleRate            = SAMPLE_RATES[sampleRateIndex] / sampleRateDiv;
+
+    if(header.layer == 1)
+    {
+        header.samplesPerFrame = 384;
+        header.frameSize       = ((12 * header.bitrate / header.sampleRate) + padding) * 4;
+        header.sideInfoSize    = 0;
+    }
+    else if(header.layer == 2)
+    {
+        header.samplesPerFrame = 1152;
+        header.frameSize       = (144 * header.bitrate / header.sampleRate) + padding;
+        header.sideInfoSize    = 0;
+    }
+    else
+    {
+        const bool isMono      = (channelMode == 3);
+        header.samplesPerFrame = (header.version == 1) ? 1152 : 576;
+        header.frameSize       = (((header.version == 1) ? 144 : 72) * header.bitrate / header.sampleRate) + padding;
+        header.sideInfoSize    = (header.version == 1) ? (isMono ? 17 : 32) : (isMono ? 9 : 17);
+    }
+
+    return true;
+}
+
+// A frame header is only accepted if the next frame starts where this one ends.
+static bool FindFirstFrame(const uint8_t* data, const size_t dataSize, MP3FrameHeader& header, size_t& offset)
+{
+    bool found = false;
+
+    for(size_t i = 0; ((i + MP3_FRAME_HEADER_SIZE) <= dataSize) && (false == found); i++)
+    {
+        if(MP3ParseFrameHeader(&data[i], header) == true)
+        {
+            const size_t   nextOffset = i + header.frameSize;
+            MP3FrameHeader nextHeader;
+            if(((nextOffset + MP3_FRAME_HEADER_SIZE) > dataSize)
+               || ((MP3ParseFrameHeader(&data[nextOffset], nextHeader) == true)
+                   && (nextHeader.version == header.version) && (nextHeader.layer == header.layer)
+                   && (nextHeader.sampleRate == header.sampleRate)))
+            {
+                offset = i;
+                found  = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+static size_t QueryTrailingTagSize(std::ifstream& file, const FileSize fileSize)
+{
+    size_t tagSize = 0;
+
+    uint8_t id3v1Header[3] = {0};
+    if(fileSize >= ID3V1_TAG_SIZE)
+    {
+        file.seekg(fileSize - ID3V1_TAG_SIZE);
+        file.read(reinterpret_cast<char*>(id3v1Header), sizeof(id3v1Header));
+        if(file && (memcmp(id3v1Header, "TAG", 3) == 0))
+        {
+            tagSize += ID3V1_TAG_SIZE;
+        }
+    }
+
+    uint8_t apeFooter[APE_FOOTER_SIZE] = {0};
+    if(fileSize >= (tagSize + APE_FOOTER_SIZE))
+    {
+        file.seekg(fileSize - tagSize - APE_FOOTER_SIZE);
+        file.read(reinterpret_cast<char*>(apeFooter), APE_FOOTER_SIZE);
+        if(file && (memcmp(apeFooter, "APETAGEX", 8) == 0))
+        {
+            const bool hasHeader = (apeFooter[23] & 0x80) != 0;
+            tagSize += ReadLittleEndianInt(&apeFooter[12]) + (hasHeader ? APE_FOOTER_SIZE : 0);
+        }
+    }
+
+    uint8_t id3v2Footer[ID3V2_FOOTER_SIZE] = {0};
+    if(fileSize >= (tagSize + (2 * ID3V2_FOOTER_SIZE)))
+    {
+        file.seekg(fileSize - tagSize - ID3V2_FOOTER_SIZE);
+        file.read(reinterpret_cast<char*>(id3v2Footer), ID3V2_FOOTER_SIZE);
+        if(file && (memcmp(id3v2Footer, "3DI", 3) == 0))
+        {
+            tagSize += (2 * ID3V2_FOOTER_SIZE) + ReadSyncSafeInt(&id3v2Footer[6]);
+        }
+    }
+
+    file.clear();
+    return tagSize;
+}
+
+static bool ParseXingHeader(
+    const uint8_t* data, const size_t dataSize, const MP3FrameHeader& header, uint64_t& sampleCount,
+    uint32_t& encoderDelay)
+{
+    const size_t offset = MP3_FRAME_HEADER_SIZE + header.sideInfoSize;
+    if(((offset + 8) > dataSize)
+       || ((memcmp(&data[offset], "Xing", 4) != 0) && (memcmp(&data[offset], "Info", 4) != 0)))
+    {
+        return false;
+    }
+
+    const uint32_t flags  = ReadBigEndianInt(&data[offset + 4]);
+    size_t         cursor = offset + 8;
+    if(((flags & 0x01) == 0) || ((cursor + 4) > dataSize))
+    {
+        return false;
+    }
+
+    const uint32_t frameCount = ReadBigEndianInt(&data[cursor]);
+    cursor += 4;
+    cursor += ((flags & 0x02) != 0) ? 4 : 0;   // byte count
+    cursor += ((flags & 0x04) != 0) ? 100 : 0; // seek table
+    cursor += ((flags & 0x08) != 0) ? 4 : 0;   // quality
+
+    sampleCount = static_cast<uint64_t>(frameCount) * header.samplesPerFrame;
+
+    // The LAME extension stores the encoder delay and the padding of the last frame in
+    // two 12 bit values, removing both gives the exact number of samples.
+    static const size_t LAME_DELAY_OFFSET = 21;
+    if(((cursor + LAME_DELAY_OFFSET + 3) <= dataSize)
+       && ((memcmp(&data[cursor], "LAME", 4) == 0) || (memcmp(&data[cursor], "Lavc", 4) == 0)))
+    {
+        const uint8_t* delay   = &data[cursor + LAME_DELAY_OFFSET];
+        const uint32_t padding = ((delay[1] & 0x0f) << 8) | delay[2];
+        encoderDelay           = (delay[0] << 4) | (delay[1] >> 4);
+        if(sampleCount > (encoderDelay + padding))
+        {
+            sampleCount -= encoderDelay + padding;
+        }
+    }
+
+    return true;
+}
+
+static bool ParseVbriHeader(
+    const uint8_t* data, const size_t dataSize, const MP3FrameHeader& header, uint64_t& sampleCount)
+{
+    if(((VBRI_HEADER_OFFSET + 18) > dataSize) || (memcmp(&data[VBRI_HEADER_OFFSET], "VBRI", 4) != 0))
+    {
+        return false;
+    }
+
+    const uint32_t frameCount = ReadBigEndianInt(&data[VBRI_HEADER_OFFSET + 14]);
+    sampleCount               = static_cast<uint64_t>(frameCount) * header.samplesPerFrame;
+    return true;
+}
+
+static uint64_t EstimateSampleCount(const uint8_t* data, const size_t dataSize, const FileSize audioSize)
+{
+    uint64_t sampleCount = 0;
+    size_t   offset      = 0;
+
+    MP3FrameHeader header;
+    while(((offset + MP3_FRAME_HEADER_SIZE) <= dataSize) && (MP3ParseFrameHeader(&data[offset], header) == true))
+    {
+        sampleCount += header.samplesPerFrame;
+        offset += header.frameSize;
+    }
+
+    return (offset > 0) ? ((static_cast<uint64_t>(audioSize) * sampleCount) / offset) : 0;
+}
+
+static bool ReadProperties(const UnicodeString& targetName, MP3Properties& properties)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    size_t   tagSize  = 0;
+    FileSize fileSize = 0;
+    PRECONDITION_RETURN(ServiceSucceeded(ID3V2QueryTagSize(targetName, tagSize)), false);
+    PRECONDITION_RETURN(ServiceSucceeded(FileManager::QueryFileSize(targetName, fileSize)), false);
+    PRECONDITION_RETURN(fileSize > tagSize, false);
+
+    bool success = false;
+
+    std::ifstream file(U2H(targetName), std::ios::in | std::ios::binary);
+    if(file.is_open() == true)
+    {
+        const FileOffset streamEnd
+            = fileSize - std::min<FileSize>(QueryTrailingTagSize(file, fileSize), fileSize - tagSize);
+
+        std::vector<uint8_t> buffer(static_cast<size_t>(std::min<FileSize>(streamEnd - tagSize, MAX_PROBE_SIZE)));
+        file.seekg(tagSize);
+        file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        if(file)
+        {
+            MP3FrameHeader header;
+            size_t         frameOffset = 0;
+            if(FindFirstFrame(buffer.data(), buffer.size(), header, frameOffset) == true)
+            {
+                const uint8_t* frame     = &buffer[frameOffset];
+                const size_t   frameSize = buffer.size() - frameOffset;
+
+                uint64_t sampleCount  = 0;
+                uint32_t encoderDelay = 0;
+                if((ParseXingHeader(frame, frameSize, header, sampleCount, encoderDelay) == true)
+                   || (ParseVbriHeader(frame, frameSize, header, sampleCount) == true))
+                {
+                    // The info frame carries no audio
+                    properties.audioOffset = tagSize + frameOffset + header.frameSize;
+                    properties.isEstimated = false;
+                }
+                else
+                {
+                    properties.audioOffset = tagSize + frameOffset;
+                    properties.isEstimated = true;
+                }
+
+                properties.audioSize       = streamEnd - std::min(streamEnd, properties.audioOffset);
+                properties.sampleRate      = header.sampleRate;
+                properties.samplesPerFrame = header.samplesPerFrame;
+                properties.encoderDelay    = encoderDelay;
+                if(true == properties.isEstimated)
+                {
+                    // Without a header the duration is extrapolated from the frames of the bounded
+                    // read, which is exact for constant bitrate files.
+                    sampleCount = EstimateSampleCount(frame, frameSize, properties.audioSize);
+                }
+
+                if(sampleCount > 0)
+                {
+                    const uint64_t audioBits = static_cast<uint64_t>(properties.audioSize) * 8;
+                    properties.sampleCount   = sampleCount;
+                    properties.bitrate       = static_cast<uint32_t>((audioBits * header.sampleRate) / sampleCount);
+                    properties.duration
+                        = static_cast<uint32_t>(((sampleCount * 1000) + (header.sampleRate / 2)) / header.sampleRate);
+                    success = true;
+                }
+            }
+        }
+
+        file.close();
+    }
+
+    return success;
+}
+
+bool MP3QueryProperties(const UnicodeString& targetName, MP3Properties& properties)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool success = MetadataCache::Instance().QueryMP3Properties(targetName, properties);
+    if(false == success)
+    {
+        success = ReadProperties(targetName, properties);
+        if(true == success)
+        {
+            MetadataCache::Instance().InsertMP3Properties(targetName, properties);
+        }
+    }
+
+    return success;
+}
+
+bool MP3QueryDuration(const UnicodeString& targetName, uint32_t& duration)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    MP3Properties properties;
+    const bool    success = MP3QueryProperties(targetName, properties);
+    if(true == success)
+    {
+        duration = properties.duration;
+    }
+
+    return success;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_MP3_PROPERTIES_H_INCL__
+#define __ULTRASCHALL_REAPER_MP3_PROPERTIES_H_INCL__
+
+#include "Common.h"
+
+namespace ultraschall { namespace reaper {
+
+static const size_t MP3_FRAME_HEADER_SIZE = 4;
+
+struct MP3FrameHeader
+{
+    uint32_t sampleRate      = 0;
+    uint32_t bitrate         = 0; // bits per second
+    uint32_t samplesPerFrame = 0;
+    size_t   frameSize       = 0;
+    size_t   sideInfoSize    = 0;
+    uint8_t  version         = 0; // 1 = MPEG-1, 2 = MPEG-2, 25 = MPEG-2.5
+    uint8_t  layer           = 0;
+};
+
+// Decodes a 4 byte MPEG audio frame header, free format frames are rejected.
+bool MP3ParseFrameHeader(const uint8_t* data, MP3FrameHeader& header);
+
+struct MP3Properties
+{
+    FileOffset audioOffset     = -1; // first audio frame, the Xing/Info/VBRI frame is not counted as audio
+    FileSize   audioSize       = 0;
+    uint32_t   sampleRate      = 0;
+    uint32_t   samplesPerFrame = 0;
+    uint32_t   encoderDelay    = 0;  // samples
+    uint32_t   bitrate         = 0;  // average bits per second
+    uint64_t   sampleCount     = 0;
+    uint32_t   duration        = 0;  // milliseconds
+    bool       isEstimated     = false;
+};
+
+// Reads the headers at the start of the audio stream only. The duration is taken from a
+// Xing/Info or VBRI header and corrected by the LAME encoder delay and padding. Without such
+// a header it is estimated from the average bitrate of the first frames.
+bool MP3QueryProperties(const UnicodeString& targetName, MP3Properties& properties);
+
+// Duration in milliseconds, left untouched if the file can't be read.
+bool MP3QueryDuration(const UnicodeString& targetName, uint32_t& duration);
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_MP3_PROPERTIES_H_INCL__
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MappedBinaryStream.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+MappedBinaryStream* MappedBinaryStream::Create(const UnicodeString& filename, const bool mapContents)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    MappedBinaryStream* pStream = nullptr;
+
+    std::ifstream file(U2H(filename), std::ios::in | std::ios::binary | std::ios::ate);
+    if(file.is_open() == true)
+    {
+        // A file that exceeds the address space can neither be mapped nor buffered.
+        const std::streamoff fileSize = file.tellg();
+        if((fileSize > 0) && (static_cast<FileSize>(fileSize) <= SIZE_MAX))
+        {
+            pStream = new MappedBinaryStream();
+            if((true == mapContents) && (static_cast<size_t>(fileSize) >= MIN_MAPPING_SIZE))
+            {
+                pStream->data_     = PlatformGateway::MapFile(filename, pStream->dataSize_);
+                pStream->isMapped_ = (pStream->data_ != nullptr);
+            }
+
+            if(pStream->isMapped_ == false)
+            {
+                uint8_t* buffer = new uint8_t[static_cast<size_t>(fileSize)];
+                file.seekg(0);
+                file.read(reinterpret_cast<char*>(buffer), fileSize);
+                pStream->data_     = buffer;
+                pStream->dataSize_ = static_cast<size_t>(fileSize);
+                if(!file)
+                {
+                    SafeRelease(pStream);
+                }
+            }
+        }
+
+        file.close();
+    }
+
+    return pStream;
+}
+
+MappedBinaryStream::~MappedBinaryStream()
+{
+    if(true == isMapped_)
+    {
+        PlatformGateway::UnmapFile(data_, dataSize_);
+    }
+    else
+    {
+        delete[] data_;
+    }
+
+    data_     = nullptr;
+    dataSize_ = 0;
+}
+
+size_t MappedBinaryStream::DataSize() const
+{
+    return dataSize_;
+}
+
+const uint8_t* MappedBinaryStream::Data() const
+{
+    return data_;
+}
+
+bool MappedBinaryStream::Write(const size_t, const uint8_t*, const size_t)
+{
+    return false;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_MAPPED_BINARY_STREAM_H_INCL__
+#define __ULTRASCHALL_REAPER_MAPPED_BINARY_STREAM_H_INCL__
+
+#include "BinaryStream.h"
+
+namespace ultraschall { namespace reaper {
+
+// Read-only stream over the contents of a file. Files of at least MIN_MAPPING_SIZE bytes are
+// memory-mapped unless mapContents is false, smaller files and files that can't be mapped are
+// read into a buffer.
+class MappedBinaryStream : public BinaryStream
+{
+public:
+    static MappedBinaryStream* Create(const UnicodeString& filename, const bool mapContents = true);
+
+    virtual size_t DataSize() const override;
+
+    virtual const uint8_t* Data() const override;
+
+    virtual bool Write(const size_t offset, const uint8_t* buffer, const size_t bufferSize) override;
+
+protected:
+    virtual ~MappedBinaryStream();
+
+private:
+    MappedBinaryStream() = default;
+
+    static const size_t MIN_MAPPING_SIZE = 64 * 1024;
+
+    const uint8_t* data_     = nullptr;
+    size_t         dataSize_ = 0;
+    bool           isMapped_ = false;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_MAPPED_BINARY_STREAM_H_INCL__
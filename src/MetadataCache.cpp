@@ -0,0 +1,516 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MetadataCache.h"
+#include "AtomicFileWriter.h"
+#include "FileManager.h"
+
+namespace ultraschall { namespace reaper {
+
+static const uint8_t  CACHE_FILE_MAGIC[4] = {'U', 'S', 'M', 'C'};
+static const uint32_t BYTE_ORDER_MARK     = 0x01020304;
+
+// The file starts with a header that is followed by one record per entry. The records are aligned to 8 bytes and
+// can be read in place from a mapped file. Integers are stored in the byte order of the machine that has written
+// the file, the byte order mark rejects files from other machines.
+struct CacheFileHeader
+{
+    uint8_t  magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t entryCount;
+};
+
+struct CacheRecord
+{
+    uint32_t recordSize; // including the path and the seek points that follow
+    uint32_t flags;
+    uint32_t pathSize;
+    uint32_t frameCount;
+    uint64_t fileId;
+    uint64_t fileSize;
+    uint64_t modificationTime;
+    uint64_t audioOffset;
+    uint64_t audioSize;
+    uint64_t sampleCount;
+    uint32_t sampleRate;
+    uint32_t samplesPerFrame;
+    uint32_t encoderDelay;
+    uint32_t bitrate;
+    uint32_t duration;
+    uint32_t isEstimated;
+    uint64_t imageHash;
+    uint32_t imageFormat;
+    uint32_t imageWidth;
+    uint32_t imageHeight;
+    uint32_t seekPointCount;
+    uint64_t tagHash;
+    uint32_t seekPointInterval;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CacheFileHeader) == 16, "The cache file header must not be padded");
+static_assert(sizeof(CacheRecord) == 128, "The cache record must not be padded");
+
+static size_t Align(const size_t size, const size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+MetadataCache& MetadataCache::Instance()
+{
+    static MetadataCache self;
+    return self;
+}
+
+MetadataCache::~MetadataCache()
+{
+    if(mappedData_ != nullptr)
+    {
+        PlatformGateway::UnmapFile(mappedData_, mappedSize_);
+    }
+}
+
+UnicodeString MetadataCache::CacheFileName()
+{
+    return FileManager::AppendPath(PlatformGateway::QueryReaperProfilePath(), "ultraschall-metadata.cache");
+}
+
+void MetadataCache::Load()
+{
+    isLoaded_ = true;
+
+    mappedData_ = PlatformGateway::MapFile(CacheFileName(), mappedSize_);
+    PRECONDITION(mappedData_ != nullptr);
+
+    CacheFileHeader header = {};
+    if(mappedSize_ >= sizeof(header))
+    {
+        memcpy(&header, mappedData_, sizeof(header));
+    }
+
+    // Only the paths are read here, a record is decoded when its file is looked up.
+    if((memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) == 0) && (header.version == FILE_VERSION)
+       && (header.byteOrder == BYTE_ORDER_MARK))
+    {
+        size_t offset = sizeof(header);
+        for(uint32_t i = 0; (i < header.entryCount) && ((offset + sizeof(CacheRecord)) <= mappedSize_); i++)
+        {
+            CacheRecord record;
+            memcpy(&record, &mappedData_[offset], sizeof(record));
+
+            const size_t pathOffset = offset + sizeof(record);
+            const size_t seekOffset = pathOffset + Align(record.pathSize, 4);
+            const size_t recordEnd  = seekOffset + (static_cast<size_t>(record.seekPointCount) * sizeof(uint32_t));
+            if((record.recordSize < sizeof(record)) || (record.recordSize > (mappedSize_ - offset))
+               || (recordEnd > (offset + record.recordSize)))
+            {
+                break;
+            }
+
+            const UnicodeString path(reinterpret_cast<const char*>(&mappedData_[pathOffset]), record.pathSize);
+            records_[path] = offset;
+
+            offset += record.recordSize;
+        }
+    }
+
+    if(records_.empty() == true)
+    {
+        PlatformGateway::UnmapFile(mappedData_, mappedSize_);
+        mappedData_ = nullptr;
+        mappedSize_ = 0;
+    }
+}
+
+bool MetadataCache::DecodeRecord(const size_t offset, Entry& entry) const
+{
+    PRECONDITION_RETURN(mappedData_ != nullptr, false);
+    PRECONDITION_RETURN((offset + sizeof(CacheRecord)) <= mappedSize_, false);
+
+    // The bounds of the record have been checked by Load().
+    CacheRecord record;
+    memcpy(&record, &mappedData_[offset], sizeof(record));
+
+    entry.identity.fileId           = record.fileId;
+    entry.identity.size             = record.fileSize;
+    entry.identity.modificationTime = record.modificationTime;
+    entry.flags                     = record.flags;
+
+    entry.mp3Properties.audioOffset     = record.audioOffset;
+    entry.mp3Properties.audioSize       = record.audioSize;
+    entry.mp3Properties.sampleCount     = record.sampleCount;
+    entry.mp3Properties.sampleRate      = record.sampleRate;
+    entry.mp3Properties.samplesPerFrame = record.samplesPerFrame;
+    entry.mp3Properties.encoderDelay    = record.encoderDelay;
+    entry.mp3Properties.bitrate         = record.bitrate;
+    entry.mp3Properties.duration        = record.duration;
+    entry.mp3Properties.isEstimated     = (record.isEstimated != 0);
+
+    entry.seekTable.frameCount = record.frameCount;
+    entry.seekTable.interval   = record.seekPointInterval;
+    entry.seekTable.seekPoints.resize(record.seekPointCount);
+    if(record.seekPointCount > 0)
+    {
+        const size_t seekOffset = offset + sizeof(record) + Align(record.pathSize, 4);
+        memcpy(
+            entry.seekTable.seekPoints.data(), &mappedData_[seekOffset], record.seekPointCount * sizeof(uint32_t));
+    }
+
+    entry.imageProperties.hash   = record.imageHash;
+    entry.imageProperties.format = static_cast<Picture::FORMAT>(record.imageFormat);
+    entry.imageProperties.width  = record.imageWidth;
+    entry.imageProperties.height = record.imageHeight;
+
+    entry.tagHash = record.tagHash;
+
+    return true;
+}
+
+void MetadataCache::ReleaseMapping()
+{
+    for(std::map<UnicodeString, size_t>::const_iterator i = records_.begin(); i != records_.end(); i++)
+    {
+        Entry entry;
+        if(DecodeRecord(i->second, entry) == true)
+        {
+            entries_.insert(std::make_pair(i->first, entry));
+        }
+    }
+
+    records_.clear();
+
+    if(mappedData_ != nullptr)
+    {
+        PlatformGateway::UnmapFile(mappedData_, mappedSize_);
+        mappedData_ = nullptr;
+        mappedSize_ = 0;
+    }
+}
+
+bool MetadataCache::Save()
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    PRECONDITION_RETURN(true == isDirty_, true);
+
+    // The cache file is replaced below, the records that nobody has looked up are moved out of it first.
+    ReleaseMapping();
+
+    uint32_t entryCount = 0;
+    for(std::map<UnicodeString, Entry>::const_iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+        if(i->second.flags != 0)
+        {
+            entryCount++;
+        }
+    }
+
+    AtomicFileWriter writer(CacheFileName(), FILE_SYNC_POLICY::NONE);
+
+    CacheFileHeader header = {};
+    memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+    header.version    = FILE_VERSION;
+    header.byteOrder  = BYTE_ORDER_MARK;
+    header.entryCount = entryCount;
+    writer.Write(UnicodeStringView(reinterpret_cast<const char*>(&header), sizeof(header)));
+
+    static const char PADDING[8] = {0};
+    for(std::map<UnicodeString, Entry>::const_iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+        const UnicodeString& path  = i->first;
+        const Entry&         entry = i->second;
+        if(entry.flags != 0)
+        {
+            const std::vector<uint32_t>& seekPoints = entry.seekTable.seekPoints;
+
+            const size_t pathSize   = Align(path.size(), 4);
+            const size_t seekSize   = seekPoints.size() * sizeof(uint32_t);
+            const size_t recordSize = Align(sizeof(CacheRecord) + pathSize + seekSize, 8);
+
+            CacheRecord record      = {};
+            record.recordSize       = static_cast<uint32_t>(recordSize);
+            record.flags            = entry.flags;
+            record.pathSize         = static_cast<uint32_t>(path.size());
+            record.fileId           = entry.identity.fileId;
+            record.fileSize         = entry.identity.size;
+            record.modificationTime = entry.identity.modificationTime;
+
+            record.audioOffset     = entry.mp3Properties.audioOffset;
+            record.audioSize       = entry.mp3Properties.audioSize;
+            record.sampleCount     = entry.mp3Properties.sampleCount;
+            record.sampleRate      = entry.mp3Properties.sampleRate;
+            record.samplesPerFrame = entry.mp3Properties.samplesPerFrame;
+            record.encoderDelay    = entry.mp3Properties.encoderDelay;
+            record.bitrate         = entry.mp3Properties.bitrate;
+            record.duration        = entry.mp3Properties.duration;
+            record.isEstimated     = (true == entry.mp3Properties.isEstimated) ? 1 : 0;
+
+            record.frameCount        = entry.seekTable.frameCount;
+            record.seekPointInterval = entry.seekTable.interval;
+            record.seekPointCount    = static_cast<uint32_t>(seekPoints.size());
+
+            record.imageHash   = entry.imageProperties.hash;
+            record.imageFormat = static_cast<uint32_t>(entry.imageProperties.format);
+            record.imageWidth  = entry.imageProperties.width;
+            record.imageHeight = entry.imageProperties.height;
+
+            record.tagHash = entry.tagHash;
+
+            writer.Write(UnicodeStringView(reinterpret_cast<const char*>(&record), sizeof(record)));
+            writer.Write(path);
+            writer.Write(UnicodeStringView(PADDING, pathSize - path.size()));
+            writer.Write(UnicodeStringView(reinterpret_cast<const char*>(seekPoints.data()), seekSize));
+            writer.Write(UnicodeStringView(PADDING, recordSize - sizeof(CacheRecord) - pathSize - seekSize));
+        }
+    }
+
+    const bool success = writer.Commit();
+    if(true == success)
+    {
+        isDirty_ = false;
+    }
+
+    return success;
+}
+
+MetadataCache::Entry* MetadataCache::FindEntry(const UnicodeString& filename)
+{
+    if(false == isLoaded_)
+    {
+        Load();
+    }
+
+    std::map<UnicodeString, Entry>::iterator entryIterator = entries_.find(filename);
+    if(entryIterator == entries_.end())
+    {
+        std::map<UnicodeString, size_t>::iterator recordIterator = records_.find(filename);
+        if(recordIterator != records_.end())
+        {
+            Entry entry;
+            if(DecodeRecord(recordIterator->second, entry) == true)
+            {
+                entryIterator = entries_.insert(std::make_pair(filename, entry)).first;
+            }
+
+            records_.erase(recordIterator);
+        }
+    }
+
+    return (entryIterator != entries_.end()) ? &entryIterator->second : nullptr;
+}
+
+MetadataCache::Entry* MetadataCache::QueryEntry(const UnicodeString& filename, const uint32_t flag)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    Entry* pEntry = FindEntry(filename);
+    if((pEntry != nullptr) && ((pEntry->flags & flag) != 0))
+    {
+        FileIdentity identity;
+        if((PlatformGateway::QueryFileIdentity(filename, identity) == true) && (identity == pEntry->identity))
+        {
+            pEntry->lastUsed = ++useCount_;
+        }
+        else
+        {
+            pEntry = nullptr;
+        }
+    }
+    else
+    {
+        pEntry = nullptr;
+    }
+
+    return pEntry;
+}
+
+MetadataCache::Entry* MetadataCache::InsertEntry(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    FileIdentity identity;
+    PRECONDITION_RETURN(PlatformGateway::QueryFileIdentity(filename, identity) == true, nullptr);
+
+    Entry* pEntry = FindEntry(filename);
+    if(pEntry == nullptr)
+    {
+        // Records that haven't been looked up since the cache was loaded are dropped first.
+        if((entries_.size() + records_.size()) >= MAX_ENTRIES)
+        {
+            if(records_.empty() == false)
+            {
+                records_.erase(records_.begin());
+            }
+            else
+            {
+                std::map<UnicodeString, Entry>::iterator leastRecentlyUsed = entries_.begin();
+                for(std::map<UnicodeString, Entry>::iterator i = entries_.begin(); i != entries_.end(); i++)
+                {
+                    if(i->second.lastUsed < leastRecentlyUsed->second.lastUsed)
+                    {
+                        leastRecentlyUsed = i;
+                    }
+                }
+
+                entries_.erase(leastRecentlyUsed);
+            }
+        }
+
+        pEntry = &entries_.insert(std::make_pair(filename, Entry())).first->second;
+    }
+
+    if(pEntry->identity != identity)
+    {
+        *pEntry          = Entry();
+        pEntry->identity = identity;
+    }
+
+    pEntry->lastUsed = ++useCount_;
+    isDirty_         = true;
+
+    return pEntry;
+}
+
+bool MetadataCache::QueryMP3Properties(const UnicodeString& filename, MP3Properties& properties)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    const Entry* pEntry = QueryEntry(filename, MP3_PROPERTIES);
+    if(pEntry != nullptr)
+    {
+        properties = pEntry->mp3Properties;
+    }
+
+    return pEntry != nullptr;
+}
+
+void MetadataCache::InsertMP3Properties(const UnicodeString& filename, const MP3Properties& properties)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    Entry* pEntry = InsertEntry(filename);
+    if(pEntry != nullptr)
+    {
+        pEntry->mp3Properties = properties;
+        pEntry->flags |= MP3_PROPERTIES;
+    }
+}
+
+bool MetadataCache::QuerySeekTable(const UnicodeString& filename, MP3SeekTable& seekTable)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    const Entry* pEntry = QueryEntry(filename, SEEK_TABLE);
+    if(pEntry != nullptr)
+    {
+        seekTable = pEntry->seekTable;
+    }
+
+    return pEntry != nullptr;
+}
+
+void MetadataCache::InsertSeekTable(const UnicodeString& filename, const MP3SeekTable& seekTable)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    Entry* pEntry = InsertEntry(filename);
+    if(pEntry != nullptr)
+    {
+        pEntry->seekTable = seekTable;
+        pEntry->flags |= SEEK_TABLE;
+    }
+}
+
+bool MetadataCache::QueryImageProperties(const UnicodeString& filename, ImageProperties& properties)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    const Entry* pEntry = QueryEntry(filename, IMAGE_PROPERTIES);
+    if(pEntry != nullptr)
+    {
+        properties = pEntry->imageProperties;
+    }
+
+    return pEntry != nullptr;
+}
+
+void MetadataCache::InsertImageProperties(const UnicodeString& filename, const ImageProperties& properties)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    Entry* pEntry = InsertEntry(filename);
+    if(pEntry != nullptr)
+    {
+        pEntry->imageProperties = properties;
+        pEntry->flags |= IMAGE_PROPERTIES;
+    }
+}
+
+bool MetadataCache::QueryTagHash(const UnicodeString& filename, uint64_t& tagHash)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    const Entry* pEntry = QueryEntry(filename, TAG_HASH);
+    if(pEntry != nullptr)
+    {
+        tagHash = pEntry->tagHash;
+    }
+
+    return pEntry != nullptr;
+}
+
+void MetadataCache::UpdateTagHash(
+    const UnicodeString& filename, const FileIdentity& previousIdentity, const uint64_t tagHash)
+{
+    std::lock_guard<std::recursive_mutex> lock(cacheLock_);
+
+    // The seek table is carried over if it has been valid right before the tags were rewritten.
+    bool         keepSeekTable = false;
+    MP3SeekTable seekTable;
+
+    Entry* pPreviousEntry = FindEntry(filename);
+    if((pPreviousEntry != nullptr) && ((pPreviousEntry->flags & SEEK_TABLE) != 0)
+       && (pPreviousEntry->identity == previousIdentity))
+    {
+        seekTable     = std::move(pPreviousEntry->seekTable);
+        keepSeekTable = true;
+    }
+
+    Entry* pEntry = InsertEntry(filename);
+    if(pEntry != nullptr)
+    {
+        pEntry->tagHash = tagHash;
+        pEntry->flags |= TAG_HASH;
+        if(true == keepSeekTable)
+        {
+            pEntry->seekTable = std::move(seekTable);
+            pEntry->flags |= SEEK_TABLE;
+        }
+    }
+}
+
+}} // namespace ultraschall::reaper
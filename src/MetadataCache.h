@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_METADATA_CACHE_H_INCL__
+#define __ULTRASCHALL_REAPER_METADATA_CACHE_H_INCL__
+
+#include "Common.h"
+#include "MP3FrameIndex.h"
+#include "MP3Properties.h"
+#include "Picture.h"
+#include "PlatformGateway.h"
+
+namespace ultraschall { namespace reaper {
+
+struct ImageProperties
+{
+    Picture::FORMAT format = Picture::FORMAT::UNKNOWN_PICTURE;
+    uint32_t        width  = 0;
+    uint32_t        height = 0;
+    uint64_t        hash   = 0;
+};
+
+// Metadata of media files that is kept between action runs. An entry is bound to the identity of its file and is
+// ignored as soon as the file has been replaced or modified by anyone but the tag writers. The cache file in the
+// REAPER profile directory is mapped on first use, its records are only decoded once their file is looked up.
+// Save() writes the cache back.
+class MetadataCache
+{
+public:
+    static MetadataCache& Instance();
+
+    bool QueryMP3Properties(const UnicodeString& filename, MP3Properties& properties);
+    void InsertMP3Properties(const UnicodeString& filename, const MP3Properties& properties);
+
+    // The seek points are relative to the first audio frame and don't depend on the tags of the file.
+    bool QuerySeekTable(const UnicodeString& filename, MP3SeekTable& seekTable);
+    void InsertSeekTable(const UnicodeString& filename, const MP3SeekTable& seekTable);
+
+    bool QueryImageProperties(const UnicodeString& filename, ImageProperties& properties);
+    void InsertImageProperties(const UnicodeString& filename, const ImageProperties& properties);
+
+    // Hash of the tag that has been committed last. The tag writers call UpdateTagHash() after they have rewritten
+    // the file, previousIdentity is the identity of the file before the commit. The seek table is kept since
+    // rewriting the tags doesn't move the audio frames relative to each other.
+    bool QueryTagHash(const UnicodeString& filename, uint64_t& tagHash);
+    void UpdateTagHash(const UnicodeString& filename, const FileIdentity& previousIdentity, const uint64_t tagHash);
+
+    bool Save();
+
+private:
+    MetadataCache() {}
+    ~MetadataCache();
+
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+
+    static const uint32_t FILE_VERSION = 2;
+    static const size_t   MAX_ENTRIES  = 512;
+
+    enum ENTRY_FLAGS : uint32_t
+    {
+        MP3_PROPERTIES   = 0x01,
+        SEEK_TABLE       = 0x02,
+        IMAGE_PROPERTIES = 0x04,
+        TAG_HASH         = 0x08
+    };
+
+    struct Entry
+    {
+        FileIdentity    identity;
+        uint32_t        flags = 0;
+        MP3Properties   mp3Properties;
+        MP3SeekTable    seekTable;
+        ImageProperties imageProperties;
+        uint64_t        tagHash  = 0;
+        uint64_t        lastUsed = 0;
+    };
+
+    static UnicodeString CacheFileName();
+
+    void   Load();
+    void   ReleaseMapping();
+    Entry* FindEntry(const UnicodeString& filename);
+    Entry* QueryEntry(const UnicodeString& filename, const uint32_t flag);
+    Entry* InsertEntry(const UnicodeString& filename);
+
+    bool DecodeRecord(const size_t offset, Entry& entry) const;
+
+    std::map<UnicodeString, Entry>  entries_;
+    std::map<UnicodeString, size_t> records_; // records in the mapped file that haven't been decoded yet
+    const uint8_t*                  mappedData_ = nullptr;
+    size_t                          mappedSize_ = 0;
+    uint64_t                        useCount_   = 0;
+    bool                            isLoaded_   = false;
+    bool                            isDirty_    = false;
+    mutable std::recursive_mutex    cacheLock_;
+};
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_METADATA_CACHE_H_INCL__
@@ -47,6 +47,13 @@ void NotificationStore::RegisterNotification(const NotificationClass severity, c
     messageQueue_.Add(severity, str);
 }
 
+void NotificationStore::RegisterNotifications(const NotificationArray& notifications)
+{
+    std::for_each(notifications.begin(), notifications.end(), [&](const Notification& notification) {
+        messageQueue_.Add(notification);
+    });
+}
+
 void NotificationStore::DispatchNotifications()
 {
     PRECONDITION(messageQueue_.ItemCount() > 0);
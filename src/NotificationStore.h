@@ -44,6 +44,8 @@ class NotificationStore
     inline void RegisterError(const UnicodeString& str);
     inline void RegisterFatalError(const UnicodeString& str);
 
+    void RegisterNotifications(const NotificationArray& notifications);
+
 private:
     static const UnicodeString NOTIFICATION_SECTION_NAME;
     static const UnicodeString NOTIFICATION_VALUE_COUNT_NAME;
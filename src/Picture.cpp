@@ -25,8 +25,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "Picture.h"
-#include "FileManager.h"
-#include "PlatformGateway.h"
+#include "ImageCache.h"
+#include "MetadataCache.h"
 
 namespace ultraschall { namespace reaper {
 
@@ -62,32 +62,32 @@ Picture::FORMAT Picture::Format(const UnicodeString& filename)
 {
     PRECONDITION_RETURN(filename.empty() == false, FORMAT::UNKNOWN_PICTURE);
 
-    FORMAT        format  = FORMAT::UNKNOWN_PICTURE;
-    BinaryStream* pStream = FileManager::ReadBinaryFile(filename);
-    if(pStream != nullptr) {
-        format = Format(pStream);
+    FORMAT format = FORMAT::UNKNOWN_PICTURE;
 
-        SafeRelease(pStream);
+    // Images that haven't changed since a previous run aren't read again.
+    ImageProperties imageProperties;
+    if(MetadataCache::Instance().QueryImageProperties(filename, imageProperties) == true) {
+        format = imageProperties.format;
+    }
+    else if(Image* pImage = ImageCache::Instance().Lookup(filename); pImage != nullptr) {
+        format = Format(pImage->Data(), pImage->DataSize());
+        SafeRelease(pImage);
     }
 
     return format;
 }
 
-UnicodeString Picture::FormatString(const uint8_t* data, const size_t dataSize)
+static UnicodeString MimeTypeFromFormat(const Picture::FORMAT format)
 {
-    PRECONDITION_RETURN(data != nullptr, UnicodeString());
-    PRECONDITION_RETURN(dataSize > 0, UnicodeString());
-
     UnicodeString formatString;
 
-    const FORMAT pictureFormat = Format(data, dataSize);
-    switch(pictureFormat) {
-        case FORMAT::JPEG:
+    switch(format) {
+        case Picture::FORMAT::JPEG:
         {
             formatString = "image/jpeg";
             break;
         }
-        case FORMAT::PNG:
+        case Picture::FORMAT::PNG:
         {
             formatString = "image/png";
             break;
@@ -101,6 +101,14 @@ UnicodeString Picture::FormatString(const uint8_t* data, const size_t dataSize)
     return formatString;
 }
 
+UnicodeString Picture::FormatString(const uint8_t* data, const size_t dataSize)
+{
+    PRECONDITION_RETURN(data != nullptr, UnicodeString());
+    PRECONDITION_RETURN(dataSize > 0, UnicodeString());
+
+    return MimeTypeFromFormat(Format(data, dataSize));
+}
+
 UnicodeString Picture::FormatString(const BinaryStream* pStream)
 {
     PRECONDITION_RETURN(pStream != nullptr, UnicodeString());
@@ -113,13 +121,68 @@ UnicodeString Picture::FormatString(const UnicodeString& filename)
     PRECONDITION_RETURN(filename.empty() == false, UnicodeString());
 
     UnicodeString formatString;
-    BinaryStream* pStream = FileManager::ReadBinaryFile(filename);
-    if(pStream != nullptr) {
-        formatString = FormatString(pStream);
-        SafeRelease(pStream);
+
+    ImageProperties imageProperties;
+    if(MetadataCache::Instance().QueryImageProperties(filename, imageProperties) == true) {
+        formatString = MimeTypeFromFormat(imageProperties.format);
+    }
+    else if(Image* pImage = ImageCache::Instance().Lookup(filename); pImage != nullptr) {
+        formatString = pImage->MimeType();
+        SafeRelease(pImage);
     }
 
     return formatString;
 }
 
+static uint32_t ReadBigEndianInt16(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 8) | data[1];
+}
+
+static uint32_t ReadBigEndianInt32(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+bool Picture::Dimensions(const uint8_t* data, const size_t dataSize, uint32_t& width, uint32_t& height)
+{
+    PRECONDITION_RETURN(data != nullptr, false);
+    PRECONDITION_RETURN(dataSize > 0, false);
+
+    bool success = false;
+
+    width  = 0;
+    height = 0;
+
+    const FORMAT pictureFormat = Format(data, dataSize);
+    if(pictureFormat == FORMAT::PNG) {
+        // The IHDR chunk is always the first chunk
+        if((dataSize >= 24) && (memcmp(&data[12], "IHDR", 4) == 0)) {
+            width   = ReadBigEndianInt32(&data[16]);
+            height  = ReadBigEndianInt32(&data[20]);
+            success = true;
+        }
+    }
+    else if(pictureFormat == FORMAT::JPEG) {
+        // Skip from segment to segment until a start of frame marker has been found
+        size_t offset = 2;
+        while(((offset + 9) <= dataSize) && (false == success) && (data[offset] == 0xff)) {
+            const uint8_t marker = data[offset + 1];
+            if((marker >= 0xc0) && (marker <= 0xcf) && (marker != 0xc4) && (marker != 0xc8) && (marker != 0xcc)) {
+                height  = ReadBigEndianInt16(&data[offset + 5]);
+                width   = ReadBigEndianInt16(&data[offset + 7]);
+                success = true;
+            }
+            else if((marker == 0xff) || (marker == 0x01) || ((marker >= 0xd0) && (marker <= 0xd7))) {
+                offset += (marker == 0xff) ? 1 : 2; // fill byte or marker without payload
+            }
+            else {
+                offset += 2 + ReadBigEndianInt16(&data[offset + 2]);
+            }
+        }
+    }
+
+    return success;
+}
+
 }} // namespace ultraschall::reaper
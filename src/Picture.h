@@ -49,6 +49,8 @@ class Picture
     static UnicodeString FormatString(const uint8_t* data, const size_t dataSize);
     static UnicodeString FormatString(const BinaryStream* pStream);
     static UnicodeString FormatString(const UnicodeString& filename);
+
+    static bool Dimensions(const uint8_t* data, const size_t dataSize, uint32_t& width, uint32_t& height);
 };
 
 }} // namespace ultraschall::reaper
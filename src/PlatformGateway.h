@@ -41,13 +41,85 @@
 
 namespace ultraschall { namespace reaper {
 
+struct DirectoryEntry
+{
+    UnicodeString name;
+    FileSize      size             = -1;
+    uint64_t      modificationTime = -1;
+};
+
+typedef std::vector<DirectoryEntry> DirectoryEntryArray;
+
+// Changes whenever the file is replaced or modified, fileId is the inode or the NTFS file index.
+struct FileIdentity
+{
+    uint64_t fileId           = -1;
+    uint64_t size             = -1;
+    uint64_t modificationTime = -1;
+};
+
+inline bool operator==(const FileIdentity& lhs, const FileIdentity& rhs)
+{
+    return (lhs.fileId == rhs.fileId) && (lhs.size == rhs.size) && (lhs.modificationTime == rhs.modificationTime);
+}
+
+inline bool operator!=(const FileIdentity& lhs, const FileIdentity& rhs)
+{
+    return (lhs == rhs) == false;
+}
+
+// A piece of data that points into a buffer owned by the caller. Sequences of segments are written without
+// copying them into a single buffer first.
+struct FileSegment
+{
+    const uint8_t* data     = nullptr;
+    size_t         dataSize = 0;
+
+    FileSegment(const uint8_t* segmentData, const size_t segmentSize) : data(segmentData), dataSize(segmentSize) {}
+};
+
+typedef std::vector<FileSegment> FileSegmentArray;
+
+enum class FILE_SYNC_POLICY
+{
+    NONE, // leave the data to the operating system
+    DATA, // flush the data and the metadata required to read it back
+    FULL  // flush the data, all metadata and the drive cache where the platform allows it
+};
+
 class PlatformGateway
 {
 public:
     static UnicodeString QueryReaperProfilePath();
 
-    static UnicodeChar QueryPathSeparator();
-    static size_t      QueryAvailableDiskSpace(const UnicodeString& directory);
+    static UnicodeChar   QueryPathSeparator();
+    static ServiceStatus QueryAvailableDiskSpace(const UnicodeString& directory, FileSize& availableSpace);
+    static uint64_t      QueryFileModificationTime(const UnicodeString& filename);
+    static bool          QueryFileIdentity(const UnicodeString& filename, FileIdentity& identity);
+
+    static bool AppendFileData(
+        const UnicodeString& targetName, const UnicodeString& sourceName, const FileOffset sourceOffset);
+    static bool RenameFile(const UnicodeString& sourceName, const UnicodeString& targetName);
+    // Overwrites the file from offset on and cuts off whatever is left behind the data. The size of the open file is
+    // checked first, nothing is written if it isn't expectedSize anymore.
+    static bool ReplaceFileTail(
+        const UnicodeString& filename, const FileSize expectedSize, const FileOffset offset,
+        const FileSegmentArray& segments);
+    static bool SyncFile(const UnicodeString& filename, const FILE_SYNC_POLICY policy);
+
+    // Files that don't fit into the address space aren't mapped, the caller has to stream them.
+    static const uint8_t* MapFile(const UnicodeString& filename, size_t& fileSize);
+    static void           UnmapFile(const uint8_t* data, const size_t dataSize);
+
+    // Lists the regular files of a directory, subdirectories are skipped.
+    static bool QueryDirectoryEntries(const UnicodeString& directory, DirectoryEntryArray& entries);
+    static bool QueryCaseSensitiveFileNames();
+
+    // Returns -1 if the platform can't report changes to the directory. QueryChangedDirectories() doesn't block
+    // and reports -1 if notifications have been lost and all watched directories must be considered changed.
+    static int64_t              WatchDirectory(const UnicodeString& directory);
+    static void                 UnwatchDirectory(const int64_t watch);
+    static std::vector<int64_t> QueryChangedDirectories();
 
     static UnicodeString SelectChaptersFile(
         const UnicodeString& dialogCaption, const UnicodeString& initialDirectory = "",
@@ -44,6 +44,8 @@ void (*format_timestr_pos)(double tpos, char* buf, int buf_sz, int modeoverride)
 double (*parse_timestr)(const char* buf);
 
 void (*PreventUIRefresh)(int prevent_count);
+void (*Undo_BeginBlock2)(ReaProject* proj);
+void (*Undo_EndBlock2)(ReaProject* proj, const char* descchange, int extraflags);
 
 int (*CountProjectMarkers)(ReaProject* proj, int* num_markersOut, int* num_regionsOut);
 int (*EnumProjectMarkers)(
@@ -134,6 +136,8 @@ bool ReaperEntryPoints::LoadEntryPoints(REAPER_PLUGIN_HINSTANCE instance, reaper
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::format_timestr_pos, "format_timestr_pos");
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::parse_timestr, "parse_timestr");
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::PreventUIRefresh, "PreventUIRefresh");
+    LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::Undo_BeginBlock2, "Undo_BeginBlock2");
+    LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::Undo_EndBlock2, "Undo_EndBlock2");
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::CountProjectMarkers, "CountProjectMarkers");
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::EnumProjectMarkers, "EnumProjectMarkers");
     LOAD_AND_VERIFY_REAPER_ENTRY_POINT(ppi, reaper_api::EnumProjectMarkers2, "EnumProjectMarkers2");
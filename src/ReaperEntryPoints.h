@@ -47,6 +47,8 @@
 #define REAPERAPI_WANT_format_timestr_pos
 #define REAPERAPI_WANT_parse_timestr
 #define REAPERAPI_WANT_PreventUIRefresh
+#define REAPERAPI_WANT_Undo_BeginBlock2
+#define REAPERAPI_WANT_Undo_EndBlock2
 #define REAPERAPI_WANT_CountProjectMarkers
 #define REAPERAPI_WANT_EnumProjectMarkers
 #define REAPERAPI_WANT_EnumProjectMarkers2
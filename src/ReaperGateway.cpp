@@ -337,6 +337,107 @@ bool ReaperGateway::InsertMarker(ProjectReference projectReference, const Chapte
                Globals::DEFAULT_CHAPTER_MARKER_COLOR) != -1;
 }
 
+// Markers closer than a millisecond can't be told apart in the chapter formats and are treated as equal.
+static const double MARKER_POSITION_TOLERANCE = 0.001;
+
+static bool IsSameMarker(const ChapterTag& lhs, const ChapterTag& rhs)
+{
+    return (std::abs(lhs.Position() - rhs.Position()) < MARKER_POSITION_TOLERANCE) && (lhs.Title() == rhs.Title());
+}
+
+// ReaperProject::ChapterMarkers() reads the chapter images and urls back by parsing these keys with strtod().
+static UnicodeString MarkerPositionKey(const double position)
+{
+    std::stringstream buffer;
+    buffer << std::fixed << std::setprecision(3) << position;
+    return buffer.str();
+}
+
+size_t ReaperGateway::InsertMarkers(
+    ProjectReference projectReference, const ChapterTagArray& markers, ChapterTagArray& failedMarkers)
+{
+    PRECONDITION_RETURN(projectReference != nullptr, 0);
+
+    const auto lessByPosition = [](const ChapterTag& lhs, const ChapterTag& rhs) {
+        return lhs.Position() < rhs.Position();
+    };
+
+    ChapterTagArray existingMarkers = Markers(projectReference);
+    std::sort(existingMarkers.begin(), existingMarkers.end(), lessByPosition);
+
+    ChapterTagArray sortedMarkers = markers;
+    std::stable_sort(sortedMarkers.begin(), sortedMarkers.end(), lessByPosition);
+
+    ChapterTagArray pendingMarkers;
+    pendingMarkers.reserve(sortedMarkers.size());
+    for(size_t i = 0; i < sortedMarkers.size(); i++)
+    {
+        const ChapterTag& current = sortedMarkers[i];
+
+        bool             isDuplicate = false;
+        const ChapterTag lowerBound(current.Position() - MARKER_POSITION_TOLERANCE, UnicodeString());
+        auto             existingMarker =
+            std::lower_bound(existingMarkers.begin(), existingMarkers.end(), lowerBound, lessByPosition);
+        while((isDuplicate == false) && (existingMarker != existingMarkers.end())
+              && (existingMarker->Position() < (current.Position() + MARKER_POSITION_TOLERANCE)))
+        {
+            isDuplicate = IsSameMarker(*existingMarker, current);
+            ++existingMarker;
+        }
+
+        // The pending markers are sorted as well, only the ones at the end can be close enough.
+        for(size_t j = pendingMarkers.size(); (isDuplicate == false) && (j > 0); j--)
+        {
+            const ChapterTag& pendingMarker = pendingMarkers[j - 1];
+            if((current.Position() - pendingMarker.Position()) >= MARKER_POSITION_TOLERANCE)
+            {
+                break;
+            }
+
+            isDuplicate = IsSameMarker(pendingMarker, current);
+        }
+
+        if(isDuplicate == false)
+        {
+            pendingMarkers.push_back(current);
+        }
+    }
+
+    PRECONDITION_RETURN(pendingMarkers.empty() == false, 0);
+
+    size_t      addedMarkers    = 0;
+    ReaProject* nativeReference = reinterpret_cast<ReaProject*>(projectReference);
+    reaper_api::PreventUIRefresh(1);
+    reaper_api::Undo_BeginBlock2(nativeReference);
+    for(size_t i = 0; i < pendingMarkers.size(); i++)
+    {
+        const ChapterTag& current = pendingMarkers[i];
+        if(InsertMarker(projectReference, current.Title(), current.Position()) == true)
+        {
+            const UnicodeString key = MarkerPositionKey(current.Position());
+            if(current.Image().empty() == false)
+            {
+                SetProjectValue(projectReference, "chapterimages", key, current.Image());
+            }
+
+            if(current.Url().empty() == false)
+            {
+                SetProjectValue(projectReference, "chapterurls", key, current.Url());
+            }
+
+            addedMarkers++;
+        }
+        else
+        {
+            failedMarkers.push_back(current);
+        }
+    }
+    reaper_api::Undo_EndBlock2(nativeReference, "Insert chapter markers", UNDO_STATE_MISCCFG);
+    reaper_api::PreventUIRefresh(-1);
+
+    return addedMarkers;
+}
+
 bool ReaperGateway::UndoMarker(ProjectReference projectReference, const double position)
 {
     PRECONDITION_RETURN(projectReference != nullptr, false);
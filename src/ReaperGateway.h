@@ -62,6 +62,8 @@ class ReaperGateway
 
     static bool InsertMarker(ProjectReference projectReference, const UnicodeString& name, const double position);
     static bool InsertMarker(ProjectReference projectReference, const ChapterTag& marker);
+    static size_t InsertMarkers(
+        ProjectReference projectReference, const ChapterTagArray& markers, ChapterTagArray& failedMarkers);
     static bool UndoMarker(ProjectReference projectReference, const double position);
 
     static int    PlayState(ProjectReference projectReference);
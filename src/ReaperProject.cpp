@@ -209,6 +209,34 @@ bool ReaperProject::InsertChapterMarker(const UnicodeString& name, const double
     return ReaperGateway::InsertMarker(nativeReference_, name, actualPosition);
 }
 
+size_t ReaperProject::InsertChapterMarkers(const ChapterTagArray& chapterMarkers, ChapterTagArray& failedChapterMarkers)
+{
+    PRECONDITION_RETURN(nativeReference_ != 0, 0);
+
+    double          currentPosition = Globals::INVALID_MARKER_POSITION;
+    ChapterTagArray pendingChapterMarkers;
+    pendingChapterMarkers.reserve(chapterMarkers.size());
+    for(size_t i = 0; i < chapterMarkers.size(); i++) {
+        const ChapterTag& current = chapterMarkers[i];
+        if(current.Title().empty() == true) {
+            failedChapterMarkers.push_back(current);
+        }
+        else if(current.Position() == Globals::INVALID_MARKER_POSITION) {
+            if(currentPosition == Globals::INVALID_MARKER_POSITION) {
+                currentPosition = CurrentPosition();
+            }
+
+            pendingChapterMarkers.push_back(
+                ChapterTag(currentPosition, current.Title(), current.Image(), current.Url()));
+        }
+        else {
+            pendingChapterMarkers.push_back(current);
+        }
+    }
+
+    return ReaperGateway::InsertMarkers(nativeReference_, pendingChapterMarkers, failedChapterMarkers);
+}
+
 double ReaperProject::CurrentPosition() const
 {
     PRECONDITION_RETURN(nativeReference_ != 0, Globals::INVALID_MARKER_POSITION);
@@ -246,6 +274,59 @@ bool ReaperProject::IsValidPosition(const double position)
     return (position >= 0) && (position <= MaxPosition());
 }
 
+typedef std::vector<std::pair<double, UnicodeString>> PositionIndex;
+
+// Parses the positions of the chapter images or urls stored in the project state and sorts them, so that the sorted
+// chapters can be matched in a single pass.
+static PositionIndex QueryPositionIndex(ProjectReference projectReference, const UnicodeString& section)
+{
+    const UnicodeStringDictionary items = ReaperGateway::QueryProjectValues(projectReference, section);
+
+    PositionIndex index;
+    index.reserve(items.size());
+    std::for_each(items.begin(), items.end(), [&](const std::pair<UnicodeString, UnicodeString>& item) {
+        const char*  first    = item.first.c_str();
+        char*        last     = nullptr;
+        const double position = std::strtod(first, &last);
+        if((last != first) && (std::isfinite(position) == true)) {
+            index.push_back(std::make_pair(position, item.second));
+        }
+    });
+
+    // Entries with equal positions keep the order of their keys.
+    std::stable_sort(index.begin(), index.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    return index;
+}
+
+// The positions must be queried in ascending order, firstCandidate carries the start of the search window from one
+// query to the next.
+static UnicodeString LookupValueInRange(
+    const PositionIndex& index, size_t& firstCandidate, const double position, const double range)
+{
+    PRECONDITION_RETURN(index.empty() == false, UnicodeString());
+    PRECONDITION_RETURN(position >= 0, UnicodeString());
+    PRECONDITION_RETURN(range >= 0, UnicodeString());
+
+    while((firstCandidate < index.size()) && (index[firstCandidate].first < (position - range))) {
+        firstCandidate++;
+    }
+
+    size_t bestCandidate = index.size();
+    double minDelta      = std::numeric_limits<double>::max();
+    for(size_t i = firstCandidate; (i < index.size()) && (index[i].first <= (position + range)); i++) {
+        const double delta = std::fabs(position - index[i].first);
+        if((delta <= range) && (delta < minDelta)) {
+            bestCandidate = i;
+            minDelta      = delta;
+        }
+    }
+
+    return (bestCandidate < index.size()) ? index[bestCandidate].second : UnicodeString();
+}
+
 ChapterTagArray ReaperProject::ChapterMarkers() const
 {
     PRECONDITION_RETURN(nativeReference_ != 0, ChapterTagArray());
@@ -254,41 +335,20 @@ ChapterTagArray ReaperProject::ChapterMarkers() const
 
     ChapterTagArray chapters = ReaperGateway::Markers(nativeReference_);
     if(chapters.empty() == false) {
-        UnicodeStringDictionary images = ReaperGateway::QueryProjectValues(nativeReference_, "chapterimages");
-        UnicodeStringDictionary urls   = ReaperGateway::QueryProjectValues(nativeReference_, "chapterurls");
+        std::stable_sort(chapters.begin(), chapters.end(), [](const ChapterTag& lhs, const ChapterTag& rhs) {
+            return lhs.Position() < rhs.Position();
+        });
+
+        const PositionIndex images     = QueryPositionIndex(nativeReference_, "chapterimages");
+        const PositionIndex urls       = QueryPositionIndex(nativeReference_, "chapterurls");
+        size_t              firstImage = 0;
+        size_t              firstUrl   = 0;
         std::for_each(chapters.begin(), chapters.end(), [&](ChapterTag& chapter) {
-            chapter.SetImage(LookupValueInRange(images, chapter.Position(), POSITION_DEAD_BAND));
-            chapter.SetUrl(LookupValueInRange(urls, chapter.Position(), POSITION_DEAD_BAND));
+            chapter.SetImage(LookupValueInRange(images, firstImage, chapter.Position(), POSITION_DEAD_BAND));
+            chapter.SetUrl(LookupValueInRange(urls, firstUrl, chapter.Position(), POSITION_DEAD_BAND));
         });
     }
     return chapters;
 }
 
-UnicodeString ReaperProject::LookupValueInRange(
-    const UnicodeStringDictionary& items, const double position, const double range)
-{
-    PRECONDITION_RETURN(items.empty() == false, UnicodeString());
-    PRECONDITION_RETURN(position >= 0, UnicodeString());
-    PRECONDITION_RETURN(range >= 0, UnicodeString());
-
-    UnicodeString result;
-
-    double minDelta = std::numeric_limits<double>::max();
-    std::for_each(items.begin(), items.end(), [&](const std::pair<UnicodeString, UnicodeString>& item) {
-        try {
-            const double itemPosition = std::stod(item.first);
-            const double delta        = std::fabs(position - itemPosition);
-            if((delta <= range) && (delta < minDelta)) {
-                result   = item.second;
-                minDelta = delta;
-            }
-        }
-        catch(std::invalid_argument&) {
-        }
-        catch(std::out_of_range&) {
-        }
-    });
-    return result;
-}
-
 }} // namespace ultraschall::reaper
@@ -59,6 +59,7 @@ class ReaperProject
     bool   IsValidPosition(const double position);
 
     bool InsertChapterMarker(const UnicodeString& name, const double position = Globals::INVALID_MARKER_POSITION);
+    size_t InsertChapterMarkers(const ChapterTagArray& chapterMarkers, ChapterTagArray& failedChapterMarkers);
 
     ChapterTagArray ChapterMarkers() const;
 
@@ -72,9 +73,6 @@ class ReaperProject
     ChapterImageDictionary ChapterImages() const;
     ChapterUrlDictionary   ChapterUrls() const;
 
-    static UnicodeString LookupValueInRange(
-        const UnicodeStringDictionary& items, const double position, const double range);
-
     static UnicodeString CreateProjectMetaDataKey(const UnicodeString& prefix, const UnicodeString& name);
 };
 
@@ -25,8 +25,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "SaveChapterMarkersAction.h"
+#include "ChapterExporter.h"
 #include "CustomActionFactory.h"
-#include "StringUtilities.h"
 #include "FileManager.h"
 #include "PlatformGateway.h"
 #include "NotificationStore.h"
@@ -35,6 +35,31 @@ namespace ultraschall { namespace reaper {
 
 static DeclareCustomAction<SaveChapterMarkersAction> action;
 
+static ChapterExporter::FORMAT QueryExportFormat(const UnicodeString& targetName)
+{
+    ChapterExporter::FORMAT format = ChapterExporter::MP4CHAPS;
+
+    switch(FileManager::QueryFileType(targetName))
+    {
+        case FileManager::FILE_TYPE::PSC:
+            format = ChapterExporter::PSC;
+            break;
+        case FileManager::FILE_TYPE::JSON:
+            format = ChapterExporter::JSON;
+            break;
+        case FileManager::FILE_TYPE::WEBVTT:
+            format = ChapterExporter::WEBVTT;
+            break;
+        case FileManager::FILE_TYPE::CUE:
+            format = ChapterExporter::CUE;
+            break;
+        default:
+            break;
+    }
+
+    return format;
+}
+
 ServiceStatus SaveChapterMarkersAction::Execute()
 {
     PRECONDITION_RETURN(HasValidProject() == true, SERVICE_FAILURE);
@@ -44,15 +69,8 @@ ServiceStatus SaveChapterMarkersAction::Execute()
     ServiceStatus     status = SERVICE_FAILURE;
     NotificationStore supervisor(UniqueId());
 
-    std::ostringstream os;
-    for(size_t i = 0; i < chapterMarkers_.size(); i++)
-    {
-        const UnicodeString timestamp = SecondsToString(chapterMarkers_[i].Position());
-        const UnicodeString item      = timestamp + " " + chapterMarkers_[i].Title();
-        os << item << std::endl;
-    }
-
-    if(FileManager::WriteTextFile(target_, os.str()) == true)
+    const double endPosition = CurrentProject().MaxPosition();
+    if(ChapterExporter::ExportFile(chapterMarkers_, endPosition, target_, QueryExportFormat(target_)) == true)
     {
         status = SERVICE_SUCCESS;
     }
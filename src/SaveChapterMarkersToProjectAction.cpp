@@ -25,10 +25,10 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "SaveChapterMarkersToProjectAction.h"
+#include "ChapterExporter.h"
 #include "CustomActionFactory.h"
 #include "FileManager.h"
 #include "SaveChapterMarkersAction.h"
-#include "StringUtilities.h"
 #include "NotificationStore.h"
 
 namespace ultraschall { namespace reaper {
@@ -41,17 +41,11 @@ ServiceStatus SaveChapterMarkersToProjectAction::Execute()
     PRECONDITION_RETURN(ConfigureSources() == true, SERVICE_FAILURE);
     PRECONDITION_RETURN(ConfigureTargets() == true, SERVICE_FAILURE);
 
-    ServiceStatus      status = SERVICE_FAILURE;
-    NotificationStore  supervisor(UniqueId());
-    std::ostringstream os;
-    for(size_t i = 0; i < chapterMarkers_.size(); i++)
-    {
-        const UnicodeString timestamp = SecondsToString(chapterMarkers_[i].Position());
-        const UnicodeString item      = timestamp + " " + chapterMarkers_[i].Title();
-        os << item << std::endl;
-    }
+    ServiceStatus     status = SERVICE_FAILURE;
+    NotificationStore supervisor(UniqueId());
 
-    if(FileManager::WriteTextFile(target_, os.str()) == true)
+    const double endPosition = CurrentProject().MaxPosition();
+    if(ChapterExporter::Export(chapterMarkers_, endPosition, target_, ChapterExporter::ALL_FORMATS) == true)
     {
         status = SERVICE_SUCCESS;
     }
@@ -65,7 +59,7 @@ ServiceStatus SaveChapterMarkersToProjectAction::Execute()
 
 bool SaveChapterMarkersToProjectAction::ConfigureTargets()
 {
-    target_ = CurrentProjectDirectory() + FileManager::PathSeparator() + CurrentProjectName() + ".chapters.txt";
+    target_ = CurrentProjectDirectory() + FileManager::PathSeparator() + CurrentProjectName();
     return true;
 }
 
@@ -53,6 +53,7 @@ class SaveChapterMarkersToProjectAction : public CustomAction
     virtual ServiceStatus Execute() override;
 
 private:
+    // The base name of the exported files, every chapter format appends its own extension.
     UnicodeString target_;
     ChapterTagArray   chapterMarkers_;
 
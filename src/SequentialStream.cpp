@@ -29,74 +29,124 @@
 
 namespace ultraschall { namespace reaper {
 
-SequentialStream::SequentialStream() : dataSize_(DEFAULT_CHUNK_SIZE), data_(new uint8_t[DEFAULT_CHUNK_SIZE]) {}
+SequentialStream::SequentialStream() {}
 
 SequentialStream::~SequentialStream()
 {
-    writePosition_ = 0;
-    readPosition_  = 0;
-    dataSize_      = INVALID_DATA_SIZE;
-    SafeDeleteArray(data_);
+    std::for_each(buffers_.begin(), buffers_.end(), [](Buffer& buffer) { SafeDeleteArray(buffer.data); });
+    buffers_.clear();
+
+    dataSize_     = INVALID_DATA_SIZE;
+    readPosition_ = 0;
+}
+
+size_t SequentialStream::NextSegmentSize(const size_t previousSize, const size_t requiredSize)
+{
+    size_t segmentSize = std::min(std::max(previousSize * 2, MIN_SEGMENT_SIZE), MAX_SEGMENT_SIZE);
+    while(segmentSize < requiredSize) {
+        segmentSize *= 2;
+    }
+
+    return segmentSize;
 }
 
 size_t SequentialStream::DataSize() const
 {
-    // return dataSize_;
-    return writePosition_;
+    return dataSize_;
 }
 
 const uint8_t* SequentialStream::Data() const
 {
-    return data_;
+    PRECONDITION_RETURN(buffers_.empty() == false, nullptr);
+
+    if(buffers_.size() > 1) {
+        Buffer buffer;
+        buffer.capacity = dataSize_;
+        buffer.data     = new uint8_t[buffer.capacity];
+        std::for_each(buffers_.begin(), buffers_.end(), [&](Buffer& segment) {
+            memcpy(&buffer.data[buffer.dataSize], segment.data, segment.dataSize);
+            buffer.dataSize += segment.dataSize;
+            SafeDeleteArray(segment.data);
+        });
+
+        buffers_.assign(1, buffer);
+    }
+
+    return buffers_[0].data;
+}
+
+SequentialStream::SegmentArray SequentialStream::Segments() const
+{
+    SegmentArray segments;
+    segments.reserve(buffers_.size());
+    std::for_each(buffers_.begin(), buffers_.end(), [&](const Buffer& buffer) {
+        if(buffer.dataSize > 0) {
+            segments.push_back(Segment(buffer.data, buffer.dataSize));
+        }
+    });
+
+    return segments;
 }
 
 bool SequentialStream::Write(const uint8_t* buffer, const size_t bufferSize)
 {
-    PRECONDITION_RETURN(data_ != nullptr, false);
+    PRECONDITION_RETURN(dataSize_ != INVALID_DATA_SIZE, false);
     PRECONDITION_RETURN(buffer != nullptr, false);
     PRECONDITION_RETURN(bufferSize > 0, false);
-    PRECONDITION_RETURN(bufferSize <= DEFAULT_CHUNK_SIZE, false);
-
-    bool spaceAvailable = true;
 
-    if((writePosition_ + bufferSize) > dataSize_) {
-        uint8_t* pData = data_;
-        data_          = new uint8_t[dataSize_ + DEFAULT_CHUNK_SIZE]();
-        if(data_ != nullptr) {
-            memmove(data_, pData, dataSize_);
-            dataSize_ += DEFAULT_CHUNK_SIZE;
+    size_t offset = 0;
+    while(offset < bufferSize) {
+        if((buffers_.empty() == true) || (buffers_.back().dataSize == buffers_.back().capacity)) {
+            const size_t previousSize = (buffers_.empty() == false) ? buffers_.back().capacity : 0;
 
-            SafeDeleteArray(pData);
+            Buffer segment;
+            segment.capacity = NextSegmentSize(previousSize, bufferSize - offset);
+            segment.data     = new uint8_t[segment.capacity];
+            buffers_.push_back(segment);
         }
-        else {
-            spaceAvailable = false;
-        }
-    }
 
-    if(true == spaceAvailable) {
-        const size_t itemSize = sizeof(uint8_t);
-        memmove(&data_[writePosition_], buffer, bufferSize * itemSize);
-        writePosition_ += bufferSize;
+        Buffer&      segment   = buffers_.back();
+        const size_t chunkSize = std::min(bufferSize - offset, segment.capacity - segment.dataSize);
+        memcpy(&segment.data[segment.dataSize], &buffer[offset], chunkSize);
+        segment.dataSize += chunkSize;
+        offset += chunkSize;
     }
 
-    return spaceAvailable;
+    dataSize_ += bufferSize;
+    return true;
 }
 
 size_t SequentialStream::Read(uint8_t* buffer, const size_t bufferSize)
 {
-    PRECONDITION_RETURN(data_ != nullptr, 0);
     PRECONDITION_RETURN(buffer != nullptr, 0);
     PRECONDITION_RETURN(bufferSize > 0, 0);
-    PRECONDITION_RETURN(readPosition_ < (writePosition_ - bufferSize), 0);
+    PRECONDITION_RETURN(readPosition_ < dataSize_, 0);
 
     size_t result = 0;
 
-    const size_t chunkSize = ((readPosition_ + bufferSize) < dataSize_) ? bufferSize : (dataSize_ - readPosition_);
-    if(chunkSize > 0) {
-        memmove(buffer, &data_[readPosition_], chunkSize);
-        readPosition_ += chunkSize;
+    // Flattening the stream in between reads moves the read position to the single remaining buffer
+    if(readBuffer_ >= buffers_.size()) {
+        readBuffer_ = 0;
+        readOffset_ = readPosition_;
+    }
+
+    while((result < bufferSize) && (readBuffer_ < buffers_.size())) {
+        const Buffer& segment   = buffers_[readBuffer_];
+        const size_t  chunkSize = std::min(bufferSize - result, segment.dataSize - readOffset_);
+        memcpy(&buffer[result], &segment.data[readOffset_], chunkSize);
+        result += chunkSize;
+        readOffset_ += chunkSize;
+
+        if((readOffset_ == segment.dataSize) && ((readBuffer_ + 1) < buffers_.size())) {
+            readBuffer_++;
+            readOffset_ = 0;
+        }
+        else if(chunkSize == 0) {
+            break;
+        }
     }
 
+    readPosition_ += result;
     return result;
 }
 
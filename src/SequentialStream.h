@@ -32,30 +32,59 @@
 
 namespace ultraschall { namespace reaper {
 
+// Append-only byte stream that grows in segments of increasing power-of-two sizes. Written
+// data is never moved, consumers either walk the segments or request a flattened copy once.
 class SequentialStream : public SharedObject
 {
 public:
     static const size_t INVALID_DATA_SIZE = -1;
 
+    struct Segment
+    {
+        const uint8_t* data     = nullptr;
+        size_t         dataSize = 0;
+
+        Segment(const uint8_t* segmentData, const size_t segmentSize) : data(segmentData), dataSize(segmentSize) {}
+    };
+
+    typedef std::vector<Segment> SegmentArray;
+
     SequentialStream();
 
     size_t DataSize() const;
 
+    // Flattens the segments into a single buffer, this happens only once for a stream that is
+    // no longer written to.
     const uint8_t* Data() const;
 
-    bool Write(const uint8_t* buffer, const size_t bufferSize);
+    // Gather view of the written data, it remains valid until the next call to Write or Data
+    SegmentArray Segments() const;
+
+    bool   Write(const uint8_t* buffer, const size_t bufferSize);
     size_t Read(uint8_t* buffer, const size_t bufferSize);
 
 protected:
     virtual ~SequentialStream();
 
 private:
-    static const size_t DEFAULT_CHUNK_SIZE = 4096;
+    static const size_t MIN_SEGMENT_SIZE = 4096;
+    static const size_t MAX_SEGMENT_SIZE = 1024 * 1024;
+
+    struct Buffer
+    {
+        uint8_t* data     = nullptr;
+        size_t   capacity = 0;
+        size_t   dataSize = 0;
+    };
+
+    mutable std::vector<Buffer> buffers_;
+
+    size_t dataSize_     = 0;
+    size_t readPosition_ = 0;
+    size_t readBuffer_   = 0;
+    size_t readOffset_   = 0;
 
-    size_t   writePosition_ = 0;
-    size_t   readPosition_  = 0;
-    size_t   dataSize_      = INVALID_DATA_SIZE;
-    uint8_t* data_          = nullptr;
+    static size_t NextSegmentSize(const size_t previousSize, const size_t requiredSize);
 };
 
 }} // namespace ultraschall::reaper
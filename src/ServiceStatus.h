@@ -42,6 +42,11 @@ typedef uint32_t ServiceStatus;
 #define SERVICE_INVALID_ARGUMENT SERVICE_STATUS_CODE(SERVICE_FRAMEWORK_FACILITY, 0x00000003)
 #define SERVICE_NOT_IMPLEMENTED SERVICE_STATUS_CODE(SERVICE_FRAMEWORK_FACILITY, 0x00000004)
 
+// File status codes
+#define SERVICE_FILE_FACILITY 0x04000000
+#define SERVICE_FILE_NOT_FOUND SERVICE_STATUS_CODE(SERVICE_FILE_FACILITY, 0x00000002)
+#define SERVICE_FILE_READ_FAILED SERVICE_STATUS_CODE(SERVICE_FILE_FACILITY, 0x00000003)
+
 // Service manager status codes
 #define SERVICE_MANAGER_FACILITY 0x80000000
 #define SERVICE_MANAGER_ALREADY_REGISTERED SERVICE_STATUS_CODE(SERVICE_MANAGER_FACILITY, 0x00000002)
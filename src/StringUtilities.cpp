@@ -26,6 +26,7 @@
 
 #include "Common.h"
 #include "StringUtilities.h"
+#include <charconv>
 #include <codecvt>
 
 namespace ultraschall { namespace reaper {
@@ -130,215 +131,180 @@ UnicodeString StringUppercase(const UnicodeString& str)
     return convertedString;
 }
 
-struct ULTRASCHALL_TIMESTAMP
+static const char DIGIT_PAIRS[] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+static char* AppendDigitPair(char* pBuffer, const uint64_t value)
 {
-    uint16_t milliseconds;
-    uint8_t  seconds;
-    uint8_t  minutes;
-    uint8_t  hours;
-
-    ULTRASCHALL_TIMESTAMP() : milliseconds(0xffff), seconds(0xff), minutes(0xff), hours(0xff) {}
-};
-
-static bool ValidateTimestamp(const ULTRASCHALL_TIMESTAMP& timestamp)
-{
-    return (timestamp.milliseconds != 0xffff) && (timestamp.seconds != 0xff) && (timestamp.minutes != 0xff)
-           && (timestamp.hours != 0xff);
+    memcpy(pBuffer, &DIGIT_PAIRS[value * 2], 2);
+    return pBuffer + 2;
 }
 
-static uint32_t TimestampToMilliseconds(const ULTRASCHALL_TIMESTAMP& ts)
+size_t MillisecondsToTimestamp(
+    const uint64_t milliseconds, char* buffer, const size_t bufferSize, const bool roundSeconds)
 {
-    uint32_t ms = ts.hours * 1000 * 60 * 60;
-    ms += ts.minutes * 1000 * 60;
-    ms += ts.seconds * 1000;
-    ms += ts.milliseconds;
-
-    return ms;
-}
+    PRECONDITION_RETURN(buffer != nullptr, 0);
 
-static double TimestampToSeconds(const ULTRASCHALL_TIMESTAMP& ts)
-{
-    const uint32_t ms = TimestampToMilliseconds(ts);
-    return ((double)ms / (double)1000);
-}
-
-static ULTRASCHALL_TIMESTAMP MillisecondsToTimestamp(const uint32_t milliseconds)
-{
-    ULTRASCHALL_TIMESTAMP ts;
+    const uint64_t totalMilliseconds = (roundSeconds == true) ? ((milliseconds + 500) / 1000) * 1000 : milliseconds;
+    const uint64_t hours             = totalMilliseconds / (1000 * 60 * 60);
+    const uint64_t minutes           = (totalMilliseconds / (1000 * 60)) % 60;
+    const uint64_t seconds           = (totalMilliseconds / 1000) % 60;
+    const uint64_t fraction          = totalMilliseconds % 1000;
 
-    PRECONDITION_RETURN((milliseconds / (1000 * 60 * 60)) <= UINT8_MAX, ULTRASCHALL_TIMESTAMP());
-    ts.hours               = static_cast<uint8_t>(milliseconds / (1000 * 60 * 60));
-    const uint32_t minutes = milliseconds % (1000 * 60 * 60);
+    char   hourDigits[24] = {0};
+    size_t hourSize       = 2;
+    if(hours < 100)
+    {
+        AppendDigitPair(hourDigits, hours);
+    }
+    else
+    {
+        hourSize = std::to_chars(hourDigits, hourDigits + sizeof(hourDigits), hours).ptr - hourDigits;
+    }
 
-    PRECONDITION_RETURN((minutes / (1000 * 60)) <= UINT8_MAX, ULTRASCHALL_TIMESTAMP());
-    ts.minutes             = static_cast<uint8_t>(minutes / (1000 * 60));
-    const uint32_t seconds = minutes % (1000 * 60);
+    const size_t timestampSize = hourSize + ((roundSeconds == true) ? 6 : 10);
+    PRECONDITION_RETURN(timestampSize < bufferSize, 0);
 
-    PRECONDITION_RETURN((seconds / 1000) <= UINT8_MAX, ULTRASCHALL_TIMESTAMP());
-    ts.seconds        = static_cast<uint8_t>(seconds / 1000);
-    const uint32_t ms = seconds % 1000;
+    char* pBuffer = buffer;
+    memcpy(pBuffer, hourDigits, hourSize);
+    pBuffer += hourSize;
+    *pBuffer++ = ':';
+    pBuffer    = AppendDigitPair(pBuffer, minutes);
+    *pBuffer++ = ':';
+    pBuffer    = AppendDigitPair(pBuffer, seconds);
+    if(roundSeconds == false)
+    {
+        *pBuffer++ = '.';
+        *pBuffer++ = DIGIT_PAIRS[(fraction / 100) * 2 + 1];
+        pBuffer    = AppendDigitPair(pBuffer, fraction % 100);
+    }
 
-    PRECONDITION_RETURN(ms <= UINT16_MAX, ULTRASCHALL_TIMESTAMP());
-    ts.milliseconds = static_cast<uint16_t>(ms);
+    *pBuffer = 0;
 
-    return ts;
+    return timestampSize;
 }
 
-static ULTRASCHALL_TIMESTAMP SecondsToTimestamp(const double seconds)
+size_t SecondsToTimestamp(const double seconds, char* buffer, const size_t bufferSize, const bool roundSeconds)
 {
-    const uint32_t milliseconds = (uint32_t)(seconds * (double)1000);
-    return MillisecondsToTimestamp(milliseconds);
+    PRECONDITION_RETURN(seconds >= 0, 0);
+
+    return MillisecondsToTimestamp((uint64_t)(seconds * (double)1000), buffer, bufferSize, roundSeconds);
 }
 
-UnicodeString TimestampToString(const ULTRASCHALL_TIMESTAMP& timestamp, const bool roundSeconds)
+void SecondsToTimestamps(const double* seconds, const size_t count, TimestampText* timestamps, const bool roundSeconds)
 {
-    ULTRASCHALL_TIMESTAMP ts = timestamp;
+    PRECONDITION(seconds != nullptr);
+    PRECONDITION(timestamps != nullptr);
 
-    if(roundSeconds == true)
+    for(size_t i = 0; i < count; i++)
     {
-        if(ts.milliseconds >= 500)
-        {
-            ts.seconds += 1;
-            ts.milliseconds = 0;
-        }
+        timestamps[i].size = SecondsToTimestamp(seconds[i], timestamps[i].data, MAX_TIMESTAMP_SIZE, roundSeconds);
+    }
+}
 
-        if(ts.seconds >= 60)
+bool TimestampToMilliseconds(const UnicodeStringView& str, uint64_t& milliseconds)
+{
+    static const size_t   MAX_FIELDS                = 3;
+    static const uint64_t UPPER_LIMITS[MAX_FIELDS]  = {59, 59, UINT32_MAX};
+    static const uint64_t FIELD_SECONDS[MAX_FIELDS] = {1, 60, 60 * 60};
+    static const size_t   MAX_FRACTION_DIGITS       = 3;
+    static const uint64_t FRACTION_SCALE[]          = {1000, 100, 10, 1};
+
+    const char* current = str.data();
+    const char* end     = str.data() + str.size();
+
+    uint64_t fields[MAX_FIELDS] = {0};
+    size_t   fieldCount         = 0;
+    bool     valid              = false;
+    for(;;)
+    {
+        const std::from_chars_result result = std::from_chars(current, end, fields[fieldCount++]);
+        valid                               = (result.ec == std::errc());
+        current                             = result.ptr;
+        if((valid == false) || (fieldCount == MAX_FIELDS) || (current == end) || (*current != ':'))
         {
-            ts.minutes += 1;
+            break;
         }
 
-        if(ts.minutes >= 60)
-        {
-            ts.hours += 1;
-        }
+        current++;
     }
 
-    std::ostringstream str;
-    str << std::setw(2) << std::setfill('0') << (int)ts.hours << ':' << std::setw(2) << std::setfill('0')
-        << (int)ts.minutes << ':' << std::setw(2) << std::setfill('0') << (int)ts.seconds;
-    if(roundSeconds == false)
+    uint64_t fraction     = 0;
+    size_t   fractionSize = 0;
+    if((valid == true) && (current != end) && (*current == '.'))
     {
-        str << '.' << std::setw(3) << std::setfill('0') << (int)ts.milliseconds;
+        const char*                  fractionStart = current + 1;
+        const std::from_chars_result result        = std::from_chars(fractionStart, end, fraction);
+        fractionSize                               = result.ptr - fractionStart;
+        valid   = (result.ec == std::errc()) && (fractionSize <= MAX_FRACTION_DIGITS);
+        current = result.ptr;
     }
 
-    return str.str();
-}
-
-UnicodeString MillisecondsToString(const uint32_t milliseconds, const bool roundSeconds)
-{
-    ULTRASCHALL_TIMESTAMP timestamp = MillisecondsToTimestamp(milliseconds);
-    return TimestampToString(timestamp, roundSeconds);
-}
-
-uint16_t StringToUint16(const UnicodeString& str, const int lowerLimit = 0, const int upperLimit = UINT16_MAX)
-{
-    uint16_t result = 0xffff;
+    valid = (valid == true) && (current == end);
 
-    if(str.empty() == false)
+    uint64_t totalSeconds = 0;
+    for(size_t i = 0; (i < fieldCount) && (valid == true); i++)
     {
-        try
-        {
-            const int number = std::stoi(str);
-            if((number >= lowerLimit) && (number <= upperLimit))
-            {
-                result = (uint16_t)number;
-            }
-        }
-        catch(std::invalid_argument&)
-        {
-            result = 0xffff;
-        }
+        const uint64_t value = fields[fieldCount - i - 1];
+        valid                = (value <= UPPER_LIMITS[i]);
+        totalSeconds += value * FIELD_SECONDS[i];
     }
 
-    return result;
-}
-
-uint8_t StringToUint8(const UnicodeString& str, const int lowerLimit = 0, const int upperLimit = UINT8_MAX)
-{
-    uint8_t result = 0xff;
-
-    if(str.empty() == false)
+    if(valid == true)
     {
-        try
-        {
-            const int number = std::stoi(str);
-            if((number >= lowerLimit) && (number <= upperLimit))
-            {
-                result = (uint8_t)number;
-            }
-        }
-        catch(std::invalid_argument&)
-        {
-            result = 0xff;
-        }
+        milliseconds = (totalSeconds * 1000) + (fraction * FRACTION_SCALE[fractionSize]);
     }
 
-    return result;
+    return valid;
 }
 
-ULTRASCHALL_TIMESTAMP StringToTimestamp(const UnicodeString& str)
+bool TimestampToSeconds(const UnicodeStringView& str, double& seconds)
 {
-    ULTRASCHALL_TIMESTAMP timestamp;
-
-    UnicodeStringArray tokens = UnicodeStringTokenize(str, '.');
-    if(tokens.size() > 1)
+    uint64_t   milliseconds = 0;
+    const bool valid        = TimestampToMilliseconds(str, milliseconds);
+    if(valid == true)
     {
-        timestamp.milliseconds = StringToUint16(tokens[1], 0, 999);
+        seconds = (double)milliseconds / (double)1000;
     }
-    else
-    {
-        timestamp.milliseconds = 0;
-    }
-
-    if(timestamp.milliseconds != 0xffff)
-    {
-        timestamp.seconds = 0;
-        timestamp.minutes = 0;
-        timestamp.hours   = 0;
 
-        tokens = UnicodeStringTokenize(tokens[0], ':');
-        if(tokens.size() == 1)
-        {
-            timestamp.seconds = StringToUint8(tokens[0], 0, 59);
-        }
-        else if(tokens.size() == 2)
-        {
-            timestamp.seconds = StringToUint8(tokens[1], 0, 59);
-            timestamp.minutes = StringToUint8(tokens[0], 0, 59);
-        }
-        else if(tokens.size() == 3)
-        {
-            timestamp.seconds = StringToUint8(tokens[2], 0, 59);
-            timestamp.minutes = StringToUint8(tokens[1], 0, 59);
-            timestamp.hours   = StringToUint8(tokens[0], 0, 24);
-        }
-    }
+    return valid;
+}
 
-    return timestamp;
+UnicodeString MillisecondsToString(const uint32_t milliseconds, const bool roundSeconds)
+{
+    char         buffer[MAX_TIMESTAMP_SIZE] = {0};
+    const size_t size = MillisecondsToTimestamp(milliseconds, buffer, sizeof(buffer), roundSeconds);
+    return UnicodeString(buffer, size);
 }
 
 uint32_t StringToMilliseconds(const UnicodeString& str)
 {
-    uint32_t result = 0xffffffff;
-
-    const ULTRASCHALL_TIMESTAMP timestamp = StringToTimestamp(str);
-    if(ValidateTimestamp(timestamp) == true)
+    uint64_t milliseconds = 0;
+    if((TimestampToMilliseconds(str, milliseconds) == false) || (milliseconds >= UINT32_MAX))
     {
-        result = TimestampToMilliseconds(timestamp);
+        milliseconds = 0xffffffff;
     }
 
-    return result;
+    return static_cast<uint32_t>(milliseconds);
 }
 
 UnicodeString SecondsToString(const double seconds, const bool roundSeconds)
 {
     UnicodeString str = "<Out of range>";
 
-    const double offset = (roundSeconds == true) ? 0.5 : 0;
-    if((seconds >= 0) && (seconds < ((60 * 60 * 24) - offset)))
+    char         buffer[MAX_TIMESTAMP_SIZE] = {0};
+    const size_t size                       = SecondsToTimestamp(seconds, buffer, sizeof(buffer), roundSeconds);
+    if(size > 0)
     {
-        ULTRASCHALL_TIMESTAMP timestamp = SecondsToTimestamp(seconds);
-        str                             = TimestampToString(timestamp, roundSeconds);
+        str.assign(buffer, size);
     }
 
     return str;
@@ -346,15 +312,13 @@ UnicodeString SecondsToString(const double seconds, const bool roundSeconds)
 
 double StringToSeconds(const UnicodeString& str)
 {
-    double result = -1;
-
-    const ULTRASCHALL_TIMESTAMP timestamp = StringToTimestamp(str);
-    if(ValidateTimestamp(timestamp) == true)
+    double seconds = -1;
+    if(TimestampToSeconds(str, seconds) == false)
     {
-        result = TimestampToSeconds(timestamp);
+        seconds = -1;
     }
 
-    return result;
+    return seconds;
 }
 
 }} // namespace ultraschall::reaper
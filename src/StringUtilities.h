@@ -52,6 +52,35 @@ UnicodeString UnicodeStringFromInt(const int value);
 UnicodeString StringLowercase(const UnicodeString& str);
 UnicodeString StringUppercase(const UnicodeString& str);
 
+// Large enough for 'HHHH...:MM:SS.mmm' with any number of hours that fits into 64 bits and the terminating zero.
+static const size_t MAX_TIMESTAMP_SIZE = 32;
+
+struct TimestampText
+{
+    char   data[MAX_TIMESTAMP_SIZE];
+    size_t size;
+
+    UnicodeStringView View() const
+    {
+        return UnicodeStringView(data, size);
+    }
+};
+
+// Formats 'HH:MM:SS.mmm' or 'HH:MM:SS' into buffer without allocating. Hours aren't limited and take more than two
+// digits if necessary. Returns the length of the timestamp or 0 if the buffer is too small or the position is negative.
+size_t MillisecondsToTimestamp(
+    const uint64_t milliseconds, char* buffer, const size_t bufferSize, const bool roundSeconds = false);
+size_t SecondsToTimestamp(const double seconds, char* buffer, const size_t bufferSize, const bool roundSeconds = false);
+
+// Formats count positions at once, negative positions result in empty timestamps.
+void SecondsToTimestamps(
+    const double* seconds, const size_t count, TimestampText* timestamps, const bool roundSeconds = false);
+
+// Parses '[[H:]MM:]SS[.mmm]' without copying the input. Hours aren't limited and the fraction is a decimal fraction of
+// a second.
+bool TimestampToMilliseconds(const UnicodeStringView& str, uint64_t& milliseconds);
+bool TimestampToSeconds(const UnicodeStringView& str, double& seconds);
+
 UnicodeString MillisecondsToString(const uint32_t milliseconds, const bool roundSeconds = false);
 uint32_t StringToMilliseconds(const UnicodeString& str);
 UnicodeString SecondsToString(const double seconds, const bool roundSeconds = false);
@@ -25,9 +25,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "TagWriterFactory.h"
+#include "ID3V2Commit.h"
+#include "ID3V2NativeWriter.h"
 #include "ID3V2Writer.h"
 #include "StringUtilities.h"
 #include "FileManager.h"
+#include "SystemProperties.h"
 
 namespace ultraschall { namespace reaper {
 
@@ -40,7 +43,16 @@ ITagWriter* TagWriterFactory::Create(const UnicodeString& targetName)
     const FileManager::FILE_TYPE targetType = FileManager::QueryFileType(targetName);
     if(targetType == FileManager::FILE_TYPE::MP3)
     {
-        tagWriter = new ID3V2Writer();
+        // TagLib keeps the frames of tags the native writer can't copy.
+        if((SystemProperty<bool>::Query("ultraschall_id3v2", "use_taglib_writer") == true)
+           || (ID3V2IsTagCopyable(targetName) == false))
+        {
+            tagWriter = new ID3V2Writer();
+        }
+        else
+        {
+            tagWriter = new ID3V2NativeWriter();
+        }
     }
     else
     {
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "TextFileReader.h"
+#include "FileManager.h"
+
+namespace ultraschall { namespace reaper {
+
+TextFileReader::TextFileReader(const UnicodeString& filename)
+{
+    PRECONDITION(filename.empty() == false);
+
+    pStream_ = FileManager::ReadBinaryFile(filename);
+    if(pStream_ != nullptr)
+    {
+        data_     = reinterpret_cast<const char*>(pStream_->Data());
+        dataSize_ = pStream_->DataSize();
+
+        static const uint8_t UTF8_BOM[] = {0xef, 0xbb, 0xbf};
+        if((dataSize_ >= sizeof(UTF8_BOM)) && (memcmp(data_, UTF8_BOM, sizeof(UTF8_BOM)) == 0))
+        {
+            textOffset_ = sizeof(UTF8_BOM);
+            offset_     = textOffset_;
+        }
+    }
+}
+
+TextFileReader::~TextFileReader()
+{
+    SafeRelease(pStream_);
+}
+
+bool TextFileReader::NextLine(UnicodeStringView& line)
+{
+    PRECONDITION_RETURN(data_ != nullptr, false);
+    PRECONDITION_RETURN(offset_ < dataSize_, false);
+
+    const char*  lineStart = &data_[offset_];
+    const size_t remaining = dataSize_ - offset_;
+    const char*  lineEnd   = reinterpret_cast<const char*>(memchr(lineStart, '\n', remaining));
+
+    size_t lineSize = remaining;
+    if(lineEnd != nullptr)
+    {
+        lineSize = lineEnd - lineStart;
+        offset_ += lineSize + 1;
+    }
+    else
+    {
+        offset_ = dataSize_;
+    }
+
+    if((lineSize > 0) && (lineStart[lineSize - 1] == '\r'))
+    {
+        lineSize--;
+    }
+
+    line = UnicodeStringView(lineStart, lineSize);
+    lineNumber_++;
+
+    return true;
+}
+
+}} // namespace ultraschall::reaper
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) The Ultraschall Project (https://ultraschall.fm)
+//
+// The MIT License (MIT)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __ULTRASCHALL_REAPER_TEXT_FILE_READER_H_INCL__
+#define __ULTRASCHALL_REAPER_TEXT_FILE_READER_H_INCL__
+
+#include "Common.h"
+#include "BinaryStream.h"
+
+namespace ultraschall { namespace reaper {
+
+// Iterates over the lines of a text file without copying them. The lines point into the file contents and stay valid
+// as long as the reader exists. A leading UTF-8 BOM and the line breaks (LF or CRLF) are not part of the lines.
+class TextFileReader
+{
+public:
+    TextFileReader(const UnicodeString& filename);
+    ~TextFileReader();
+
+    inline bool IsValid() const;
+
+    // The complete contents of the file without the UTF-8 BOM.
+    inline UnicodeStringView Text() const;
+
+    bool NextLine(UnicodeStringView& line);
+
+    // The number of the line that has been returned by the last call to NextLine(), starting at 1.
+    inline size_t LineNumber() const;
+
+private:
+    TextFileReader(const TextFileReader&) = delete;
+    TextFileReader& operator=(const TextFileReader&) = delete;
+
+    BinaryStream* pStream_    = nullptr;
+    const char*   data_       = nullptr;
+    size_t        dataSize_   = 0;
+    size_t        textOffset_ = 0;
+    size_t        offset_     = 0;
+    size_t        lineNumber_ = 0;
+};
+
+inline bool TextFileReader::IsValid() const
+{
+    return pStream_ != nullptr;
+}
+
+inline UnicodeStringView TextFileReader::Text() const
+{
+    return UnicodeStringView(data_ + textOffset_, dataSize_ - textOffset_);
+}
+
+inline size_t TextFileReader::LineNumber() const
+{
+    return lineNumber_;
+}
+
+}} // namespace ultraschall::reaper
+
+#endif // #ifndef __ULTRASCHALL_REAPER_TEXT_FILE_READER_H_INCL__
@@ -29,6 +29,7 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 
@@ -37,8 +38,9 @@ namespace ultraschall { namespace reaper {
 typedef char     UnicodeChar;
 typedef char16_t WideUnicodeChar;
 
-typedef std::string    UnicodeString;
-typedef std::u16string WideUnicodeString;
+typedef std::string      UnicodeString;
+typedef std::string_view UnicodeStringView;
+typedef std::u16string   WideUnicodeString;
 
 typedef std::stringstream                                                                       UnicodeStringStream;
 typedef std::basic_stringstream<char16_t, std::char_traits<char16_t>, std::allocator<char16_t>> WideUnicodeStringStream;
@@ -22,7 +22,16 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/vfs.h>
+#include <unistd.h>
 
 #include "Common.h"
 #include "PlatformGateway.h"
@@ -35,7 +44,9 @@ namespace ultraschall { namespace reaper {
 
 UnicodeString PlatformGateway::QueryReaperProfilePath()
 {
-    return "~/.config/REAPER";
+    // The path is used for file I/O, the shell doesn't expand the tilde here.
+    const char* homeDirectory = getenv("HOME");
+    return ((homeDirectory != nullptr) ? H2U(homeDirectory) : UnicodeString("~")) + "/.config/REAPER";
 }
 
 UnicodeChar PlatformGateway::QueryPathSeparator()
@@ -43,19 +54,395 @@ UnicodeChar PlatformGateway::QueryPathSeparator()
     return '/';
 }
 
-size_t PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory)
+ServiceStatus PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory, FileSize& availableSpace)
+{
+    PRECONDITION_RETURN(directory.empty() == false, SERVICE_INVALID_ARGUMENT);
+
+    ServiceStatus status = SERVICE_NOT_FOUND;
+
+    struct statvfs fsi = {};
+    if(statvfs(U2H(directory).c_str(), &fsi) == 0) {
+        availableSpace = static_cast<FileSize>(fsi.f_bavail) * fsi.f_frsize;
+        status         = SERVICE_SUCCESS;
+    }
+
+    return status;
+}
+
+uint64_t PlatformGateway::QueryFileModificationTime(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, -1);
+
+    uint64_t modificationTime = -1;
+
+    struct stat fileStatus = {};
+    if(stat(U2H(filename).c_str(), &fileStatus) == 0) {
+        const uint64_t seconds     = fileStatus.st_mtim.tv_sec;
+        const uint64_t nanoseconds = fileStatus.st_mtim.tv_nsec;
+        modificationTime           = (seconds * 1000000000) + nanoseconds;
+    }
+
+    return modificationTime;
+}
+
+static const size_t MAX_COPY_CHUNK_SIZE = 1024 * 1024;
+
+static size_t CopyChunkSize(const FileSize remaining)
+{
+    return static_cast<size_t>(std::min<FileSize>(remaining, MAX_COPY_CHUNK_SIZE));
+}
+
+static bool CopyFileDataWithReadWrite(int targetFile, int sourceFile, off_t sourceOffset, FileSize remaining)
+{
+    std::vector<uint8_t> buffer(CopyChunkSize(remaining));
+
+    bool success = true;
+    while((remaining > 0) && (true == success)) {
+        const ssize_t bytesRead = pread(sourceFile, buffer.data(), CopyChunkSize(remaining), sourceOffset);
+        if(bytesRead > 0) {
+            ssize_t bytesWritten = 0;
+            while((bytesWritten < bytesRead) && (true == success)) {
+                const ssize_t result = write(targetFile, &buffer[bytesWritten], bytesRead - bytesWritten);
+                if(result > 0) {
+                    bytesWritten += result;
+                }
+                else if((result < 0) && (errno != EINTR)) {
+                    success = false;
+                }
+            }
+
+            sourceOffset += bytesRead;
+            remaining -= bytesRead;
+        }
+        else if((bytesRead == 0) || (errno != EINTR)) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool PlatformGateway::QueryFileIdentity(const UnicodeString& filename, FileIdentity& identity)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+
+    bool success = false;
+
+    struct stat fileStatus = {};
+    if(stat(U2H(filename).c_str(), &fileStatus) == 0) {
+        const uint64_t seconds     = fileStatus.st_mtim.tv_sec;
+        const uint64_t nanoseconds = fileStatus.st_mtim.tv_nsec;
+        identity.fileId            = fileStatus.st_ino;
+        identity.size              = fileStatus.st_size;
+        identity.modificationTime  = (seconds * 1000000000) + nanoseconds;
+        success                    = true;
+    }
+
+    return success;
+}
+
+bool PlatformGateway::AppendFileData(
+    const UnicodeString& targetName, const UnicodeString& sourceName, const FileOffset sourceOffset)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+
+    bool success = false;
+
+    const int sourceFile = open(U2H(sourceName).c_str(), O_RDONLY | O_CLOEXEC);
+    if(sourceFile != -1) {
+        const int targetFile = open(U2H(targetName).c_str(), O_WRONLY | O_CLOEXEC);
+        if(targetFile != -1) {
+            struct stat sourceStatus = {};
+            const off_t targetOffset = lseek(targetFile, 0, SEEK_END);
+            if((fstat(sourceFile, &sourceStatus) == 0) && (targetOffset != -1)
+               && (static_cast<FileOffset>(sourceStatus.st_size) >= sourceOffset)) {
+                loff_t   inputOffset  = sourceOffset;
+                loff_t   outputOffset = targetOffset;
+                FileSize remaining    = sourceStatus.st_size - sourceOffset;
+
+                // Let the kernel copy the data without a round trip through user space. This fails
+                // with EXDEV or ENOSYS on older kernels or unsupported file systems, in which case
+                // sendfile is tried before falling back to plain reads and writes.
+                success = true;
+                while((remaining > 0) && (true == success)) {
+                    const ssize_t result = copy_file_range(
+                        sourceFile, &inputOffset, targetFile, &outputOffset, CopyChunkSize(remaining), 0);
+                    if(result > 0) {
+                        remaining -= result;
+                    }
+                    else if((result == 0) || (errno != EINTR)) {
+                        success = false;
+                    }
+                }
+
+                if((false == success) && (lseek(targetFile, outputOffset, SEEK_SET) != -1)) {
+                    success = true;
+                    while((remaining > 0) && (true == success)) {
+                        const ssize_t result
+                            = sendfile(targetFile, sourceFile, &inputOffset, CopyChunkSize(remaining));
+                        if(result > 0) {
+                            remaining -= result;
+                        }
+                        else if((result == 0) || (errno != EINTR)) {
+                            success = false;
+                        }
+                    }
+
+                    if((false == success) && (lseek(targetFile, 0, SEEK_END) != -1)) {
+                        success = CopyFileDataWithReadWrite(targetFile, sourceFile, inputOffset, remaining);
+                    }
+                }
+
+                success = success && (fsync(targetFile) == 0);
+            }
+
+            close(targetFile);
+        }
+
+        close(sourceFile);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::RenameFile(const UnicodeString& sourceName, const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool success = false;
+
+    const std::string source = U2H(sourceName);
+    const std::string target = U2H(targetName);
+
+    // Keep the permissions of the file that is replaced.
+    struct stat targetStatus = {};
+    if(stat(target.c_str(), &targetStatus) == 0) {
+        chmod(source.c_str(), targetStatus.st_mode & 07777);
+    }
+
+    if(rename(source.c_str(), target.c_str()) == 0) {
+        success = true;
+
+        // The rename is durable once the directory entry has been written.
+        std::vector<char> directoryName(target.begin(), target.end());
+        directoryName.push_back(0);
+        const int directory = open(dirname(directoryName.data()), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(directory != -1) {
+            fsync(directory);
+            close(directory);
+        }
+    }
+
+    return success;
+}
+
+bool PlatformGateway::ReplaceFileTail(
+    const UnicodeString& filename, const FileSize expectedSize, const FileOffset offset,
+    const FileSegmentArray& segments)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(offset <= expectedSize, false);
+
+    bool success = false;
+
+    const int file = open(U2H(filename).c_str(), O_RDWR | O_CLOEXEC);
+    if(file != -1) {
+        struct stat fileStatus = {};
+        if((fstat(file, &fileStatus) == 0) && (static_cast<FileSize>(fileStatus.st_size) == expectedSize)) {
+            FileOffset position = offset;
+            success             = true;
+            for(size_t i = 0; (i < segments.size()) && (true == success); i++) {
+                const FileSegment& segment      = segments[i];
+                size_t             bytesWritten = 0;
+                while((bytesWritten < segment.dataSize) && (true == success)) {
+                    const ssize_t result = pwrite(
+                        file, &segment.data[bytesWritten], segment.dataSize - bytesWritten, position + bytesWritten);
+                    if(result > 0) {
+                        bytesWritten += result;
+                    }
+                    else if((result == 0) || (errno != EINTR)) {
+                        success = false;
+                    }
+                }
+
+                position += bytesWritten;
+            }
+
+            const FileSize fileSize = position;
+            if((true == success) && (fileSize < expectedSize)) {
+                success = (ftruncate(file, static_cast<off_t>(fileSize)) == 0);
+            }
+
+            success = success && (fsync(file) == 0);
+        }
+
+        close(file);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::SyncFile(const UnicodeString& filename, const FILE_SYNC_POLICY policy)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(policy != FILE_SYNC_POLICY::NONE, true);
+
+    bool success = false;
+
+    const int file = open(U2H(filename).c_str(), O_WRONLY | O_CLOEXEC);
+    if(file != -1) {
+        success = ((policy == FILE_SYNC_POLICY::DATA) ? fdatasync(file) : fsync(file)) == 0;
+        close(file);
+    }
+
+    return success;
+}
+
+const uint8_t* PlatformGateway::MapFile(const UnicodeString& filename, size_t& fileSize)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    const uint8_t* data = nullptr;
+    fileSize            = 0;
+
+    const int file = open(U2H(filename).c_str(), O_RDONLY | O_CLOEXEC);
+    if(file != -1) {
+        struct stat fileStatus = {};
+        if((fstat(file, &fileStatus) == 0) && (fileStatus.st_size > 0)
+           && (static_cast<FileSize>(fileStatus.st_size) <= SIZE_MAX)) {
+            void* mapping = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if(mapping != MAP_FAILED) {
+                madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+                data     = reinterpret_cast<const uint8_t*>(mapping);
+                fileSize = fileStatus.st_size;
+            }
+        }
+
+        // The mapping stays valid after the descriptor has been closed
+        close(file);
+    }
+
+    return data;
+}
+
+void PlatformGateway::UnmapFile(const uint8_t* data, const size_t dataSize)
+{
+    PRECONDITION(data != nullptr);
+
+    munmap(const_cast<uint8_t*>(data), dataSize);
+}
+
+bool PlatformGateway::QueryDirectoryEntries(const UnicodeString& directory, DirectoryEntryArray& entries)
+{
+    PRECONDITION_RETURN(directory.empty() == false, false);
+
+    bool success = false;
+    entries.clear();
+
+    DIR* pDirectory = opendir(U2H(directory).c_str());
+    if(pDirectory != nullptr) {
+        const int directoryFile = dirfd(pDirectory);
+        for(struct dirent* pEntry = readdir(pDirectory); pEntry != nullptr; pEntry = readdir(pDirectory)) {
+            if((pEntry->d_type == DT_REG) || (pEntry->d_type == DT_LNK) || (pEntry->d_type == DT_UNKNOWN)) {
+                struct stat fileStatus = {};
+                if((fstatat(directoryFile, pEntry->d_name, &fileStatus, 0) == 0) && S_ISREG(fileStatus.st_mode)) {
+                    DirectoryEntry entry;
+                    entry.name                 = H2U(pEntry->d_name);
+                    entry.size                 = fileStatus.st_size;
+                    const uint64_t seconds     = fileStatus.st_mtim.tv_sec;
+                    const uint64_t nanoseconds = fileStatus.st_mtim.tv_nsec;
+                    entry.modificationTime     = (seconds * 1000000000) + nanoseconds;
+                    entries.push_back(entry);
+                }
+            }
+        }
+
+        closedir(pDirectory);
+        success = true;
+    }
+
+    return success;
+}
+
+bool PlatformGateway::QueryCaseSensitiveFileNames()
+{
+    return true;
+}
+
+static int QueryNotificationInstance()
+{
+    static const int instance = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    return instance;
+}
+
+// inotify only reports changes made through the local kernel, changes made by other clients of a network or FUSE
+// file system go unnoticed.
+static bool IsRemoteFileSystem(const UnicodeString& directory)
+{
+    static const uint32_t REMOTE_FILE_SYSTEMS[] = {
+        0x6969,     // NFS
+        0x517b,     // SMB
+        0xff534d42, // CIFS
+        0xfe534d42, // SMB2
+        0x65735546, // FUSE
+        0x00c36400, // Ceph
+        0x73757245, // Coda
+        0x5346414f, // AFS
+        0x6b414653, // kAFS
+        0x01021997  // 9P
+    };
+
+    struct statfs fileSystemStatus = {};
+    PRECONDITION_RETURN(statfs(U2H(directory).c_str(), &fileSystemStatus) == 0, true);
+
+    const uint32_t fileSystemType = static_cast<uint32_t>(fileSystemStatus.f_type);
+    return std::find(std::begin(REMOTE_FILE_SYSTEMS), std::end(REMOTE_FILE_SYSTEMS), fileSystemType)
+           != std::end(REMOTE_FILE_SYSTEMS);
+}
+
+int64_t PlatformGateway::WatchDirectory(const UnicodeString& directory)
 {
     PRECONDITION_RETURN(directory.empty() == false, -1);
+    PRECONDITION_RETURN(IsRemoteFileSystem(directory) == false, -1);
+
+    const int instance = QueryNotificationInstance();
+    PRECONDITION_RETURN(instance != -1, -1);
+
+    static const uint32_t WATCHED_EVENTS = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF
+                                           | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    return inotify_add_watch(instance, U2H(directory).c_str(), WATCHED_EVENTS);
+}
 
-    size_t availableSpace = -1;
+void PlatformGateway::UnwatchDirectory(const int64_t watch)
+{
+    PRECONDITION(watch != -1);
+
+    const int instance = QueryNotificationInstance();
+    PRECONDITION(instance != -1);
 
-    struct statvfs fsi    = {0};
-    const int      status = statvfs(directory.c_str(), &fsi);
-    if(status == 0) {
-        availableSpace = fsi.f_bavail * fsi.f_frsize;
+    inotify_rm_watch(instance, static_cast<int>(watch));
+}
+
+std::vector<int64_t> PlatformGateway::QueryChangedDirectories()
+{
+    std::vector<int64_t> watches;
+
+    const int instance = QueryNotificationInstance();
+    PRECONDITION_RETURN(instance != -1, watches);
+
+    alignas(struct inotify_event) uint8_t buffer[4096];
+    for(ssize_t bytesRead = read(instance, buffer, sizeof(buffer)); bytesRead > 0;
+        bytesRead         = read(instance, buffer, sizeof(buffer))) {
+        for(ssize_t offset = 0; offset < bytesRead;) {
+            const struct inotify_event* pEvent = reinterpret_cast<const struct inotify_event*>(&buffer[offset]);
+            watches.push_back(((pEvent->mask & IN_Q_OVERFLOW) != 0) ? -1 : pEvent->wd);
+            offset += sizeof(struct inotify_event) + pEvent->len;
+        }
     }
 
-    return availableSpace;
+    return watches;
 }
 
 UnicodeString PlatformGateway::SelectChaptersFile(
@@ -76,7 +463,8 @@ UnicodeString PlatformGateway::SelectChaptersFile(
         pInitialFile = U2H(initialFile).c_str();
     }
 
-    const char* pFileExtensions = "MP4 chapters\0*.chapters.txt\0All files\0*.*\0\0";
+    const char* pFileExtensions = "Chapter files\0*.chapters.txt;*.mp4chaps;*.psc;*.xml;*.json;*.vtt;*.cue\0"
+                                  "MP3 files\0*.mp3\0All files\0*.*\0\0";
     char*       pSelected       = BrowseForFiles(pCaption, pInitialDirectory, pInitialFile, false, pFileExtensions);
     if(pSelected != 0) {
         result = H2U(pSelected);
@@ -163,7 +551,9 @@ UnicodeString PlatformGateway::SelectChaptersFileName(
         pInitialFile = U2H(initialFile).c_str();
     }
 
-    const char* pFileExtensions = "MP4 chapters\0*.chapters.txt\0All files\0*.*\0\0";
+    const char* pFileExtensions = "MP4 chapters\0*.chapters.txt\0Podlove Simple Chapters\0*.psc\0"
+                                  "JSON chapters\0*.json\0WebVTT chapters\0*.vtt\0CUE sheets\0*.cue\0"
+                                  "All files\0*.*\0\0";
     char        selected[4096]  = {0};
     if(BrowseForSaveFile(pCaption, pInitialDirectory, pInitialFile, pFileExtensions, selected, 4096)) {
         UnicodeString selectedFile = selected;
@@ -32,7 +32,13 @@
 #import <AppKit/AppKit.h>
 #import <Foundation/Foundation.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <unistd.h>
 
 #include "PlatformGateway.h"
 
@@ -52,19 +58,295 @@ UnicodeChar PlatformGateway::QueryPathSeparator()
     return '/';
 }
 
-size_t PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory)
+ServiceStatus PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory, FileSize& availableSpace)
 {
-    PRECONDITION_RETURN(directory.empty() == false, -1);
+    PRECONDITION_RETURN(directory.empty() == false, SERVICE_INVALID_ARGUMENT);
 
-    size_t availableSpace = -1;
+    ServiceStatus status = SERVICE_NOT_FOUND;
 
-    struct statvfs fsi    = {0};
-    const int      status = statvfs(directory.c_str(), &fsi);
-    if(status == 0) {
-        availableSpace = fsi.f_bavail * fsi.f_frsize;
+    struct statvfs fsi = {0};
+    if(statvfs(U2H(directory).c_str(), &fsi) == 0) {
+        availableSpace = static_cast<FileSize>(fsi.f_bavail) * fsi.f_frsize;
+        status         = SERVICE_SUCCESS;
     }
 
-    return availableSpace;
+    return status;
+}
+
+uint64_t PlatformGateway::QueryFileModificationTime(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, -1);
+
+    uint64_t modificationTime = -1;
+
+    struct stat fileStatus = {0};
+    if(stat(U2H(filename).c_str(), &fileStatus) == 0) {
+        const uint64_t seconds     = fileStatus.st_mtimespec.tv_sec;
+        const uint64_t nanoseconds = fileStatus.st_mtimespec.tv_nsec;
+        modificationTime           = (seconds * 1000000000) + nanoseconds;
+    }
+
+    return modificationTime;
+}
+
+bool PlatformGateway::QueryFileIdentity(const UnicodeString& filename, FileIdentity& identity)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+
+    bool success = false;
+
+    struct stat fileStatus = {0};
+    if(stat(U2H(filename).c_str(), &fileStatus) == 0) {
+        const uint64_t seconds     = fileStatus.st_mtimespec.tv_sec;
+        const uint64_t nanoseconds = fileStatus.st_mtimespec.tv_nsec;
+        identity.fileId            = fileStatus.st_ino;
+        identity.size              = fileStatus.st_size;
+        identity.modificationTime  = (seconds * 1000000000) + nanoseconds;
+        success                    = true;
+    }
+
+    return success;
+}
+
+bool PlatformGateway::AppendFileData(
+    const UnicodeString& targetName, const UnicodeString& sourceName, const FileOffset sourceOffset)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+
+    bool success = false;
+
+    const int sourceFile = open(U2H(sourceName).c_str(), O_RDONLY | O_CLOEXEC);
+    if(sourceFile != -1) {
+        const int targetFile = open(U2H(targetName).c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(targetFile != -1) {
+            struct stat sourceStatus = {0};
+            if((fstat(sourceFile, &sourceStatus) == 0)
+               && (static_cast<FileOffset>(sourceStatus.st_size) >= sourceOffset)) {
+                // There is no offset based kernel copy on macOS, copy in large chunks and let the
+                // unified buffer cache do the rest.
+                static const size_t  MAX_COPY_CHUNK_SIZE = 1024 * 1024;
+                off_t                inputOffset         = sourceOffset;
+                FileSize             remaining           = sourceStatus.st_size - sourceOffset;
+                std::vector<uint8_t> buffer(static_cast<size_t>(std::min<FileSize>(remaining, MAX_COPY_CHUNK_SIZE)));
+
+                success = true;
+                while((remaining > 0) && (true == success)) {
+                    const size_t  chunkSize = static_cast<size_t>(std::min<FileSize>(remaining, buffer.size()));
+                    const ssize_t bytesRead = pread(sourceFile, buffer.data(), chunkSize, inputOffset);
+                    if(bytesRead > 0) {
+                        ssize_t bytesWritten = 0;
+                        while((bytesWritten < bytesRead) && (true == success)) {
+                            const ssize_t result = write(targetFile, &buffer[bytesWritten], bytesRead - bytesWritten);
+                            if(result > 0) {
+                                bytesWritten += result;
+                            }
+                            else if((result < 0) && (errno != EINTR)) {
+                                success = false;
+                            }
+                        }
+
+                        inputOffset += bytesRead;
+                        remaining -= bytesRead;
+                    }
+                    else if((bytesRead == 0) || (errno != EINTR)) {
+                        success = false;
+                    }
+                }
+
+                // fsync does not flush the drive cache on macOS.
+                success = success && ((fcntl(targetFile, F_FULLFSYNC) != -1) || (fsync(targetFile) == 0));
+            }
+
+            close(targetFile);
+        }
+
+        close(sourceFile);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::RenameFile(const UnicodeString& sourceName, const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    bool success = false;
+
+    const std::string source = U2H(sourceName);
+    const std::string target = U2H(targetName);
+
+    // Keep the permissions of the file that is replaced.
+    struct stat targetStatus = {0};
+    if(stat(target.c_str(), &targetStatus) == 0) {
+        chmod(source.c_str(), targetStatus.st_mode & 07777);
+    }
+
+    if(rename(source.c_str(), target.c_str()) == 0) {
+        success = true;
+
+        std::vector<char> directoryName(target.begin(), target.end());
+        directoryName.push_back(0);
+        const int directory = open(dirname(directoryName.data()), O_RDONLY | O_CLOEXEC);
+        if(directory != -1) {
+            fsync(directory);
+            close(directory);
+        }
+    }
+
+    return success;
+}
+
+bool PlatformGateway::ReplaceFileTail(
+    const UnicodeString& filename, const FileSize expectedSize, const FileOffset offset,
+    const FileSegmentArray& segments)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(offset <= expectedSize, false);
+
+    bool success = false;
+
+    const int file = open(U2H(filename).c_str(), O_RDWR | O_CLOEXEC);
+    if(file != -1) {
+        struct stat fileStatus = {};
+        if((fstat(file, &fileStatus) == 0) && (static_cast<FileSize>(fileStatus.st_size) == expectedSize)) {
+            FileOffset position = offset;
+            success             = true;
+            for(size_t i = 0; (i < segments.size()) && (true == success); i++) {
+                const FileSegment& segment      = segments[i];
+                size_t             bytesWritten = 0;
+                while((bytesWritten < segment.dataSize) && (true == success)) {
+                    const ssize_t result = pwrite(
+                        file, &segment.data[bytesWritten], segment.dataSize - bytesWritten, position + bytesWritten);
+                    if(result > 0) {
+                        bytesWritten += result;
+                    }
+                    else if((result == 0) || (errno != EINTR)) {
+                        success = false;
+                    }
+                }
+
+                position += bytesWritten;
+            }
+
+            const FileSize fileSize = position;
+            if((true == success) && (fileSize < expectedSize)) {
+                success = (ftruncate(file, static_cast<off_t>(fileSize)) == 0);
+            }
+
+            success = success && ((fcntl(file, F_FULLFSYNC) != -1) || (fsync(file) == 0));
+        }
+
+        close(file);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::SyncFile(const UnicodeString& filename, const FILE_SYNC_POLICY policy)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(policy != FILE_SYNC_POLICY::NONE, true);
+
+    bool success = false;
+
+    const int file = open(U2H(filename).c_str(), O_WRONLY | O_CLOEXEC);
+    if(file != -1) {
+        // fsync does not flush the drive cache on macOS.
+        if(policy == FILE_SYNC_POLICY::FULL) {
+            success = (fcntl(file, F_FULLFSYNC) != -1) || (fsync(file) == 0);
+        }
+        else {
+            success = (fsync(file) == 0);
+        }
+
+        close(file);
+    }
+
+    return success;
+}
+
+const uint8_t* PlatformGateway::MapFile(const UnicodeString& filename, size_t& fileSize)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    const uint8_t* data = nullptr;
+    fileSize            = 0;
+
+    const int file = open(U2H(filename).c_str(), O_RDONLY | O_CLOEXEC);
+    if(file != -1) {
+        struct stat fileStatus = {0};
+        if((fstat(file, &fileStatus) == 0) && (fileStatus.st_size > 0)) {
+            void* mapping = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if(mapping != MAP_FAILED) {
+                madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+                data     = reinterpret_cast<const uint8_t*>(mapping);
+                fileSize = fileStatus.st_size;
+            }
+        }
+
+        // The mapping stays valid after the descriptor has been closed
+        close(file);
+    }
+
+    return data;
+}
+
+void PlatformGateway::UnmapFile(const uint8_t* data, const size_t dataSize)
+{
+    PRECONDITION(data != nullptr);
+
+    munmap(const_cast<uint8_t*>(data), dataSize);
+}
+
+bool PlatformGateway::QueryDirectoryEntries(const UnicodeString& directory, DirectoryEntryArray& entries)
+{
+    PRECONDITION_RETURN(directory.empty() == false, false);
+
+    bool success = false;
+    entries.clear();
+
+    DIR* pDirectory = opendir(U2H(directory).c_str());
+    if(pDirectory != nullptr) {
+        const int directoryFile = dirfd(pDirectory);
+        for(struct dirent* pEntry = readdir(pDirectory); pEntry != nullptr; pEntry = readdir(pDirectory)) {
+            if((pEntry->d_type == DT_REG) || (pEntry->d_type == DT_LNK) || (pEntry->d_type == DT_UNKNOWN)) {
+                struct stat fileStatus = {0};
+                if((fstatat(directoryFile, pEntry->d_name, &fileStatus, 0) == 0) && S_ISREG(fileStatus.st_mode)) {
+                    DirectoryEntry entry;
+                    entry.name                 = H2U(pEntry->d_name);
+                    entry.size                 = fileStatus.st_size;
+                    const uint64_t seconds     = fileStatus.st_mtimespec.tv_sec;
+                    const uint64_t nanoseconds = fileStatus.st_mtimespec.tv_nsec;
+                    entry.modificationTime     = (seconds * 1000000000) + nanoseconds;
+                    entries.push_back(entry);
+                }
+            }
+        }
+
+        closedir(pDirectory);
+        success = true;
+    }
+
+    return success;
+}
+
+bool PlatformGateway::QueryCaseSensitiveFileNames()
+{
+    return false;
+}
+
+int64_t PlatformGateway::WatchDirectory(const UnicodeString&)
+{
+    return -1;
+}
+
+void PlatformGateway::UnwatchDirectory(const int64_t) {}
+
+std::vector<int64_t> PlatformGateway::QueryChangedDirectories()
+{
+    return std::vector<int64_t>();
 }
 
 UnicodeString PlatformGateway::SelectChaptersFile(
@@ -79,10 +361,11 @@ UnicodeString PlatformGateway::SelectChaptersFile(
         fileDialog.canCreateDirectories    = NO;
         fileDialog.allowsMultipleSelection = NO;
         fileDialog.title                   = [NSString stringWithUTF8String:dialogCaption.c_str()];
+        NSArray* fileTypes = [[NSArray alloc] initWithObjects:@"chapters.txt", @"mp4chaps", @"txt", @"psc", @"xml",
+                                                              @"json", @"vtt", @"cue", @"mp3", nil];
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-        if([fileDialog runModalForTypes:[[NSArray alloc] initWithObjects:@"chapters.txt", @"mp4chaps", @"txt", nil]] ==
-           NSFileHandlingPanelOKButton)
+        if([fileDialog runModalForTypes:fileTypes] == NSFileHandlingPanelOKButton)
 #pragma clang diagnostic pop
         {
             result = [[fileDialog URL] fileSystemRepresentation];
@@ -154,7 +437,8 @@ UnicodeString PlatformGateway::SelectChaptersFileName(
 
     NSSavePanel* fileDialog = [NSSavePanel savePanel];
     if(nil != fileDialog) {
-        fileDialog.allowedFileTypes     = [[NSArray alloc] initWithObjects:@"chapters.txt", @"mp4chaps", @"txt", nil];
+        fileDialog.allowedFileTypes     = [[NSArray alloc]
+            initWithObjects:@"chapters.txt", @"mp4chaps", @"txt", @"psc", @"json", @"vtt", @"cue", nil];
         fileDialog.allowsOtherFileTypes = NO;
         fileDialog.canCreateDirectories = YES;
         fileDialog.title                = [NSString stringWithUTF8String:dialogCaption.c_str()];
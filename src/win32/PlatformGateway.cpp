@@ -57,24 +57,330 @@ UnicodeChar PlatformGateway::QueryPathSeparator()
     return '\\';
 }
 
-size_t PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory)
+ServiceStatus PlatformGateway::QueryAvailableDiskSpace(const UnicodeString& directory, FileSize& availableSpace)
 {
-    PRECONDITION_RETURN(directory.empty() == false, -1);
+    PRECONDITION_RETURN(directory.empty() == false, SERVICE_INVALID_ARGUMENT);
 
-    size_t         availableSpace           = -1;
+    ServiceStatus  status                   = SERVICE_NOT_FOUND;
     ULARGE_INTEGER freeBytesAvailableToUser = {0};
     if(GetDiskFreeSpaceEx(U2H(directory).c_str(), &freeBytesAvailableToUser, nullptr, nullptr) != FALSE)
     {
         availableSpace = freeBytesAvailableToUser.QuadPart;
+        status         = SERVICE_SUCCESS;
     }
 
-    return availableSpace;
+    return status;
+}
+
+uint64_t PlatformGateway::QueryFileModificationTime(const UnicodeString& filename)
+{
+    PRECONDITION_RETURN(filename.empty() == false, -1);
+
+    uint64_t modificationTime = -1;
+
+    WIN32_FILE_ATTRIBUTE_DATA fileAttributes = {0};
+    if(GetFileAttributesExW(reinterpret_cast<LPCWSTR>(U2WU(filename).c_str()), GetFileExInfoStandard, &fileAttributes)
+       != FALSE)
+    {
+        ULARGE_INTEGER lastWriteTime;
+        lastWriteTime.LowPart  = fileAttributes.ftLastWriteTime.dwLowDateTime;
+        lastWriteTime.HighPart = fileAttributes.ftLastWriteTime.dwHighDateTime;
+        modificationTime       = lastWriteTime.QuadPart;
+    }
+
+    return modificationTime;
+}
+
+bool PlatformGateway::QueryFileIdentity(const UnicodeString& filename, FileIdentity& identity)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+
+    bool success = false;
+
+    HANDLE file = CreateFileW(
+        reinterpret_cast<LPCWSTR>(U2WU(filename).c_str()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        BY_HANDLE_FILE_INFORMATION fileInformation = {0};
+        if(GetFileInformationByHandle(file, &fileInformation) != FALSE)
+        {
+            ULARGE_INTEGER fileId;
+            fileId.LowPart  = fileInformation.nFileIndexLow;
+            fileId.HighPart = fileInformation.nFileIndexHigh;
+
+            ULARGE_INTEGER fileSize;
+            fileSize.LowPart  = fileInformation.nFileSizeLow;
+            fileSize.HighPart = fileInformation.nFileSizeHigh;
+
+            ULARGE_INTEGER lastWriteTime;
+            lastWriteTime.LowPart  = fileInformation.ftLastWriteTime.dwLowDateTime;
+            lastWriteTime.HighPart = fileInformation.ftLastWriteTime.dwHighDateTime;
+
+            identity.fileId           = fileId.QuadPart;
+            identity.size             = fileSize.QuadPart;
+            identity.modificationTime = lastWriteTime.QuadPart;
+            success                   = true;
+        }
+
+        CloseHandle(file);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::AppendFileData(
+    const UnicodeString& targetName, const UnicodeString& sourceName, const FileOffset sourceOffset)
+{
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+
+    bool success = false;
+
+    HANDLE sourceFile = CreateFileW(
+        reinterpret_cast<LPCWSTR>(U2WU(sourceName).c_str()), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(sourceFile != INVALID_HANDLE_VALUE)
+    {
+        HANDLE targetFile = CreateFileW(
+            reinterpret_cast<LPCWSTR>(U2WU(targetName).c_str()), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if(targetFile != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER sourceSize   = {0};
+            LARGE_INTEGER inputOffset  = {0};
+            LARGE_INTEGER outputOffset = {0};
+            inputOffset.QuadPart       = sourceOffset;
+            if((GetFileSizeEx(sourceFile, &sourceSize) != FALSE)
+               && (static_cast<FileOffset>(sourceSize.QuadPart) >= sourceOffset)
+               && (SetFilePointerEx(sourceFile, inputOffset, nullptr, FILE_BEGIN) != FALSE)
+               && (SetFilePointerEx(targetFile, outputOffset, nullptr, FILE_END) != FALSE))
+            {
+                static const size_t  MAX_COPY_CHUNK_SIZE = 1024 * 1024;
+                FileSize             remaining           = static_cast<FileSize>(sourceSize.QuadPart) - sourceOffset;
+                std::vector<uint8_t> buffer(static_cast<size_t>(std::min<FileSize>(remaining, MAX_COPY_CHUNK_SIZE)));
+
+                success = true;
+                while((remaining > 0) && (true == success))
+                {
+                    const DWORD chunkSize = static_cast<DWORD>(std::min<FileSize>(remaining, buffer.size()));
+                    DWORD       bytesRead = 0;
+                    success = (ReadFile(sourceFile, buffer.data(), chunkSize, &bytesRead, nullptr) != FALSE)
+                              && (bytesRead == chunkSize);
+                    if(true == success)
+                    {
+                        DWORD bytesWritten = 0;
+                        success = (WriteFile(targetFile, buffer.data(), bytesRead, &bytesWritten, nullptr) != FALSE)
+                                  && (bytesWritten == bytesRead);
+                    }
+
+                    remaining -= chunkSize;
+                }
+
+                success = success && (FlushFileBuffers(targetFile) != FALSE);
+            }
+
+            CloseHandle(targetFile);
+        }
+
+        CloseHandle(sourceFile);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::RenameFile(const UnicodeString& sourceName, const UnicodeString& targetName)
+{
+    PRECONDITION_RETURN(sourceName.empty() == false, false);
+    PRECONDITION_RETURN(targetName.empty() == false, false);
+
+    return MoveFileExW(
+               reinterpret_cast<LPCWSTR>(U2WU(sourceName).c_str()), reinterpret_cast<LPCWSTR>(U2WU(targetName).c_str()),
+               MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)
+           != FALSE;
+}
+
+bool PlatformGateway::ReplaceFileTail(
+    const UnicodeString& filename, const FileSize expectedSize, const FileOffset offset,
+    const FileSegmentArray& segments)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(offset <= expectedSize, false);
+
+    bool success = false;
+
+    HANDLE file = CreateFileW(
+        reinterpret_cast<LPCWSTR>(U2WU(filename).c_str()), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize   = {0};
+        LARGE_INTEGER fileOffset = {0};
+        fileOffset.QuadPart      = static_cast<LONGLONG>(offset);
+        if((GetFileSizeEx(file, &fileSize) != FALSE) && (static_cast<FileSize>(fileSize.QuadPart) == expectedSize)
+           && (SetFilePointerEx(file, fileOffset, nullptr, FILE_BEGIN) != FALSE))
+        {
+            static const size_t MAX_WRITE_CHUNK_SIZE = 1024 * 1024;
+
+            FileOffset position = offset;
+            success             = true;
+            for(size_t i = 0; (i < segments.size()) && (true == success); i++)
+            {
+                const FileSegment& segment      = segments[i];
+                size_t             bytesWritten = 0;
+                while((bytesWritten < segment.dataSize) && (true == success))
+                {
+                    const DWORD chunkSize
+                        = static_cast<DWORD>(std::min(segment.dataSize - bytesWritten, MAX_WRITE_CHUNK_SIZE));
+                    DWORD chunkWritten = 0;
+                    success = (WriteFile(file, &segment.data[bytesWritten], chunkSize, &chunkWritten, nullptr) != FALSE)
+                              && (chunkWritten == chunkSize);
+                    bytesWritten += chunkWritten;
+                }
+
+                position += bytesWritten;
+            }
+
+            if((true == success) && (position < expectedSize))
+            {
+                success = (SetEndOfFile(file) != FALSE);
+            }
+
+            success = success && (FlushFileBuffers(file) != FALSE);
+        }
+
+        CloseHandle(file);
+    }
+
+    return success;
+}
+
+bool PlatformGateway::SyncFile(const UnicodeString& filename, const FILE_SYNC_POLICY policy)
+{
+    PRECONDITION_RETURN(filename.empty() == false, false);
+    PRECONDITION_RETURN(policy != FILE_SYNC_POLICY::NONE, true);
+
+    bool success = false;
+
+    // Windows doesn't distinguish between flushing the data and flushing the metadata.
+    HANDLE file = CreateFileW(
+        reinterpret_cast<LPCWSTR>(U2WU(filename).c_str()), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        success = (FlushFileBuffers(file) != FALSE);
+        CloseHandle(file);
+    }
+
+    return success;
+}
+
+const uint8_t* PlatformGateway::MapFile(const UnicodeString& filename, size_t& fileSize)
+{
+    PRECONDITION_RETURN(filename.empty() == false, nullptr);
+
+    const uint8_t* data = nullptr;
+    fileSize            = 0;
+
+    HANDLE file = CreateFileW(
+        reinterpret_cast<LPCWSTR>(U2WU(filename).c_str()), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size = {0};
+        if((GetFileSizeEx(file, &size) != FALSE) && (size.QuadPart > 0)
+           && (static_cast<FileSize>(size.QuadPart) <= SIZE_MAX))
+        {
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(mapping != nullptr)
+            {
+                data = reinterpret_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                if(data != nullptr)
+                {
+                    fileSize = static_cast<size_t>(size.QuadPart);
+                }
+
+                // The view stays valid after both handles have been closed
+                CloseHandle(mapping);
+            }
+        }
+
+        CloseHandle(file);
+    }
+
+    return data;
+}
+
+void PlatformGateway::UnmapFile(const uint8_t* data, const size_t)
+{
+    PRECONDITION(data != nullptr);
+
+    UnmapViewOfFile(data);
+}
+
+bool PlatformGateway::QueryDirectoryEntries(const UnicodeString& directory, DirectoryEntryArray& entries)
+{
+    PRECONDITION_RETURN(directory.empty() == false, false);
+
+    bool success = false;
+    entries.clear();
+
+    WIN32_FIND_DATAW findData = {0};
+    HANDLE           find     = FindFirstFileExW(
+        reinterpret_cast<LPCWSTR>(U2WU(directory + "\\*").c_str()), FindExInfoBasic, &findData,
+        FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if(find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+            {
+                ULARGE_INTEGER fileSize;
+                fileSize.LowPart  = findData.nFileSizeLow;
+                fileSize.HighPart = findData.nFileSizeHigh;
+
+                ULARGE_INTEGER lastWriteTime;
+                lastWriteTime.LowPart  = findData.ftLastWriteTime.dwLowDateTime;
+                lastWriteTime.HighPart = findData.ftLastWriteTime.dwHighDateTime;
+
+                DirectoryEntry entry;
+                entry.name             = WU2U(reinterpret_cast<const WideUnicodeChar*>(findData.cFileName));
+                entry.size             = static_cast<FileSize>(fileSize.QuadPart);
+                entry.modificationTime = lastWriteTime.QuadPart;
+                entries.push_back(entry);
+            }
+        }
+        while(FindNextFileW(find, &findData) != FALSE);
+
+        FindClose(find);
+        success = true;
+    }
+
+    return success;
+}
+
+bool PlatformGateway::QueryCaseSensitiveFileNames()
+{
+    return false;
+}
+
+int64_t PlatformGateway::WatchDirectory(const UnicodeString&)
+{
+    return -1;
+}
+
+void PlatformGateway::UnwatchDirectory(const int64_t) {}
+
+std::vector<int64_t> PlatformGateway::QueryChangedDirectories()
+{
+    return std::vector<int64_t>();
 }
 
 UnicodeString PlatformGateway::SelectChaptersFile(
     const UnicodeString& dialogCaption, const UnicodeString&, const UnicodeString&)
 {
-    static const UnicodeString fileExtensions = "MP4 chapters|*.chapters.txt|All files|*.*";
+    static const UnicodeString fileExtensions
+        = "Chapter files|*.chapters.txt;*.mp4chaps;*.psc;*.xml;*.json;*.vtt;*.cue|MP3 files|*.mp3|All files|*.*";
     WideUnicodeString          result;
 
     UnicodeStringArray     filterSpecs = UnicodeStringTokenize(fileExtensions, UnicodeChar('|'));
@@ -260,7 +566,9 @@ UnicodeString PlatformGateway::SelectPictureFile(
 UnicodeString PlatformGateway::SelectChaptersFileName(
     const UnicodeString& dialogCaption, const UnicodeString& initialDirectory, const UnicodeString& initialFile)
 {
-    static const UnicodeString fileExtensions = "MP4 chapters|*.chapters.txt|All files|*.*";
+    static const UnicodeString fileExtensions = "MP4 chapters|*.chapters.txt|Podlove Simple Chapters|*.psc|"
+                                                "JSON chapters|*.json|WebVTT chapters|*.vtt|CUE sheets|*.cue|"
+                                                "All files|*.*";
     WideUnicodeString          result;
 
     UnicodeStringArray     filterSpecs = UnicodeStringTokenize(fileExtensions, UnicodeChar('|'));